@@ -4,9 +4,12 @@
 
 #include "bench.h"
 
+#include "chainparams.h"
+#include "config.h"
 #include "crypto/sha256.h"
 #include "key.h"
 #include "random.h"
+#include "task_helpers.h"
 #include "util.h"
 #include "validation.h"
 
@@ -15,11 +18,17 @@ int main(int argc, char **argv) {
     RandomInit();
     ECC_Start();
     SetupEnvironment();
+    // Benchmarks such as the block checks run on main network data
+    SelectParams(CBaseChainParams::MAIN);
+    GlobalConfig::GetConfig().SetDefaultBlockSizeParams(
+        Params().GetDefaultBlockSizeParams());
+    InitParallelTaskPool(GetNumCores());
 
     // don't want to write to bitcoind.log file
     GetLogger().fPrintToDebugLog = false;
 
     benchmark::BenchRunner::RunAll();
 
+    ShutdownParallelTaskPool();
     ECC_Stop();
 }
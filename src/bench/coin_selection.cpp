@@ -4,6 +4,9 @@
 
 #include "bench.h"
 #include "chainparams.h"
+#include "key.h"
+#include "script/standard.h"
+#include "validation.h"
 #include "wallet/wallet.h"
 
 #include <set>
@@ -62,4 +65,96 @@ static void CoinSelection(benchmark::State &state) {
     }
 }
 
+namespace {
+
+// A long-lived wallet: a chain of payments where each transaction spends the
+// change of the one before it, with only every LARGE_WALLET_UNSPENT_EVERY-th
+// transaction leaving a further output of ours unspent. All of it is
+// confirmed in a single block at the tip of an otherwise empty chain.
+constexpr int LARGE_WALLET_TXS = 20000;
+constexpr int LARGE_WALLET_UNSPENT_EVERY = 50;
+
+struct LargeWallet {
+    CWallet wallet {Params()};
+    uint256 blockHash;
+    CBlockIndex block;
+
+    LargeWallet() {
+        blockHash = GetRandHash();
+        block.phashBlock = &blockHash;
+        mapBlockIndex.emplace(blockHash, &block);
+        chainActive.SetTip(&block);
+
+        CKey key;
+        key.MakeNewKey(true);
+        LOCK2(cs_main, wallet.cs_wallet);
+        wallet.AddKeyPubKey(key, key.GetPubKey());
+        const CScript ours {GetScriptForDestination(key.GetPubKey().GetID())};
+        const CScript theirs {CScript() << OP_TRUE};
+
+        uint256 prevId;
+        for (int i = 0; i < LARGE_WALLET_TXS; i++) {
+            CMutableTransaction tx;
+            if (i > 0) {
+                tx.vin.emplace_back(COutPoint(prevId, 0));
+            }
+            tx.vout.emplace_back(1000 * COIN, ours);
+            tx.vout.emplace_back(COIN, theirs);
+            if (i % LARGE_WALLET_UNSPENT_EVERY == 0) {
+                tx.vout.emplace_back(COIN, ours);
+            }
+
+            CWalletTx wtx(&wallet, MakeTransactionRef(std::move(tx)));
+            wtx.SetMerkleBranch(&block, i);
+            wallet.AddToWallet(wtx);
+            prevId = wtx.GetId();
+        }
+    }
+
+    ~LargeWallet() {
+        chainActive.SetTip(nullptr);
+        mapBlockIndex.erase(blockHash);
+    }
+};
+
+} // namespace
+
+// Coin selection in a wallet with a long history, most of it spent
+static void CoinSelectionLargeWallet(benchmark::State &state) {
+    SelectParams(CBaseChainParams::TESTNET);
+    LargeWallet largeWallet;
+    const CWallet &wallet = largeWallet.wallet;
+
+    while (state.KeepRunning()) {
+        std::vector<COutput> vCoins;
+        wallet.AvailableCoins(vCoins);
+        assert(vCoins.size() ==
+               LARGE_WALLET_TXS / LARGE_WALLET_UNSPENT_EVERY + 1);
+
+        LOCK(wallet.cs_wallet);
+        std::set<std::pair<const CWalletTx *, unsigned int>> setCoinsRet;
+        Amount nValueRet;
+        bool success = wallet.SelectCoinsMinConf(3 * COIN, 1, 6, 0, vCoins,
+                                                 setCoinsRet, nValueRet);
+        assert(success);
+        assert(nValueRet == 3 * COIN);
+    }
+}
+
+// Balance of a wallet with a long history, most of it spent
+static void GetBalanceLargeWallet(benchmark::State &state) {
+    SelectParams(CBaseChainParams::TESTNET);
+    LargeWallet largeWallet;
+    const CWallet &wallet = largeWallet.wallet;
+
+    while (state.KeepRunning()) {
+        Amount balance = wallet.GetBalance();
+        assert(balance ==
+               1000 * COIN +
+                   (LARGE_WALLET_TXS / LARGE_WALLET_UNSPENT_EVERY) * COIN);
+    }
+}
+
 BENCHMARK(CoinSelection);
+BENCHMARK(CoinSelectionLargeWallet);
+BENCHMARK(GetBalanceLargeWallet);
@@ -0,0 +1,78 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "bench.h"
+
+#include "blockencodings.h"
+#include "chainparams.h"
+#include "config.h"
+#include "mining/journal_change_set.h"
+#include "txmempool.h"
+
+#include <vector>
+
+namespace
+{
+    mining::CJournalChangeSetPtr nullChangeSet {nullptr};
+
+    // Number of transactions in the mempool the block is reconstructed from.
+    constexpr size_t MEMPOOL_TXNS = 2000000;
+    // Number of (non-coinbase) transactions in the compact block; all of them
+    // are found in the mempool.
+    constexpr size_t BLOCK_TXNS = 100000;
+
+    CTransactionRef MakeUniqueTx(uint32_t n)
+    {
+        CMutableTransaction tx {};
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(uint256(), n);
+        tx.vin[0].scriptSig = CScript() << OP_1;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+        tx.vout[0].nValue = Amount(1000);
+        return MakeTransactionRef(tx);
+    }
+}
+
+// Reconstruct a large compact block against a large mempool. This is dominated
+// by computing the short IDs of all mempool transactions.
+static void CompactBlockReconstruction(benchmark::State &state) {
+    GlobalConfig config {};
+    config.SetDefaultBlockSizeParams(
+        DefaultBlockSizeParams{0, 1000000000, 1000000000, 1000000000, 1000000000});
+
+    CTxMemPool pool {};
+    CBlock block {};
+    // A null header is rejected before any short IDs are looked at.
+    block.nBits = 0x207fffff;
+    block.vtx.reserve(BLOCK_TXNS + 1);
+    CMutableTransaction coinbase {};
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    block.vtx.emplace_back(MakeTransactionRef(coinbase));
+
+    // Spread the block transactions evenly through the mempool.
+    const size_t blockTxnStride { MEMPOOL_TXNS / BLOCK_TXNS };
+    for (size_t i = 0; i < MEMPOOL_TXNS; ++i) {
+        CTransactionRef tx { MakeUniqueTx(static_cast<uint32_t>(i)) };
+        LockPoints lp;
+        pool.AddUnchecked(tx->GetId(),
+                          CTxMemPoolEntry(tx, Amount(1000), 0, 10.0, 1,
+                                          tx->GetValueOut(), false, 1, lp),
+                          nullChangeSet);
+        if (i % blockTxnStride == 0 && block.vtx.size() <= BLOCK_TXNS) {
+            block.vtx.emplace_back(std::move(tx));
+        }
+    }
+
+    const CBlockHeaderAndShortTxIDs cmpctblock { block };
+    const std::vector<std::pair<uint256, CTransactionRef>> extraTxns {};
+
+    while (state.KeepRunning()) {
+        PartiallyDownloadedBlock partialBlock { config, &pool };
+        ReadStatus status { partialBlock.InitData(cmpctblock, extraTxns) };
+        assert(status == READ_STATUS_OK);
+    }
+}
+
+BENCHMARK(CompactBlockReconstruction);
@@ -0,0 +1,81 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "bench.h"
+#include "dbwrapper.h"
+#include "fs.h"
+#include "random.h"
+#include "uint256.h"
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr size_t DB_CACHE_SIZE = 4 << 20;
+constexpr int INITIAL_COINS = 200000;
+constexpr int SPENT_PER_BLOCK = 200;
+constexpr int CREATED_PER_BLOCK = 400;
+constexpr int MISSES_PER_BLOCK = 400;
+
+// Keys and values shaped like those of the coins database
+using CoinKey = std::pair<char, std::pair<uint256, uint32_t>>;
+CoinKey MakeCoinKey(const uint256 &txid, uint32_t n) {
+    return {'C', {txid, n}};
+}
+const std::vector<uint8_t> COIN_VALUE(40, 0x5a);
+
+// What connecting a block does to the coins database: look up the coins it
+// spends, check that the coins it creates don't exist yet, then write one
+// batch that erases the former and adds the latter.
+void ReplayCoinsWorkload(benchmark::State &state, const CDBTuning &tuning) {
+    FastRandomContext rand {true};
+    CDBWrapper db {fs::temp_directory_path() / fs::unique_path(),
+                   DB_CACHE_SIZE, true, false, true, tuning};
+
+    std::vector<uint256> unspent;
+    CDBBatch initial {db};
+    for (int i = 0; i < INITIAL_COINS; ++i) {
+        unspent.push_back(rand.rand256());
+        initial.Write(MakeCoinKey(unspent.back(), 0), COIN_VALUE);
+    }
+    db.WriteBatch(initial);
+    db.CompactRange(MakeCoinKey(uint256(), 0),
+                    MakeCoinKey(uint256S(std::string(64, 'f')), 0));
+
+    std::vector<uint8_t> value;
+    while (state.KeepRunning()) {
+        CDBBatch batch {db};
+        for (int i = 0; i < SPENT_PER_BLOCK; ++i) {
+            std::swap(unspent[rand.randrange(unspent.size())], unspent.back());
+            const CoinKey key {MakeCoinKey(unspent.back(), 0)};
+            bool found = db.Read(key, value);
+            assert(found);
+            batch.Erase(key);
+            unspent.pop_back();
+        }
+        for (int i = 0; i < MISSES_PER_BLOCK; ++i) {
+            bool found = db.Exists(MakeCoinKey(rand.rand256(), 0));
+            assert(!found);
+        }
+        for (int i = 0; i < CREATED_PER_BLOCK; ++i) {
+            unspent.push_back(rand.rand256());
+            batch.Write(MakeCoinKey(unspent.back(), 0), COIN_VALUE);
+        }
+        db.WriteBatch(batch);
+    }
+}
+
+} // namespace
+
+static void CoinsDBReplayDefaultTuning(benchmark::State &state) {
+    ReplayCoinsWorkload(state, CDBTuning());
+}
+
+static void CoinsDBReplayChainstateTuning(benchmark::State &state) {
+    ReplayCoinsWorkload(state, CDBTuning::Chainstate());
+}
+
+BENCHMARK(CoinsDBReplayDefaultTuning);
+BENCHMARK(CoinsDBReplayChainstateTuning);
@@ -6,6 +6,8 @@
 
 #include "bench.h"
 #include "bloom.h"
+#include "crypto/common.h"
+#include "uint256.h"
 
 static void RollingBloom(benchmark::State &state) {
     CRollingBloomFilter filter(120000, 0.000001);
@@ -38,4 +40,27 @@ static void RollingBloom(benchmark::State &state) {
     }
 }
 
+// Inventory-sized batches of txids, as announced to a peer at once
+static void RollingBloomBatch(benchmark::State &state) {
+    constexpr size_t BATCH_SIZE = 100;
+    CRollingBloomFilter filter(120000, 0.000001);
+    std::vector<uint256> batch(BATCH_SIZE);
+    uint32_t count = 0;
+    uint64_t match = 0;
+    while (state.KeepRunning()) {
+        for (uint256 &hash : batch) {
+            count++;
+            WriteLE32(hash.begin(), count);
+        }
+        filter.insert(batch);
+        for (uint256 &hash : batch) {
+            WriteLE32(hash.begin() + 4, count);
+        }
+        for (const uint256 &hash : batch) {
+            match += filter.contains(hash);
+        }
+    }
+}
+
 BENCHMARK(RollingBloom);
+BENCHMARK(RollingBloomBatch);
@@ -0,0 +1,141 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "bench.h"
+#include "key.h"
+#include "primitives/transaction.h"
+#include "pubkey.h"
+#include "random.h"
+#include "script/scriptcache.h"
+#include "script/sigcache.h"
+#include "uint256.h"
+
+#include <cassert>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A block's worth of signatures where a few keys sign most inputs, as with
+// exchange and mining pool payouts. Every message differs, so verifying them
+// once never hits in the signature cache itself.
+struct KeyReuseBlock {
+    struct Input {
+        CPubKey pubkey;
+        uint256 hash;
+        std::vector<uint8_t> vchSig;
+    };
+    std::vector<Input> inputs;
+
+    KeyReuseBlock() {
+        constexpr int KEYS = 4;
+        constexpr int INPUTS = 200;
+        std::vector<CKey> keys(KEYS);
+        for (CKey &key : keys) {
+            key.MakeNewKey(true);
+        }
+        for (int i = 0; i < INPUTS; ++i) {
+            const CKey &key = keys[i % KEYS];
+            Input input {key.GetPubKey(), GetRandHash(), {}};
+            bool signedOk = key.Sign(input.hash, input.vchSig);
+            assert(signedOk);
+            inputs.push_back(std::move(input));
+        }
+    }
+};
+
+constexpr int CACHE_BENCH_THREADS = 4;
+constexpr int CACHE_BENCH_OPS_PER_THREAD = 1000;
+
+// Run func(thread) on CACHE_BENCH_THREADS threads at once
+template <typename Callable> void RunOnThreads(Callable &&func) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < CACHE_BENCH_THREADS; ++t) {
+        threads.emplace_back(func, t);
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace
+
+static void VerifyKeyReuse(benchmark::State &state) {
+    ECCVerifyHandle verifyHandle;
+    const KeyReuseBlock block;
+    while (state.KeepRunning()) {
+        for (const KeyReuseBlock::Input &input : block.inputs) {
+            bool valid = input.pubkey.Verify(input.hash, input.vchSig);
+            assert(valid);
+        }
+    }
+}
+
+static void VerifyKeyReusePubKeyCache(benchmark::State &state) {
+    ECCVerifyHandle verifyHandle;
+    InitSignatureCache();
+    const KeyReuseBlock block;
+    while (state.KeepRunning()) {
+        for (const KeyReuseBlock::Input &input : block.inputs) {
+            bool valid =
+                VerifyWithPubKeyCache(input.pubkey, input.hash, input.vchSig);
+            assert(valid);
+        }
+    }
+}
+
+// Validator threads all finding their signatures in the signature cache
+static void SigCacheParallelLookup(benchmark::State &state) {
+    ECCVerifyHandle verifyHandle;
+    InitSignatureCache();
+    const KeyReuseBlock block;
+    const CTransaction tx {CMutableTransaction()};
+    PrecomputedTransactionData txdata(tx);
+    const CachingTransactionSignatureChecker checker(&tx, 0, Amount(0), true,
+                                                     txdata);
+    for (const KeyReuseBlock::Input &input : block.inputs) {
+        bool valid =
+            checker.VerifySignature(input.vchSig, input.pubkey, input.hash);
+        assert(valid);
+    }
+
+    while (state.KeepRunning()) {
+        RunOnThreads([&](int t) {
+            for (int n = 0; n < CACHE_BENCH_OPS_PER_THREAD; ++n) {
+                const KeyReuseBlock::Input &input =
+                    block.inputs[(t + n) % block.inputs.size()];
+                bool valid = checker.VerifySignature(input.vchSig,
+                                                     input.pubkey, input.hash);
+                assert(valid);
+            }
+        });
+    }
+}
+
+// Validator threads looking up the script execution cache while adding to it
+static void ScriptCacheParallelLookupInsert(benchmark::State &state) {
+    InitScriptExecutionCache();
+    std::vector<uint256> keys(CACHE_BENCH_OPS_PER_THREAD);
+    for (uint256 &key : keys) {
+        key = GetRandHash();
+        AddKeyInScriptCache(key);
+    }
+
+    while (state.KeepRunning()) {
+        RunOnThreads([&](int t) {
+            for (int n = 0; n < CACHE_BENCH_OPS_PER_THREAD; ++n) {
+                const uint256 &key = keys[(t + n) % keys.size()];
+                if (n % 4 == 0) {
+                    AddKeyInScriptCache(key);
+                } else {
+                    IsKeyInScriptCache(key, false);
+                }
+            }
+        });
+    }
+}
+
+BENCHMARK(VerifyKeyReuse);
+BENCHMARK(VerifyKeyReusePubKeyCache);
+BENCHMARK(SigCacheParallelLookup);
+BENCHMARK(ScriptCacheParallelLookupInsert);
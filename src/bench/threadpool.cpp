@@ -0,0 +1,76 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "bench.h"
+#include "task_helpers.h"
+#include "threadpool.h"
+#include "util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int MIN_POOL_THREADS = 2;
+constexpr int SUBMITTER_THREADS = 4;
+constexpr int TASKS_PER_SUBMITTER = 250;
+
+size_t BenchPoolSize() {
+    return static_cast<size_t>(std::max(MIN_POOL_THREADS, GetNumCores()));
+}
+
+// Several threads submitting tiny tasks at once, as the connection and
+// validator pools see from their message handling threads
+template <typename QueueAdaptor>
+void SmallTaskThroughput(benchmark::State &state) {
+    CThreadPool<QueueAdaptor> pool {"BenchPool", BenchPoolSize()};
+    std::atomic<int> counter {0};
+
+    while (state.KeepRunning()) {
+        std::vector<std::thread> submitters;
+        for (int t = 0; t < SUBMITTER_THREADS; ++t) {
+            submitters.emplace_back([&pool, &counter] {
+                std::vector<std::future<void>> results;
+                results.reserve(TASKS_PER_SUBMITTER);
+                for (int n = 0; n < TASKS_PER_SUBMITTER; ++n) {
+                    results.push_back(make_task(pool, [&counter] {
+                        counter.fetch_add(1, std::memory_order_relaxed);
+                    }));
+                }
+                for (auto &result : results) {
+                    result.get();
+                }
+            });
+        }
+        for (std::thread &submitter : submitters) {
+            submitter.join();
+        }
+    }
+}
+
+} // namespace
+
+static void ThreadPoolSmallTasks(benchmark::State &state) {
+    SmallTaskThroughput<CQueueAdaptor>(state);
+}
+
+static void ThreadPoolSmallTasksPrioritised(benchmark::State &state) {
+    SmallTaskThroughput<CPriorityQueueAdaptor>(state);
+}
+
+// Round trip of a single task through an otherwise idle pool: the time for a
+// sleeping worker to pick it up. The maximum over the iterations shows the
+// tail latency.
+static void ThreadPoolTaskLatency(benchmark::State &state) {
+    CThreadPool<CQueueAdaptor> pool {"BenchPool", BenchPoolSize()};
+    while (state.KeepRunning()) {
+        make_task(pool, [] {}).get();
+    }
+}
+
+BENCHMARK(ThreadPoolSmallTasks);
+BENCHMARK(ThreadPoolSmallTasksPrioritised);
+BENCHMARK(ThreadPoolTaskLatency);
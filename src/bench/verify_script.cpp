@@ -0,0 +1,108 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "bench.h"
+#include "key.h"
+#include "primitives/transaction.h"
+#include "pubkey.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "script/script_flags.h"
+#include "script/standard.h"
+
+#include <cassert>
+#include <vector>
+
+static const uint32_t BENCH_SCRIPT_FLAGS =
+    SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC | SCRIPT_VERIFY_DERSIG |
+    SCRIPT_VERIFY_LOW_S | SCRIPT_VERIFY_NULLFAIL | SCRIPT_ENABLE_SIGHASH_FORKID;
+
+// Verify a signed P2PKH input, the most common script on the network.
+static void VerifyScriptP2PKH(benchmark::State &state) {
+    ECCVerifyHandle verifyHandle;
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey {key.GetPubKey()};
+    const CScript scriptPubKey {GetScriptForDestination(pubkey.GetID())};
+    const Amount amount {1000};
+
+    CMutableTransaction txCredit;
+    txCredit.vin.resize(1);
+    txCredit.vin[0].scriptSig = CScript() << OP_0 << OP_0;
+    txCredit.vout.resize(1);
+    txCredit.vout[0].nValue = amount;
+    txCredit.vout[0].scriptPubKey = scriptPubKey;
+
+    CMutableTransaction txSpend;
+    txSpend.vin.resize(1);
+    txSpend.vin[0].prevout = COutPoint(txCredit.GetId(), 0);
+    txSpend.vout.resize(1);
+    txSpend.vout[0].nValue = amount;
+
+    const SigHashType sigHashType {SigHashType().withForkId()};
+    const uint256 sighash {SignatureHash(scriptPubKey, CTransaction(txSpend),
+                                         0, sigHashType, amount)};
+    std::vector<uint8_t> vchSig;
+    bool signedOk = key.Sign(sighash, vchSig);
+    assert(signedOk);
+    vchSig.push_back(uint8_t(sigHashType.getRawSigHashType()));
+    txSpend.vin[0].scriptSig = CScript() << vchSig << ToByteVector(pubkey);
+
+    const CTransaction tx {txSpend};
+    const TransactionSignatureChecker checker {&tx, 0, amount};
+    while (state.KeepRunning()) {
+        ScriptError err;
+        bool success = VerifyScript(tx.vin[0].scriptSig, scriptPubKey,
+                                    BENCH_SCRIPT_FLAGS, checker, &err);
+        assert(success && err == SCRIPT_ERR_OK);
+    }
+}
+
+// Shuffle maximum size elements around the stack: exercises element copies
+// and moves rather than any particular opcode's logic.
+static void EvalScriptLargeData(benchmark::State &state) {
+    const std::vector<uint8_t> data(MAX_SCRIPT_ELEMENT_SIZE, 0x5a);
+    CScript script;
+    for (int i = 0; i < 10; ++i) {
+        script << data;
+    }
+    for (int i = 0; i < 35; ++i) {
+        script << OP_DUP << OP_DROP << OP_2DUP << OP_2DROP << 5 << OP_ROLL
+               << OP_TOALTSTACK << OP_FROMALTSTACK << OP_OVER << OP_SWAP
+               << OP_DROP << OP_DUP << OP_SHA256 << OP_DROP;
+    }
+    assert(script.size() <= MAX_SCRIPT_SIZE);
+
+    const BaseSignatureChecker checker {};
+    while (state.KeepRunning()) {
+        std::vector<std::vector<uint8_t>> stack;
+        ScriptError err;
+        bool success =
+            EvalScript(stack, script, BENCH_SCRIPT_FLAGS, checker, &err);
+        assert(success && err == SCRIPT_ERR_OK && stack.size() == 10);
+    }
+}
+
+// Lots of small numeric elements created and consumed by arithmetic opcodes
+static void EvalScriptArithmetic(benchmark::State &state) {
+    CScript script;
+    script << 1;
+    for (int i = 0; i < 80; ++i) {
+        script << OP_DUP << OP_1ADD << OP_ADD << 3 << OP_SUB << 1000
+               << OP_MIN << -1000 << OP_MAX;
+    }
+    assert(script.size() <= MAX_SCRIPT_SIZE);
+
+    const BaseSignatureChecker checker {};
+    while (state.KeepRunning()) {
+        std::vector<std::vector<uint8_t>> stack;
+        ScriptError err;
+        bool success =
+            EvalScript(stack, script, BENCH_SCRIPT_FLAGS, checker, &err);
+        assert(success && err == SCRIPT_ERR_OK && stack.size() == 1);
+    }
+}
+
+BENCHMARK(VerifyScriptP2PKH);
+BENCHMARK(EvalScriptLargeData);
+BENCHMARK(EvalScriptArithmetic);
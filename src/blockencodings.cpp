@@ -11,6 +11,7 @@
 #include "hash.h"
 #include "random.h"
 #include "streams.h"
+#include "task_helpers.h"
 #include "txmempool.h"
 #include "util.h"
 #include "validation.h"
@@ -78,6 +79,40 @@ uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const uint256 &txhash) const {
     return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffL;
 }
 
+namespace {
+// Positions in the mempool's vTxHashes whose short ID matches a short ID of
+// the compact block, paired with the index of that transaction in the block.
+using ShortIdMatches = std::vector<std::pair<size_t, uint32_t>>;
+
+ShortIdMatches FindShortIdMatchesInRange(
+    const CBlockHeaderAndShortTxIDs &cmpctblock,
+    const std::unordered_map<uint64_t, uint32_t> &shorttxids,
+    const std::vector<std::pair<uint256, CTxMemPool::txiter>> &vTxHashes,
+    size_t begin,
+    size_t end) {
+    ShortIdMatches matches {};
+    for (size_t i = begin; i < end; ++i) {
+        const auto idit =
+            shorttxids.find(cmpctblock.GetShortID(vTxHashes[i].first));
+        if (idit != shorttxids.end()) {
+            matches.emplace_back(i, idit->second);
+        }
+    }
+    return matches;
+}
+} // namespace
+
+PartiallyDownloadedBlock::PartiallyDownloadedBlock(const Config &configIn,
+                                                   CTxMemPool *poolIn)
+    : pool(poolIn), config(&configIn),
+      shortIdScanMaxChunks(GetParallelTaskPool().getPoolSize()) {}
+
+void PartiallyDownloadedBlock::SetShortIdScanChunking(size_t maxChunks,
+                                                      size_t minChunkSize) {
+    shortIdScanMaxChunks = maxChunks;
+    shortIdScanMinChunkSize = minChunkSize;
+}
+
 ReadStatus PartiallyDownloadedBlock::InitData(
     const CBlockHeaderAndShortTxIDs &cmpctblock,
     const std::vector<std::pair<uint256, CTransactionRef>> &extra_txns) {
@@ -163,30 +198,49 @@ ReadStatus PartiallyDownloadedBlock::InitData(
         std::shared_lock lock(pool->smtx);
         const std::vector<std::pair<uint256, CTxMemPool::txiter>> &vTxHashes =
             pool->vTxHashes;
-        for (auto txHash : vTxHashes) {
-            uint64_t shortid = cmpctblock.GetShortID(txHash.first);
-            std::unordered_map<uint64_t, uint32_t>::iterator idit =
-                shorttxids.find(shortid);
-            if (idit != shorttxids.end()) {
-                if (!have_txn[idit->second]) {
-                    txns_available[idit->second] = txHash.second->GetSharedTx();
-                    have_txn[idit->second] = true;
+        // Short IDs are computed for the whole mempool in parallel, in
+        // contiguous chunks; matches are then applied in mempool order so that
+        // the outcome (including collision handling and the early exit) is the
+        // same as for a serial scan.
+        bool fAllFound { shorttxids.empty() };
+        std::vector<ShortIdMatches> vMatches {};
+        if (!fAllFound) {
+            vMatches = parallel_for_chunks(
+                GetParallelTaskPool(), vTxHashes.size(),
+                shortIdScanMinChunkSize, shortIdScanMaxChunks,
+                [&cmpctblock, &shorttxids, &vTxHashes](size_t begin,
+                                                       size_t end) {
+                    return FindShortIdMatchesInRange(
+                        cmpctblock, shorttxids, vTxHashes, begin, end);
+                });
+        }
+        for (const ShortIdMatches &matches : vMatches) {
+            for (const auto &match : matches) {
+                const size_t blockIndex { match.second };
+                if (!have_txn[blockIndex]) {
+                    txns_available[blockIndex] =
+                        vTxHashes[match.first].second->GetSharedTx();
+                    have_txn[blockIndex] = true;
                     mempool_count++;
                 } else {
                     // If we find two mempool txn that match the short id, just
                     // request it. This should be rare enough that the extra
                     // bandwidth doesn't matter, but eating a round-trip due to
                     // FillBlock failure would be annoying.
-                    if (txns_available[idit->second]) {
-                        txns_available[idit->second].reset();
+                    if (txns_available[blockIndex]) {
+                        txns_available[blockIndex].reset();
                         mempool_count--;
                     }
                 }
+                // Though ideally we'd continue scanning for the
+                // two-txn-match-shortid case, the performance win of an early
+                // exit here is too good to pass up and worth the extra risk.
+                if (mempool_count == shorttxids.size()) {
+                    fAllFound = true;
+                    break;
+                }
             }
-            // Though ideally we'd continue scanning for the
-            // two-txn-match-shortid case, the performance win of an early exit
-            // here is too good to pass up and worth the extra risk.
-            if (mempool_count == shorttxids.size()) {
+            if (fAllFound) {
                 break;
             }
         }
@@ -224,11 +224,20 @@ protected:
     size_t prefilled_count = 0, mempool_count = 0, extra_count = 0;
     CTxMemPool *pool;
     const Config *config;
+    // The mempool short ID scan is split into at most this many chunks of at
+    // least this many transactions each, which are processed in parallel.
+    size_t shortIdScanMaxChunks;
+    size_t shortIdScanMinChunkSize = DEFAULT_SHORTID_SCAN_CHUNK_MIN_SIZE;
 
 public:
+    static constexpr size_t DEFAULT_SHORTID_SCAN_CHUNK_MIN_SIZE = 16384;
+
     CBlockHeader header;
-    PartiallyDownloadedBlock(const Config &configIn, CTxMemPool *poolIn)
-        : pool(poolIn), config(&configIn) {}
+    PartiallyDownloadedBlock(const Config &configIn, CTxMemPool *poolIn);
+
+    // Override how the mempool short ID scan is split up (defaults to one
+    // chunk per core).
+    void SetShortIdScanChunking(size_t maxChunks, size_t minChunkSize);
 
     // extra_txn is a list of extra transactions to look at, in <txhash,
     // reference> form.
@@ -9,6 +9,8 @@
 #include "txdb.h"  // CBlockTreeDB
 #include "consensus/validation.h" // CValidationState
 
+#include <algorithm>
+
 /** Access to info about block files */
 std::unique_ptr<CBlockFileInfoStore> pBlockFileInfoStore = std::make_unique<CBlockFileInfoStore>();
 
@@ -32,30 +34,191 @@ void CBlockFileInfoStore::FindNextFileWithEnoughEmptySpace(const Config &config,
     }
 }
 
-void CBlockFileInfoStore::FlushBlockFile(bool fFinalize) {
-    LOCK(cs_LastBlockFile);
+CBlockFileWriter::CBlockFileWriter(size_t maxQueuedBytes, CommitFunction commit)
+    : mMaxQueuedBytes{maxQueuedBytes}, mCommit{std::move(commit)}
+{}
+
+CBlockFileWriter::~CBlockFileWriter() {
+    Stop();
+}
+
+bool CBlockFileWriter::Write(BlockFileType type, const CDiskBlockPos &pos,
+    std::vector<uint8_t> &&data) {
+    std::unique_lock<std::mutex> lock { mMtx };
+    mJobDone.wait(lock, [this, &data] {
+        return mFailed || mQueuedBytes == 0 ||
+               mQueuedBytes + data.size() <= mMaxQueuedBytes;
+    });
+    if (mFailed) {
+        return false;
+    }
+    mQueuedBytes += data.size();
+    Queue(lock, { Job::Kind::WRITE, type, pos, std::move(data), 0, 0, 0 });
+    return true;
+}
 
-    CDiskBlockPos posOld(nLastBlockFile, 0);
+void CBlockFileWriter::Finalize(int nFile, unsigned int nBlockSize,
+    unsigned int nUndoSize) {
+    std::unique_lock<std::mutex> lock { mMtx };
+    Queue(lock, { Job::Kind::FINALIZE, BlockFileType::BLOCK,
+        CDiskBlockPos(nFile, 0), {}, nBlockSize, nUndoSize, 0 });
+}
+
+bool CBlockFileWriter::Sync(int nFile) {
+    std::unique_lock<std::mutex> lock { mMtx };
+    uint64_t nSeq { Queue(lock, { Job::Kind::SYNC, BlockFileType::BLOCK,
+        CDiskBlockPos(nFile, 0), {}, 0, 0, 0 }) };
+    mJobDone.wait(lock, [this, nSeq] { return mDoneSeq >= nSeq; });
+    return !mFailed;
+}
+
+void CBlockFileWriter::WaitForWrites(BlockFileType type, int nFile) const {
+    std::unique_lock<std::mutex> lock { mMtx };
+    mJobDone.wait(lock, [this, type, nFile] {
+        return std::none_of(mJobs.begin(), mJobs.end(),
+            [type, nFile](const Job &job) {
+                return job.kind == Job::Kind::WRITE && job.type == type &&
+                       job.pos.nFile == nFile;
+            });
+    });
+}
 
-    FILE *fileOld = CDiskFiles::OpenBlockFile(posOld);
-    if (fileOld) {
-        if (fFinalize) {
-            TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nSize);
+void CBlockFileWriter::Stop() {
+    {
+        std::unique_lock<std::mutex> lock { mMtx };
+        if (!mThread.joinable()) {
+            return;
         }
-        FileCommit(fileOld);
-        fclose(fileOld);
+        mStopping = true;
+    }
+    mJobQueued.notify_one();
+    mThread.join();
+
+    std::unique_lock<std::mutex> lock { mMtx };
+    mThread = std::thread {};
+    mStopping = false;
+    if (!mJobs.empty()) {
+        // Something was queued after the writer thread had finished
+        mThread = std::thread(&CBlockFileWriter::ThreadWriter, this);
     }
+}
 
-    fileOld = CDiskFiles::OpenUndoFile(posOld);
-    if (fileOld) {
-        if (fFinalize) {
-            TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nUndoSize);
+size_t CBlockFileWriter::GetQueuedBytes() const {
+    std::unique_lock<std::mutex> lock { mMtx };
+    return mQueuedBytes;
+}
+
+uint64_t CBlockFileWriter::Queue(std::unique_lock<std::mutex> &lock, Job &&job) {
+    assert(lock.owns_lock());
+    if (!mThread.joinable()) {
+        mThread = std::thread(&CBlockFileWriter::ThreadWriter, this);
+    }
+    job.nSeq = ++mNextSeq;
+    mJobs.push_back(std::move(job));
+    mJobQueued.notify_one();
+    return mNextSeq;
+}
+
+void CBlockFileWriter::ThreadWriter() {
+    RenameThread("bitcoin-blkwrite");
+
+    std::unique_lock<std::mutex> lock { mMtx };
+    while (true) {
+        mJobQueued.wait(lock, [this] { return mStopping || !mJobs.empty(); });
+        if (mJobs.empty()) {
+            // Only stop once everything queued has been written
+            return;
         }
-        FileCommit(fileOld);
-        fclose(fileOld);
+
+        // The job stays at the front of the queue while it runs so that
+        // readers keep waiting for it.
+        const Job &job { mJobs.front() };
+        lock.unlock();
+        bool fSuccess { RunJob(job) };
+        lock.lock();
+
+        mFailed = mFailed || !fSuccess;
+        mQueuedBytes -= job.data.size();
+        mDoneSeq = job.nSeq;
+        mJobs.pop_front();
+        mJobDone.notify_all();
     }
 }
 
+bool CBlockFileWriter::RunJob(const Job &job) const {
+    switch (job.kind) {
+    case Job::Kind::WRITE: {
+        FILE *file { job.type == BlockFileType::BLOCK ?
+            CDiskFiles::OpenBlockFile(job.pos) :
+            CDiskFiles::OpenUndoFile(job.pos) };
+        if (!file) {
+            return error("%s: Failed to open file %d for writing", __func__,
+                job.pos.nFile);
+        }
+        bool fSuccess {
+            fwrite(job.data.data(), 1, job.data.size(), file) == job.data.size() };
+        fSuccess = (fclose(file) == 0) && fSuccess;
+        if (!fSuccess) {
+            return error("%s: Failed to write %u bytes at position %u of file %d",
+                __func__, job.data.size(), job.pos.nPos, job.pos.nFile);
+        }
+        return true;
+    }
+    case Job::Kind::FINALIZE:
+    case Job::Kind::SYNC: {
+        bool fFinalize { job.kind == Job::Kind::FINALIZE };
+        FILE *file = CDiskFiles::OpenBlockFile(job.pos);
+        if (file) {
+            if (fFinalize) {
+                TruncateFile(file, job.nBlockSize);
+            }
+            mCommit(file);
+            fclose(file);
+        }
+        file = CDiskFiles::OpenUndoFile(job.pos);
+        if (file) {
+            if (fFinalize) {
+                TruncateFile(file, job.nUndoSize);
+            }
+            mCommit(file);
+            fclose(file);
+        }
+        return true;
+    }
+    }
+    return false;
+}
+
+bool CBlockFileInfoStore::FlushBlockFile(bool fFinalize) {
+    LOCK(cs_LastBlockFile);
+
+    if (fFinalize) {
+        // Accepting the block that starts the next file doesn't wait for
+        // this one to reach the disk.
+        blockFileWriter.Finalize(nLastBlockFile,
+            vinfoBlockFile[nLastBlockFile].nSize,
+            vinfoBlockFile[nLastBlockFile].nUndoSize);
+        return true;
+    }
+
+    // The caller is about to persist references to block data, so everything
+    // written so far, including files finalized earlier, must be on disk.
+    return blockFileWriter.Sync(nLastBlockFile);
+}
+
+bool CBlockFileInfoStore::WriteBlockFileData(BlockFileType type,
+    const CDiskBlockPos &pos, std::vector<uint8_t> &&data) {
+    return blockFileWriter.Write(type, pos, std::move(data));
+}
+
+void CBlockFileInfoStore::WaitForPendingWrites(BlockFileType type, int nFile) const {
+    blockFileWriter.WaitForWrites(type, nFile);
+}
+
+void CBlockFileInfoStore::StopWriter() {
+    blockFileWriter.Stop();
+}
+
 std::vector<std::pair<int, const CBlockFileInfo *>> CBlockFileInfoStore::GetAndClearDirtyFileInfo()
 {
     std::vector<std::pair<int, const CBlockFileInfo *>> vFiles;
@@ -322,6 +485,7 @@ void CBlockFileInfoStore::LoadBlockFileInfo(int nLastBlockFile, CBlockTreeDB& bl
 
 void CBlockFileInfoStore::Clear()
 {
+    StopWriter();
     vinfoBlockFile.clear();
     nLastBlockFile = 0;
     setDirtyFileInfo.clear();
@@ -331,3 +495,55 @@ CBlockFileInfo *CBlockFileInfoStore::GetBlockFileInfo(size_t n)
 {
     return &vinfoBlockFile.at(n);
 }
+
+CBlockFileReadCache::CBlockFileReadCache(size_t maxOpenFiles)
+    : mMaxOpenFiles{maxOpenFiles}
+{}
+
+CBlockFileReadCache::~CBlockFileReadCache() {
+    for (const auto &handle : mHandles) {
+        fclose(handle.second);
+    }
+}
+
+FILE *CBlockFileReadCache::Take(int nFile) {
+    // A cached handle may be for a file that is still being written
+    pBlockFileInfoStore->WaitForPendingWrites(BlockFileType::BLOCK, nFile);
+    {
+        std::lock_guard<std::mutex> lock { mMtx };
+        auto it = std::find_if(mHandles.begin(), mHandles.end(),
+            [nFile](const std::pair<int, FILE *> &handle) {
+                return handle.first == nFile;
+            });
+        if (it != mHandles.end()) {
+            FILE *file { it->second };
+            mHandles.erase(it);
+            return file;
+        }
+    }
+    return CDiskFiles::OpenBlockFile(CDiskBlockPos(nFile, 0), true);
+}
+
+void CBlockFileReadCache::Return(int nFile, FILE *file) {
+    FILE *evicted { nullptr };
+    {
+        std::lock_guard<std::mutex> lock { mMtx };
+        mHandles.emplace_front(nFile, file);
+        if (mHandles.size() > mMaxOpenFiles) {
+            evicted = mHandles.back().second;
+            mHandles.pop_back();
+        }
+    }
+    if (evicted) {
+        fclose(evicted);
+    }
+}
+
+std::vector<int> CBlockFileReadCache::GetCachedFiles() const {
+    std::lock_guard<std::mutex> lock { mMtx };
+    std::vector<int> files {};
+    for (const auto &handle : mHandles) {
+        files.push_back(handle.first);
+    }
+    return files;
+}
@@ -4,12 +4,110 @@
 #ifndef BITCOIN_BLOCKFILEINFOSTORE_H
 #define BITCOIN_BLOCKFILEINFOSTORE_H
 
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "sync.h"
 #include "chain.h"
+#include "util.h"
 #include "validation.h"
 
+/** The two kinds of files block data is stored in */
+enum class BlockFileType { BLOCK, UNDO };
+
+/** Default limit on the amount of block and undo data waiting to be written */
+static constexpr size_t DEFAULT_MAX_QUEUED_BLOCK_FILE_WRITES = 256 * 1024 * 1024;
+
+/**
+ * Writes block and undo data to disk on its own thread, so that accepting and
+ * connecting blocks under cs_main doesn't wait for the disk.
+ *
+ * Data is queued already serialised at the position reserved for it, and
+ * writes, truncations and syncs are carried out in the order they were
+ * queued. The queue is bounded by the amount of data in it, so a disk that
+ * can't keep up eventually makes the callers wait. Anything reading block or
+ * undo files must first wait for the pending writes to that file.
+ *
+ * A failed write is logged and makes all later calls to Write() and Sync()
+ * return false.
+ */
+class CBlockFileWriter
+{
+public:
+    using CommitFunction = std::function<void(FILE *)>;
+
+    explicit CBlockFileWriter(
+        size_t maxQueuedBytes = DEFAULT_MAX_QUEUED_BLOCK_FILE_WRITES,
+        CommitFunction commit = FileCommit);
+    ~CBlockFileWriter();
+
+    CBlockFileWriter(const CBlockFileWriter&) = delete;
+    CBlockFileWriter& operator=(const CBlockFileWriter&) = delete;
+
+    // Queue data to be written at the given position. Waits while the queue
+    // is full, unless it is empty (so a single oversized write still goes in).
+    bool Write(BlockFileType type, const CDiskBlockPos &pos,
+        std::vector<uint8_t> &&data);
+
+    // Queue truncating and syncing a block file and its undo file once all
+    // writes queued before it are done.
+    void Finalize(int nFile, unsigned int nBlockSize, unsigned int nUndoSize);
+
+    // Sync a block file and its undo file, and wait until that and everything
+    // queued before it is on disk.
+    bool Sync(int nFile);
+
+    // Wait until no writes to the given file are pending
+    void WaitForWrites(BlockFileType type, int nFile) const;
+
+    // Finish everything queued and stop the writer thread; it is restarted
+    // by the next call that queues something.
+    void Stop();
+
+    size_t GetQueuedBytes() const;
+
+private:
+    struct Job
+    {
+        enum class Kind { WRITE, FINALIZE, SYNC };
+
+        Kind kind;
+        BlockFileType type;
+        CDiskBlockPos pos;
+        std::vector<uint8_t> data;
+        unsigned int nBlockSize;
+        unsigned int nUndoSize;
+        uint64_t nSeq;
+    };
+
+    // Queue a job; called with mMtx held
+    uint64_t Queue(std::unique_lock<std::mutex> &lock, Job &&job);
+    void ThreadWriter();
+    bool RunJob(const Job &job) const;
+
+    const size_t mMaxQueuedBytes;
+    const CommitFunction mCommit;
+
+    mutable std::mutex mMtx {};
+    std::condition_variable mJobQueued {};
+    mutable std::condition_variable mJobDone {};
+    // Pending jobs, oldest first; the one being run stays at the front
+    std::deque<Job> mJobs {};
+    size_t mQueuedBytes {0};
+    uint64_t mNextSeq {0};
+    uint64_t mDoneSeq {0};
+    bool mFailed {false};
+    bool mStopping {false};
+    std::thread mThread {};
+};
+
 /** Stores a collection of CBlockFileInfo-s in memory */
 class CBlockFileInfoStore
 {
@@ -20,6 +118,9 @@ class CBlockFileInfoStore
     /** Dirty block file entries. */
     std::set<int> setDirtyFileInfo;
 
+    /** Writes block and undo data in the background. */
+    CBlockFileWriter blockFileWriter;
+
     void FindNextFileWithEnoughEmptySpace(const Config &config,
         unsigned int nAddSize, unsigned int& nFile);
 public:
@@ -38,7 +139,22 @@ public:
     bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos,
         unsigned int nAddSize, bool& fCheckForPruning);
 
-    void FlushBlockFile(bool fFinalize = false);
+    // Sync the current block and undo files to disk. A finalized file is
+    // truncated and synced in the background once all writes to it are done;
+    // a non-finalizing flush waits until all queued writes are on disk and
+    // returns false if any of them failed.
+    bool FlushBlockFile(bool fFinalize = false);
+
+    // Queue block or undo data to be written at a position returned by
+    // FindBlockPos() or FindUndoPos()
+    bool WriteBlockFileData(BlockFileType type, const CDiskBlockPos &pos,
+        std::vector<uint8_t> &&data);
+
+    // Wait until the data queued for the given file has been written
+    void WaitForPendingWrites(BlockFileType type, int nFile) const;
+
+    // Write out everything queued and stop the writer thread
+    void StopWriter();
 
     void LoadBlockFileInfo(int nLastBlockFile, CBlockTreeDB& blockTreeDb);
 
@@ -79,6 +195,40 @@ public:
 };
 
 
+/**
+ * A small LRU cache of read-only block file handles used by txindex lookups.
+ * A handle is taken out of the cache while it is being read, so concurrent
+ * readers never share a file position.
+ */
+class CBlockFileReadCache
+{
+public:
+    explicit CBlockFileReadCache(size_t maxOpenFiles = DEFAULT_MAX_OPEN_FILES);
+    ~CBlockFileReadCache();
+
+    CBlockFileReadCache(const CBlockFileReadCache&) = delete;
+    CBlockFileReadCache& operator=(const CBlockFileReadCache&) = delete;
+
+    // Take a cached handle for the given block file or open a new one
+    FILE *Take(int nFile);
+
+    // Put a handle back, closing the least recently used one if full
+    void Return(int nFile, FILE *file);
+
+    // Get the files that have cached handles, most recently returned first
+    std::vector<int> GetCachedFiles() const;
+
+    static constexpr size_t DEFAULT_MAX_OPEN_FILES {16};
+
+private:
+    const size_t mMaxOpenFiles;
+
+    mutable std::mutex mMtx {};
+    // Most recently returned handles first
+    std::list<std::pair<int, FILE *>> mHandles {};
+};
+
+
 /** Access to info about block files */
 extern std::unique_ptr<CBlockFileInfoStore> pBlockFileInfoStore;
 
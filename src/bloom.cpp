@@ -5,6 +5,7 @@
 #include "bloom.h"
 
 #include "hash.h"
+#include "memusage.h"
 #include "primitives/transaction.h"
 #include "random.h"
 #include "script/script.h"
@@ -48,25 +49,30 @@ CBloomFilter::CBloomFilter(unsigned int nElements, double nFPRate, unsigned int
     return ;
 }
 
-inline unsigned int
-CBloomFilter::Hash(unsigned int nHashNum,
-                   const std::vector<uint8_t> &vDataToHash) const {
+inline unsigned int CBloomFilter::Hash(unsigned int nHashNum,
+                                       const uint8_t *pDataToHash,
+                                       size_t nDataSize) const {
     // 0xFBA4C795 chosen as it guarantees a reasonable bit difference between
     // nHashNum values.
-    return MurmurHash3(nHashNum * 0xFBA4C795 + nTweak, vDataToHash) %
+    return MurmurHash3(nHashNum * 0xFBA4C795 + nTweak, pDataToHash,
+                       nDataSize) %
            (vData.size() * 8);
 }
 
-void CBloomFilter::insert(const std::vector<uint8_t> &vKey) {
+void CBloomFilter::insert(const uint8_t *pKey, size_t nKeySize) {
     if (isFull) return;
     for (unsigned int i = 0; i < nHashFuncs; i++) {
-        unsigned int nIndex = Hash(i, vKey);
+        unsigned int nIndex = Hash(i, pKey, nKeySize);
         // Sets bit nIndex of vData
         vData[nIndex >> 3] |= (1 << (7 & nIndex));
     }
     isEmpty = false;
 }
 
+void CBloomFilter::insert(const std::vector<uint8_t> &vKey) {
+    insert(vKey.data(), vKey.size());
+}
+
 void CBloomFilter::insert(const COutPoint &outpoint) {
     CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
     stream << outpoint;
@@ -79,7 +85,7 @@ void CBloomFilter::insert(const uint256 &hash) {
     insert(data);
 }
 
-bool CBloomFilter::contains(const std::vector<uint8_t> &vKey) const {
+bool CBloomFilter::contains(const uint8_t *pKey, size_t nKeySize) const {
     if (isFull) {
         return true;
     }
@@ -87,7 +93,7 @@ bool CBloomFilter::contains(const std::vector<uint8_t> &vKey) const {
         return false;
     }
     for (unsigned int i = 0; i < nHashFuncs; i++) {
-        unsigned int nIndex = Hash(i, vKey);
+        unsigned int nIndex = Hash(i, pKey, nKeySize);
         // Checks bit nIndex of vData
         if (!(vData[nIndex >> 3] & (1 << (7 & nIndex)))) {
             return false;
@@ -96,6 +102,10 @@ bool CBloomFilter::contains(const std::vector<uint8_t> &vKey) const {
     return true;
 }
 
+bool CBloomFilter::contains(const std::vector<uint8_t> &vKey) const {
+    return contains(vKey.data(), vKey.size());
+}
+
 bool CBloomFilter::contains(const COutPoint &outpoint) const {
     CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
     stream << outpoint;
@@ -200,6 +210,128 @@ bool CBloomFilter::IsRelevantAndUpdate(const CTransaction &tx) {
     return false;
 }
 
+bool CBloomFilter::contains(const CBloomElements &elements,
+                            size_t nElement) const {
+    const size_t nBegin =
+        nElement == 0 ? 0 : elements.vElementEnds[nElement - 1];
+    return contains(elements.vData.data() + nBegin,
+                    elements.vElementEnds[nElement] - nBegin);
+}
+
+bool CBloomFilter::IsRelevantAndUpdate(const CBloomElements &elements,
+                                       size_t nTx) {
+    // Mirrors IsRelevantAndUpdate(const CTransaction &), including the order
+    // in which the filter is updated.
+    bool fFound = false;
+    if (isFull) {
+        return true;
+    }
+    if (isEmpty) {
+        return false;
+    }
+    const CBloomElements::Tx &tx = elements.vTx[nTx];
+    if (contains(tx.txid)) {
+        fFound = true;
+    }
+
+    for (size_t i = tx.nOutputsBegin; i < tx.nOutputsEnd; i++) {
+        const CBloomElements::Script &output = elements.vOutputs[i];
+        for (size_t n = output.nElementsBegin; n < output.nElementsEnd; n++) {
+            if (contains(elements, n)) {
+                fFound = true;
+                if ((nFlags & BLOOM_UPDATE_MASK) == BLOOM_UPDATE_ALL ||
+                    ((nFlags & BLOOM_UPDATE_MASK) ==
+                         BLOOM_UPDATE_P2PUBKEY_ONLY &&
+                     output.fPubKeyOrMultisig)) {
+                    insert(COutPoint(tx.txid, i - tx.nOutputsBegin));
+                }
+                break;
+            }
+        }
+    }
+
+    if (fFound) {
+        return true;
+    }
+
+    // The prevout is the first element of each input
+    for (size_t i = tx.nInputsBegin; i < tx.nInputsEnd; i++) {
+        const CBloomElements::Script &input = elements.vInputs[i];
+        for (size_t n = input.nElementsBegin; n < input.nElementsEnd; n++) {
+            if (contains(elements, n)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void CBloomElements::AddElement(const uint8_t *pData, size_t nSize) {
+    vData.insert(vData.end(), pData, pData + nSize);
+    vElementEnds.push_back(vData.size());
+}
+
+void CBloomElements::AddScriptElements(const CScript &script) {
+    // Empty pushes never match, so they aren't kept.
+    CScript::const_iterator pc = script.begin();
+    std::vector<uint8_t> data;
+    while (pc < script.end()) {
+        opcodetype opcode;
+        if (!script.GetOp(pc, opcode, data)) {
+            break;
+        }
+        if (data.size() != 0) {
+            AddElement(data.data(), data.size());
+        }
+    }
+}
+
+void CBloomElements::AddTransaction(const CTransaction &tx) {
+    Tx entry;
+    entry.txid = tx.GetId();
+
+    entry.nOutputsBegin = vOutputs.size();
+    for (const CTxOut &txout : tx.vout) {
+        Script output;
+        output.nElementsBegin = vElementEnds.size();
+        AddScriptElements(txout.scriptPubKey);
+        output.nElementsEnd = vElementEnds.size();
+        txnouttype type;
+        std::vector<std::vector<uint8_t>> vSolutions;
+        output.fPubKeyOrMultisig =
+            output.nElementsBegin != output.nElementsEnd &&
+            Solver(txout.scriptPubKey, type, vSolutions) &&
+            (type == TX_PUBKEY || type == TX_MULTISIG);
+        vOutputs.push_back(output);
+    }
+    entry.nOutputsEnd = vOutputs.size();
+
+    entry.nInputsBegin = vInputs.size();
+    for (const CTxIn &txin : tx.vin) {
+        Script input;
+        input.nElementsBegin = vElementEnds.size();
+        CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+        stream << txin.prevout;
+        AddElement(reinterpret_cast<const uint8_t *>(stream.data()),
+                   stream.size());
+        AddScriptElements(txin.scriptSig);
+        input.nElementsEnd = vElementEnds.size();
+        input.fPubKeyOrMultisig = false;
+        vInputs.push_back(input);
+    }
+    entry.nInputsEnd = vInputs.size();
+
+    vTx.push_back(entry);
+}
+
+size_t CBloomElements::DynamicMemoryUsage() const {
+    return memusage::DynamicUsage(vTx) + memusage::DynamicUsage(vOutputs) +
+           memusage::DynamicUsage(vInputs) +
+           memusage::DynamicUsage(vElementEnds) +
+           memusage::DynamicUsage(vData);
+}
+
 void CBloomFilter::UpdateEmptyFull() {
     bool full = true;
     bool empty = true;
@@ -248,14 +380,21 @@ CRollingBloomFilter::CRollingBloomFilter(unsigned int nElements, double fpRate)
     reset();
 }
 
-/* Similar to CBloomFilter::Hash */
-static inline uint32_t
-RollingBloomHash(unsigned int nHashNum, uint32_t nTweak,
-                 const std::vector<uint8_t> &vDataToHash) {
-    return MurmurHash3(nHashNum * 0xFBA4C795 + nTweak, vDataToHash);
+/**
+ * The two hashes of vKey that its nHashFuncs bit positions are derived from,
+ * as h1 + n * h2 (Kirsch and Mitzenmacher, "Less Hashing, Same Performance:
+ * Building a Better Bloom Filter"). That takes two MurmurHash3 passes per key
+ * whatever the false positive rate. Seeded like the first two hash functions
+ * of CBloomFilter::Hash. h2 is made odd so that the positions never collapse
+ * onto a single bit, as they would for h2 == 0.
+ */
+static inline std::pair<uint32_t, uint32_t>
+RollingBloomHashes(uint32_t nTweak, const uint8_t *pKey, size_t nKeySize) {
+    return {MurmurHash3(nTweak, pKey, nKeySize),
+            MurmurHash3(0xFBA4C795 + nTweak, pKey, nKeySize) | 1};
 }
 
-void CRollingBloomFilter::insert(const std::vector<uint8_t> &vKey) {
+void CRollingBloomFilter::insertHashes(uint32_t h1, uint32_t h2) {
     if (nEntriesThisGeneration == nEntriesPerGeneration) {
         nEntriesThisGeneration = 0;
         nGeneration++;
@@ -274,8 +413,8 @@ void CRollingBloomFilter::insert(const std::vector<uint8_t> &vKey) {
     }
     nEntriesThisGeneration++;
 
-    for (int n = 0; n < nHashFuncs; n++) {
-        uint32_t h = RollingBloomHash(n, nTweak, vKey);
+    uint32_t h = h1;
+    for (int n = 0; n < nHashFuncs; n++, h += h2) {
         int bit = h & 0x3F;
         uint32_t pos = (h >> 6) % data.size();
         /* The lowest bit of pos is ignored, and set to zero for the first bit,
@@ -287,18 +426,13 @@ void CRollingBloomFilter::insert(const std::vector<uint8_t> &vKey) {
     }
 }
 
-void CRollingBloomFilter::insert(const uint256 &hash) {
-    std::vector<uint8_t> vData(hash.begin(), hash.end());
-    insert(vData);
-}
-
-bool CRollingBloomFilter::contains(const std::vector<uint8_t> &vKey) const {
-    for (int n = 0; n < nHashFuncs; n++) {
-        uint32_t h = RollingBloomHash(n, nTweak, vKey);
+bool CRollingBloomFilter::containsHashes(uint32_t h1, uint32_t h2) const {
+    uint32_t h = h1;
+    for (int n = 0; n < nHashFuncs; n++, h += h2) {
         int bit = h & 0x3F;
         uint32_t pos = (h >> 6) % data.size();
         /* If the relevant bit is not set in either data[pos & ~1] or data[pos |
-         * 1], the filter does not contain vKey */
+         * 1], the filter does not contain the key */
         if (!(((data[pos & ~1] | data[pos | 1]) >> bit) & 1)) {
             return false;
         }
@@ -306,9 +440,36 @@ bool CRollingBloomFilter::contains(const std::vector<uint8_t> &vKey) const {
     return true;
 }
 
+void CRollingBloomFilter::insert(const std::vector<uint8_t> &vKey) {
+    const auto hashes = RollingBloomHashes(nTweak, vKey.data(), vKey.size());
+    insertHashes(hashes.first, hashes.second);
+}
+
+void CRollingBloomFilter::insert(const uint256 &hash) {
+    const auto hashes = RollingBloomHashes(nTweak, hash.begin(), hash.size());
+    insertHashes(hashes.first, hashes.second);
+}
+
+void CRollingBloomFilter::insert(const std::vector<uint256> &vHashes) {
+    std::vector<std::pair<uint32_t, uint32_t>> vKeyHashes;
+    vKeyHashes.reserve(vHashes.size());
+    for (const uint256 &hash : vHashes) {
+        vKeyHashes.push_back(
+            RollingBloomHashes(nTweak, hash.begin(), hash.size()));
+    }
+    for (const auto &hashes : vKeyHashes) {
+        insertHashes(hashes.first, hashes.second);
+    }
+}
+
+bool CRollingBloomFilter::contains(const std::vector<uint8_t> &vKey) const {
+    const auto hashes = RollingBloomHashes(nTweak, vKey.data(), vKey.size());
+    return containsHashes(hashes.first, hashes.second);
+}
+
 bool CRollingBloomFilter::contains(const uint256 &hash) const {
-    std::vector<uint8_t> vData(hash.begin(), hash.end());
-    return contains(vData);
+    const auto hashes = RollingBloomHashes(nTweak, hash.begin(), hash.size());
+    return containsHashes(hashes.first, hashes.second);
 }
 
 void CRollingBloomFilter::reset() {
@@ -6,12 +6,13 @@
 #define BITCOIN_BLOOM_H
 
 #include "serialize.h"
+#include "uint256.h"
 
 #include <vector>
 
 class COutPoint;
+class CScript;
 class CTransaction;
-class uint256;
 
 //! 20,000 items with fp rate < 0.1% or 10,000 items and <0.0001%
 static const unsigned int MAX_BLOOM_FILTER_SIZE = 36000; // bytes
@@ -30,6 +31,54 @@ enum bloomflags {
     BLOOM_UPDATE_MASK = 3,
 };
 
+/**
+ * Everything CBloomFilter::IsRelevantAndUpdate looks at in a list of
+ * transactions: their ids, the outpoints they spend and the data pushed by
+ * their scripts. Extracting these once lets the same block be matched against
+ * the filters of many peers without parsing its scripts again for each one.
+ */
+class CBloomElements {
+public:
+    void AddTransaction(const CTransaction &tx);
+
+    size_t GetTransactionCount() const { return vTx.size(); }
+    const uint256 &GetTxId(size_t nTx) const { return vTx[nTx].txid; }
+
+    size_t DynamicMemoryUsage() const;
+
+private:
+    friend class CBloomFilter;
+
+    struct Script {
+        //! Range of the script's elements in vElementEnds
+        size_t nElementsBegin;
+        size_t nElementsEnd;
+        //! Only for outputs: whether BLOOM_UPDATE_P2PUBKEY_ONLY adds it
+        bool fPubKeyOrMultisig;
+    };
+
+    struct Tx {
+        uint256 txid;
+        size_t nOutputsBegin;
+        size_t nOutputsEnd;
+        size_t nInputsBegin;
+        size_t nInputsEnd;
+    };
+
+    std::vector<Tx> vTx;
+    std::vector<Script> vOutputs;
+    //! The first element of each input is its serialized prevout, followed by
+    //! the data pushed by its scriptSig.
+    std::vector<Script> vInputs;
+    //! Element n is the bytes of vData from vElementEnds[n - 1] (or 0) to
+    //! vElementEnds[n].
+    std::vector<size_t> vElementEnds;
+    std::vector<uint8_t> vData;
+
+    void AddElement(const uint8_t *pData, size_t nSize);
+    void AddScriptElements(const CScript &script);
+};
+
 /**
  * BloomFilter is a probabilistic filter which SPV clients provide so that we
  * can filter the transactions we send them.
@@ -50,7 +99,9 @@ private:
     unsigned int nTweak;
     uint8_t nFlags;
 
-    unsigned int Hash(unsigned int nHashNum, const std::vector<uint8_t> &vDataToHash) const;
+    unsigned int Hash(unsigned int nHashNum, const uint8_t *pDataToHash,
+                      size_t nDataSize) const;
+    bool contains(const CBloomElements &elements, size_t nElement) const;
 
 public:
     /**
@@ -85,10 +136,12 @@ public:
         READWRITE(nFlags);
     }
 
+    void insert(const uint8_t *pKey, size_t nKeySize);
     void insert(const std::vector<uint8_t> &vKey);
     void insert(const COutPoint &outpoint);
     void insert(const uint256 &hash);
 
+    bool contains(const uint8_t *pKey, size_t nKeySize) const;
     bool contains(const std::vector<uint8_t> &vKey) const;
     bool contains(const COutPoint &outpoint) const;
     bool contains(const uint256 &hash) const;
@@ -104,6 +157,8 @@ public:
     //! Also adds any outputs which match the filter to the filter (to match
     //! their spending txes)
     bool IsRelevantAndUpdate(const CTransaction &tx);
+    //! Same as above for transaction nTx of elements
+    bool IsRelevantAndUpdate(const CBloomElements &elements, size_t nTx);
 
     //! Checks for empty and full filters to avoid wasting cpu
     void UpdateEmptyFull();
@@ -135,9 +190,17 @@ public:
     bool contains(const std::vector<uint8_t> &vKey) const;
     bool contains(const uint256 &hash) const;
 
+    //! Insert a batch of hashes. All of them are hashed before the filter is
+    //! touched, so the hashing of one doesn't wait on the memory accesses of
+    //! another.
+    void insert(const std::vector<uint256> &vHashes);
+
     void reset();
 
 private:
+    void insertHashes(uint32_t h1, uint32_t h2);
+    bool containsHashes(uint32_t h1, uint32_t h2) const;
+
     int nEntriesPerGeneration;
     int nEntriesThisGeneration;
     int nGeneration;
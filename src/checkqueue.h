@@ -48,6 +48,9 @@ private:
     //! The temporary evaluation result.
     bool fAllOk;
 
+    //! The first check that failed, handed to the master if it asks for it.
+    T failedCheck;
+
     /**
      * Number of verifications that haven't completed yet.
      * This includes elements that are no longer queued, but still in the
@@ -62,10 +65,11 @@ private:
     unsigned int nBatchSize;
 
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster = false) {
+    bool Loop(bool fMaster = false, T *pFailedCheck = nullptr) {
         boost::condition_variable &cond = fMaster ? condMaster : condWorker;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
+        T failed;
         unsigned int nNow = 0;
         bool fOk = true;
         do {
@@ -74,6 +78,10 @@ private:
                 // first do the clean-up of the previous loop run (allowing us
                 // to do it in the same critsect)
                 if (nNow) {
+                    if (!fOk && fAllOk) {
+                        // We hold the first failure
+                        failedCheck.swap(failed);
+                    }
                     fAllOk &= fOk;
                     nTodo -= nNow;
                     if (nTodo == 0 && !fMaster)
@@ -90,7 +98,12 @@ private:
                         nTotal--;
                         bool fRet = fAllOk;
                         // reset the status for new work later
-                        if (fMaster) fAllOk = true;
+                        if (fMaster && !fRet) {
+                            T none;
+                            failedCheck.swap(none);
+                            if (pFailedCheck) pFailedCheck->swap(none);
+                            fAllOk = true;
+                        }
                         // return the current status
                         return fRet;
                     }
@@ -122,7 +135,10 @@ private:
             }
             // execute work
             for (T &check : vChecks) {
-                if (fOk) fOk = check();
+                if (fOk) {
+                    fOk = check();
+                    if (!fOk) failed.swap(check);
+                }
             }
             vChecks.clear();
         } while (true);
@@ -138,8 +154,9 @@ public:
     void Thread() { Loop(); }
 
     //! Wait until execution finishes, and return whether all evaluations were
-    //! successful.
-    bool Wait() { return Loop(true); }
+    //! successful. If not, the first check found to fail is swapped into
+    //! pFailedCheck when given.
+    bool Wait(T *pFailedCheck = nullptr) { return Loop(true, pFailedCheck); }
 
     //! Add a batch of checks to the queue
     void Add(std::vector<T> &vChecks) {
@@ -157,6 +174,10 @@ public:
 
     ~CCheckQueue() {}
 
+    //! Held by the CCheckQueueControl using the queue, as there may be
+    //! several wanting to.
+    boost::mutex ControlMutex;
+
     bool IsIdle() {
         boost::unique_lock<boost::mutex> lock(mutex);
         return (nTotal == nIdle && nTodo == 0 && fAllOk == true);
@@ -171,20 +192,40 @@ template <typename T> class CCheckQueueControl {
 private:
     CCheckQueue<T> *pqueue;
     bool fDone;
+    boost::unique_lock<boost::mutex> controlLock;
 
 public:
     CCheckQueueControl(CCheckQueue<T> *pqueueIn)
         : pqueue(pqueueIn), fDone(false) {
         // passed queue is supposed to be unused, or nullptr
         if (pqueue != nullptr) {
+            controlLock = boost::unique_lock<boost::mutex>(pqueue->ControlMutex);
             bool isIdle = pqueue->IsIdle();
             assert(isIdle);
         }
     }
 
-    bool Wait() {
+    //! Only take the queue if no other controller holds it. Callers must check
+    //! IsUsingQueue() and do the checks themselves if it wasn't taken.
+    CCheckQueueControl(CCheckQueue<T> *pqueueIn, boost::try_to_lock_t)
+        : pqueue(pqueueIn), fDone(false) {
+        if (pqueue != nullptr) {
+            controlLock = boost::unique_lock<boost::mutex>(pqueue->ControlMutex,
+                                                           boost::try_to_lock);
+            if (controlLock.owns_lock()) {
+                bool isIdle = pqueue->IsIdle();
+                assert(isIdle);
+            } else {
+                pqueue = nullptr;
+            }
+        }
+    }
+
+    bool IsUsingQueue() const { return pqueue != nullptr; }
+
+    bool Wait(T *pFailedCheck = nullptr) {
         if (pqueue == nullptr) return true;
-        bool fRet = pqueue->Wait();
+        bool fRet = pqueue->Wait(pFailedCheck);
         fDone = true;
         return fRet;
     }
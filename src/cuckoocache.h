@@ -11,6 +11,8 @@
 #include <cmath>
 #include <cstring>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <vector>
 
 /** namespace CuckooCache provides high performance cache primitives
@@ -456,6 +458,71 @@ public:
         return false;
     }
 };
+
+/**
+ * sharded_cache is a thread safe cache made of 2^ShardBits independent caches,
+ * each guarded by its own reader/writer lock.
+ *
+ * An element always lives in the shard picked by the top bits of its first
+ * hash (the underlying cache only uses the low bits), so an insert only blocks
+ * lookups that happen to fall into the same shard. With many validating
+ * threads, lookups rarely wait behind a writer at all.
+ *
+ * setup_bytes splits the requested memory evenly between the shards.
+ */
+template <typename Element, typename Hash, uint8_t ShardBits = 4>
+class sharded_cache {
+private:
+    static_assert(ShardBits > 0 && ShardBits < 16,
+                  "sharded_cache needs between 2 and 2^15 shards");
+
+    /** Padded to a cache line so neighbouring locks don't share one */
+    struct alignas(64) shard {
+        cache<Element, Hash> elements;
+        mutable std::shared_mutex mtx;
+    };
+
+    std::array<shard, size_t(1) << ShardBits> shards;
+
+    const Hash hash_function;
+
+    shard &get_shard(const Element &e) {
+        return shards[hash_function.template operator()<0>(e) >>
+                      (32 - ShardBits)];
+    }
+    const shard &get_shard(const Element &e) const {
+        return shards[hash_function.template operator()<0>(e) >>
+                      (32 - ShardBits)];
+    }
+
+public:
+    sharded_cache() : shards(), hash_function() {}
+
+    /**
+     * Not thread safe; call once before using the cache.
+     * @returns the maximum number of elements storable over all shards
+     */
+    uint32_t setup_bytes(size_t bytes) {
+        uint32_t total = 0;
+        for (shard &s : shards) {
+            total += s.elements.setup_bytes(bytes / shards.size());
+        }
+        return total;
+    }
+
+    inline void insert(Element e) {
+        shard &s = get_shard(e);
+        std::unique_lock<std::shared_mutex> lock(s.mtx);
+        s.elements.insert(std::move(e));
+    }
+
+    /** See cache::contains(); marking for erasure is safe under a shared lock */
+    inline bool contains(const Element &e, const bool erase) const {
+        const shard &s = get_shard(e);
+        std::shared_lock<std::shared_mutex> lock(s.mtx);
+        return s.elements.contains(e, erase);
+    }
+};
 } // namespace CuckooCache
 
 #endif
@@ -74,13 +74,53 @@ public:
     }
 };
 
-static leveldb::Options GetOptions(size_t nCacheSize) {
+CDBTuning CDBTuning::Chainstate() {
+    CDBTuning tuning;
+    // A larger filter saves a disk read on more of the lookups of coins that
+    // don't exist, and larger files keep a big coins database in fewer of
+    // them. Coins are small and already compactly serialized, so compressing
+    // them would mostly cost time on every read.
+    tuning.nBloomBitsPerKey =
+        std::max<int64_t>(0, gArgs.GetArg("-chainstatebloombits",
+                                          DEFAULT_CHAINSTATE_BLOOM_BITS));
+    tuning.nMaxFileSize =
+        std::max<int64_t>(0, gArgs.GetArg("-chainstatemaxfilesize",
+                                          DEFAULT_CHAINSTATE_MAX_FILE_SIZE))
+        << 20;
+    return tuning;
+}
+
+CDBTuning CDBTuning::BlockIndex() {
+    CDBTuning tuning;
+    tuning.fCompress = gArgs.GetBoolArg("-blockindexcompression",
+                                        DEFAULT_BLOCKINDEX_COMPRESSION);
+#ifndef SNAPPY
+    // LevelDB silently stores blocks uncompressed without Snappy
+    if (tuning.fCompress) {
+        LogPrintf("Block index compression was requested, but LevelDB is "
+                  "built without Snappy support. The block index will not "
+                  "be compressed.\n");
+        tuning.fCompress = false;
+    }
+#endif
+    return tuning;
+}
+
+static leveldb::Options GetOptions(size_t nCacheSize,
+                                   const CDBTuning &tuning) {
     leveldb::Options options;
     options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
     // up to two write buffers may be held in memory simultaneously
     options.write_buffer_size = nCacheSize / 4;
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
-    options.compression = leveldb::kNoCompression;
+    if (tuning.nBloomBitsPerKey > 0) {
+        options.filter_policy =
+            leveldb::NewBloomFilterPolicy(tuning.nBloomBitsPerKey);
+    }
+    options.compression = tuning.fCompress ? leveldb::kSnappyCompression
+                                           : leveldb::kNoCompression;
+    if (tuning.nMaxFileSize > 0) {
+        options.max_file_size = tuning.nMaxFileSize;
+    }
     options.max_open_files = 64;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 ||
@@ -93,13 +133,13 @@ static leveldb::Options GetOptions(size_t nCacheSize) {
 }
 
 CDBWrapper::CDBWrapper(const fs::path &path, size_t nCacheSize, bool fMemory,
-                       bool fWipe, bool obfuscate) {
+                       bool fWipe, bool obfuscate, const CDBTuning &tuning) {
     penv = nullptr;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = GetOptions(nCacheSize, tuning);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -19,6 +19,34 @@
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 
+//! -chainstatebloombits default
+static const int DEFAULT_CHAINSTATE_BLOOM_BITS = 16;
+//! -chainstatemaxfilesize default (MiB)
+static const int64_t DEFAULT_CHAINSTATE_MAX_FILE_SIZE = 32;
+//! -blockindexcompression default (off, as LevelDB is built without Snappy
+//! unless SNAPPY is defined)
+static const bool DEFAULT_BLOCKINDEX_COMPRESSION = false;
+
+/**
+ * LevelDB settings suited to what a particular database holds and how it is
+ * accessed. The defaults are the settings used for every database before
+ * there were profiles.
+ */
+struct CDBTuning {
+    //! Bits per key of the bloom filters used to skip tables on point lookups
+    int nBloomBitsPerKey = 10;
+    //! Compress table blocks with Snappy, when LevelDB is built with it
+    bool fCompress = false;
+    //! Size at which table files are split, or 0 for LevelDB's default
+    size_t nMaxFileSize = 0;
+
+    //! The unspent coins: random point lookups, many of them misses
+    static CDBTuning Chainstate();
+    //! The block index, which also holds the transaction index: read mostly
+    //! by iterating over it at startup, and compresses well
+    static CDBTuning BlockIndex();
+};
+
 class dbwrapper_error : public std::runtime_error {
 public:
     dbwrapper_error(const std::string &msg) : std::runtime_error(msg) {}
@@ -218,9 +246,11 @@ public:
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If
      * false, XOR
      *                        with a zero'd byte array.
+     * @param[in] tuning      LevelDB settings for the kind of data stored.
      */
     CDBWrapper(const fs::path &path, size_t nCacheSize, bool fMemory = false,
-               bool fWipe = false, bool obfuscate = false);
+               bool fWipe = false, bool obfuscate = false,
+               const CDBTuning &tuning = CDBTuning());
     ~CDBWrapper();
 
     template <typename K, typename V> bool Read(const K &key, V &value) const {
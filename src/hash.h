@@ -198,6 +198,45 @@ public:
     }
 };
 
+/**
+ * Reads from a source stream and hashes everything read, so that an object
+ * can be hashed in the same pass that deserializes it. Also counts the bytes
+ * read, which gives the object's serialized size.
+ */
+template <typename Source> class CHashingReader {
+private:
+    Source &source;
+    CHash256 ctx;
+    uint64_t nBytesRead = 0;
+
+public:
+    explicit CHashingReader(Source &source_) : source(source_) {}
+
+    int GetType() const { return source.GetType(); }
+    int GetVersion() const { return source.GetVersion(); }
+
+    void read(char *pch, size_t nSize) {
+        source.read(pch, nSize);
+        ctx.Write((const uint8_t *)pch, nSize);
+        nBytesRead += nSize;
+    }
+
+    uint64_t GetBytesRead() const { return nBytesRead; }
+
+    // invalidates the object
+    uint256 GetHash() {
+        uint256 result;
+        ctx.Finalize((uint8_t *)&result);
+        return result;
+    }
+
+    template <typename T> CHashingReader<Source> &operator>>(T &obj) {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+};
+
 /** Compute the 256-bit hash of an object's serialization. */
 template <typename T>
 uint256 SerializeHash(const T &obj, int nType = SER_GETHASH,
@@ -207,6 +246,8 @@ uint256 SerializeHash(const T &obj, int nType = SER_GETHASH,
     return ss.GetHash();
 }
 
+unsigned int MurmurHash3(unsigned int nHashSeed, const uint8_t *pDataToHash,
+                         size_t nDataSize);
 unsigned int MurmurHash3(unsigned int nHashSeed,
                          const std::vector<uint8_t> &vDataToHash);
 
@@ -11,6 +11,7 @@
 
 #include "addrman.h"
 #include "amount.h"
+#include "blockfileinfostore.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "checkpoints.h"
@@ -28,12 +29,14 @@
 #include "net_processing.h"
 #include "netbase.h"
 #include "policy/policy.h"
+#include "rpc/blockchain.h"
 #include "rpc/register.h"
 #include "rpc/server.h"
 #include "scheduler.h"
 #include "script/scriptcache.h"
 #include "script/sigcache.h"
 #include "script/standard.h"
+#include "task_helpers.h"
 #include "timedata.h"
 #include "torcontrol.h"
 #include "txdb.h"
@@ -236,11 +239,26 @@ void Shutdown() {
         fFeeEstimatesInitialized = false;
     }
 
+#if ENABLE_ZMQ
+    // Unregistering delivers the notifications still queued for ZMQ, which
+    // may read block data, so it has to happen before chain state goes away.
+    if (pzmqNotificationInterface) {
+        UnregisterValidationInterface(pzmqNotificationInterface);
+        delete pzmqNotificationInterface;
+        pzmqNotificationInterface = nullptr;
+    }
+#endif
+
     {
         LOCK(cs_main);
         if (pcoinsTip != nullptr) {
             FlushStateToDisk();
+            if (gArgs.GetBoolArg("-blockindexsnapshot",
+                                 DEFAULT_BLOCK_INDEX_SNAPSHOT)) {
+                DumpBlockIndexSnapshot();
+            }
         }
+        pBlockFileInfoStore->StopWriter();
         delete pcoinsTip;
         pcoinsTip = nullptr;
         delete pcoinscatcher;
@@ -256,14 +274,6 @@ void Shutdown() {
     }
 #endif
 
-#if ENABLE_ZMQ
-    if (pzmqNotificationInterface) {
-        UnregisterValidationInterface(pzmqNotificationInterface);
-        delete pzmqNotificationInterface;
-        pzmqNotificationInterface = nullptr;
-    }
-#endif
-
 #ifndef WIN32
     try {
         fs::remove(GetPidFile());
@@ -278,9 +288,11 @@ void Shutdown() {
     }
     vpwallets.clear();
 #endif
+    ShutdownParallelTaskPool();
     globalVerifyHandle.reset();
     ECC_Stop();
     LogPrintf("%s: done\n", __func__);
+    GetLogger().StopAsyncLogging();
 }
 
 /**
@@ -345,6 +357,12 @@ std::string HelpMessage(HelpMessageMode mode) {
         "-alertnotify=<cmd>",
         _("Execute command when a relevant alert is received or we see a "
           "really long fork (%s in cmd is replaced by message)"));
+    strUsage += HelpMessageOpt(
+        "-blockindexsnapshot",
+        strprintf(_("Whether to save a snapshot of the block index on "
+                    "shutdown and use it to speed up the next start "
+                    "(default: %u)"),
+                  DEFAULT_BLOCK_INDEX_SNAPSHOT));
     strUsage += HelpMessageOpt("-blocknotify=<cmd>",
                                _("Execute command when the best block changes "
                                  "(%s in cmd is replaced by block hash)"));
@@ -374,6 +392,21 @@ std::string HelpMessage(HelpMessageMode mode) {
     }
     strUsage += HelpMessageOpt("-datadir=<dir>", _("Specify data directory"));
     if (showDebug) {
+        strUsage += HelpMessageOpt(
+            "-blockindexcompression",
+            strprintf("Compress the block index database with Snappy when "
+                      "supported (default: %d)",
+                      DEFAULT_BLOCKINDEX_COMPRESSION));
+        strUsage += HelpMessageOpt(
+            "-chainstatebloombits=<n>",
+            strprintf("Bits per key of the chainstate database bloom filters, "
+                      "0 to disable them (default: %d)",
+                      DEFAULT_CHAINSTATE_BLOOM_BITS));
+        strUsage += HelpMessageOpt(
+            "-chainstatemaxfilesize=<n>",
+            strprintf("Size in MiB at which chainstate database files are "
+                      "split, 0 for the LevelDB default (default: %d)",
+                      DEFAULT_CHAINSTATE_MAX_FILE_SIZE));
         strUsage += HelpMessageOpt(
             "-dbbatchsize",
             strprintf(
@@ -424,6 +457,12 @@ std::string HelpMessage(HelpMessageMode mode) {
                     "0 = auto, <0 = leave that many cores free, default: %d)"),
                   -GetNumCores(), MAX_SCRIPTCHECK_THREADS,
                   DEFAULT_SCRIPTCHECK_THREADS));
+    strUsage += HelpMessageOpt(
+        "-parallelscriptcheckinputs=<n>",
+        strprintf(_("Check the scripts of a transaction being accepted to the "
+                    "mempool on all script verification threads if it has at "
+                    "least <n> inputs (default: %u)"),
+                  DEFAULT_PARALLEL_SCRIPTCHECK_INPUTS));
 #ifndef WIN32
     strUsage += HelpMessageOpt(
         "-pid=<file>",
@@ -755,6 +794,17 @@ std::string HelpMessage(HelpMessageMode mode) {
         "-logtimestamps",
         strprintf(_("Prepend debug output with timestamp (default: %d)"),
                   DEFAULT_LOGTIMESTAMPS));
+    strUsage += HelpMessageOpt(
+        "-logasync",
+        strprintf(_("Write bitcoind.log from a background thread, so logging "
+                    "never waits for the disk (default: %d)"),
+                  DEFAULT_LOGASYNC));
+    strUsage += HelpMessageOpt(
+        "-logasyncbuffer=<n>",
+        strprintf(_("Maximum size of log messages waiting to be written with "
+                    "-logasync in megabytes; further messages are dropped and "
+                    "counted (default: %u)"),
+                  DEFAULT_LOGASYNC_BUFFER));
     if (showDebug) {
         strUsage += HelpMessageOpt(
             "-logtimemicros",
@@ -781,6 +831,11 @@ std::string HelpMessage(HelpMessageMode mode) {
             "-maxsigcachesize=<n>",
             strprintf("Limit size of signature cache to <n> MiB (default: %u)",
                       DEFAULT_MAX_SIG_CACHE_SIZE));
+        strUsage += HelpMessageOpt(
+            "-maxpubkeycachesize=<n>",
+            strprintf("Limit size of parsed public key cache to <n> MiB "
+                      "(default: %u)",
+                      DEFAULT_MAX_PUBKEY_CACHE_SIZE));
         strUsage += HelpMessageOpt(
             "-maxscriptcachesize=<n>",
             strprintf("Limit size of script cache to <n> MiB (default: %u)",
@@ -914,6 +969,11 @@ std::string HelpMessage(HelpMessageMode mode) {
     strUsage += HelpMessageOpt(
         "-rest", strprintf(_("Accept public REST requests (default: %d)"),
                            DEFAULT_REST_ENABLE));
+    strUsage += HelpMessageOpt(
+        "-maxgetutxosoutpoints=<n>",
+        strprintf(_("Maximum number of outpoints that can be queried at once "
+                    "with /rest/getutxos or gettxouts (default: %u)"),
+                  DEFAULT_MAX_GETUTXOS_OUTPOINTS));
     strUsage += HelpMessageOpt(
         "-rpcbind=<addr>",
         _("Bind to given address to listen for JSON-RPC connections. Use "
@@ -1578,6 +1638,9 @@ bool AppInitParameterInteraction(Config &config) {
         nScriptCheckThreads = 0;
     else if (nScriptCheckThreads > MAX_SCRIPTCHECK_THREADS)
         nScriptCheckThreads = MAX_SCRIPTCHECK_THREADS;
+    nParallelScriptCheckInputs = std::max<int64_t>(
+        1, gArgs.GetArg("-parallelscriptcheckinputs",
+                        DEFAULT_PARALLEL_SCRIPTCHECK_INPUTS));
 
     // Configure preferred size of blockfile.
     config.SetPreferredBlockFileSize(
@@ -1921,6 +1984,11 @@ bool AppInitMain(Config &config, boost::thread_group &threadGroup,
 
     if (logger.fPrintToDebugLog) {
         logger.OpenDebugLog();
+        if (gArgs.GetBoolArg("-logasync", DEFAULT_LOGASYNC)) {
+            const int64_t bufferSize {std::max<int64_t>(
+                1, gArgs.GetArg("-logasyncbuffer", DEFAULT_LOGASYNC_BUFFER))};
+            logger.StartAsyncLogging(bufferSize * 1024 * 1024);
+        }
     }
 
     if (!logger.fLogTimestamps) {
@@ -1938,12 +2006,15 @@ bool AppInitMain(Config &config, boost::thread_group &threadGroup,
 
     InitSignatureCache();
     InitScriptExecutionCache();
+    InitParallelTaskPool(GetNumCores());
 
     LogPrintf("Using %u threads for script verification\n",
               nScriptCheckThreads);
     if (nScriptCheckThreads) {
         for (int i = 0; i < nScriptCheckThreads - 1; i++) {
             threadGroup.create_thread([i]() { return ThreadScriptCheck(i); });
+            threadGroup.create_thread(
+                [i]() { return ThreadMempoolScriptCheck(i); });
         }
     }
 
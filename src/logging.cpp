@@ -8,6 +8,10 @@
 #include "util.h"
 #include "utiltime.h"
 
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
 constexpr auto LOGFILE = "bitcoind.log";
 
 bool fLogIPs = DEFAULT_LOGIPS;
@@ -115,7 +119,12 @@ std::string ListLogCategories() {
     return ret;
 }
 
+static std::atomic<uint64_t> nextLoggerId{0};
+
+BCLog::Logger::Logger() : loggerId{++nextLoggerId} {}
+
 BCLog::Logger::~Logger() {
+    StopAsyncLogging();
     if (fileout) {
         fclose(fileout);
     }
@@ -146,6 +155,31 @@ std::string BCLog::Logger::LogTimestampStr(const std::string &str) {
     return strStamped;
 }
 
+int BCLog::Logger::WriteToDebugLog(const std::string &str) {
+    std::lock_guard<std::mutex> scoped_lock(mutexDebugLog);
+    return WriteToDebugLogNL(str);
+}
+
+int BCLog::Logger::WriteToDebugLogNL(const std::string &str) {
+    // Buffer if we haven't opened the log yet.
+    if (fileout == nullptr) {
+        vMsgsBeforeOpenLog.push_back(str);
+        return str.length();
+    }
+
+    // Reopen the log file, if requested.
+    if (fReopenDebugLog) {
+        fReopenDebugLog = false;
+        fs::path pathDebug = GetDataDir() / LOGFILE;
+        if (fsbridge::freopen(pathDebug, "a", fileout) != nullptr) {
+            // unbuffered.
+            setbuf(fileout, nullptr);
+        }
+    }
+
+    return FileWriteStr(str, fileout);
+}
+
 int BCLog::Logger::LogPrintStr(const std::string &str) {
     // Returns total number of characters written.
     int ret = 0;
@@ -157,27 +191,169 @@ int BCLog::Logger::LogPrintStr(const std::string &str) {
         ret = fwrite(strTimestamped.data(), 1, strTimestamped.size(), stdout);
         fflush(stdout);
     } else if (fPrintToDebugLog) {
-        std::lock_guard<std::mutex> scoped_lock(mutexDebugLog);
-
-        // Buffer if we haven't opened the log yet.
-        if (fileout == nullptr) {
-            ret = strTimestamped.length();
-            vMsgsBeforeOpenLog.push_back(strTimestamped);
+        const size_t size = strTimestamped.length();
+        if (fAsync && EnqueueAsync(strTimestamped)) {
+            ret = size;
         } else {
-            // Reopen the log file, if requested.
-            if (fReopenDebugLog) {
-                fReopenDebugLog = false;
-                fs::path pathDebug = GetDataDir() / LOGFILE;
-                if (fsbridge::freopen(pathDebug, "a", fileout) != nullptr) {
-                    // unbuffered.
-                    setbuf(fileout, nullptr);
-                }
+            ret = WriteToDebugLog(strTimestamped);
+        }
+    }
+    return ret;
+}
+
+BCLog::Logger::ThreadBuffer &BCLog::Logger::GetThreadBuffer() {
+    // Loggers are told apart by id rather than address, in case a destroyed
+    // logger's address is reused.
+    thread_local std::unordered_map<uint64_t, std::shared_ptr<ThreadBuffer>>
+        threadBuffers;
+
+    std::shared_ptr<ThreadBuffer> &buffer = threadBuffers[loggerId];
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(mutexThreadBuffers);
+        vThreadBuffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+bool BCLog::Logger::EnqueueAsync(std::string &str) {
+    ThreadBuffer &buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mtx);
+    // Checked again under the buffer lock: once StopAsyncLogging() has
+    // collected this buffer for the last time, the message has to be written
+    // synchronously instead.
+    if (!fAsync) {
+        return false;
+    }
+
+    const size_t size = str.size();
+    if (nBufferedBytes.fetch_add(size) + size > nMaxBufferedBytes) {
+        nBufferedBytes -= size;
+        ++nDropped;
+        return true;
+    }
+
+    // Taken under the buffer lock, so the messages of a thread are always
+    // ordered by sequence number.
+    buffer.messages.emplace_back(nextSequence++, std::move(str));
+    return true;
+}
+
+std::string BCLog::Logger::CollectAsync(bool fFinal) {
+    // A message's sequence number is taken under the lock of its thread
+    // buffer, and the buffers are locked below only after reading this, so
+    // every message numbered below it has already been buffered. Later ones
+    // may not have been, so they are held back for the next batch to keep
+    // the log in global order.
+    const uint64_t nLimit = fFinal ? std::numeric_limits<uint64_t>::max()
+                                   : nextSequence.load();
+
+    std::vector<std::pair<uint64_t, std::string>> &messages = vPendingMessages;
+    {
+        std::lock_guard<std::mutex> lock(mutexThreadBuffers);
+        for (auto it = vThreadBuffers.begin(); it != vThreadBuffers.end();) {
+            ThreadBuffer &buffer = **it;
+            std::unique_lock<std::mutex> bufferLock(buffer.mtx);
+            std::move(buffer.messages.begin(), buffer.messages.end(),
+                      std::back_inserter(messages));
+            buffer.messages.clear();
+            bufferLock.unlock();
+            // Forget the buffers of threads that have exited.
+            if (it->use_count() == 1) {
+                it = vThreadBuffers.erase(it);
+            } else {
+                ++it;
             }
+        }
+    }
+
+    // Merge the messages of all threads, and those held back last time, in
+    // the order in which they were logged.
+    std::sort(messages.begin(), messages.end(),
+              [](const std::pair<uint64_t, std::string> &a,
+                 const std::pair<uint64_t, std::string> &b) {
+                  return a.first < b.first;
+              });
+    const auto itHeldBack = std::find_if(
+        messages.begin(), messages.end(),
+        [nLimit](const std::pair<uint64_t, std::string> &message) {
+            return message.first >= nLimit;
+        });
+
+    std::string strBatch;
+    for (auto it = messages.begin(); it != itHeldBack; ++it) {
+        strBatch += it->second;
+    }
+    messages.erase(messages.begin(), itHeldBack);
+    nBufferedBytes -= strBatch.size();
 
-            ret = FileWriteStr(strTimestamped, fileout);
+    const uint64_t dropped = nDropped.load();
+    if (dropped != nReportedDropped) {
+        strBatch += strprintf("%d log messages dropped because the log buffer "
+                              "was full (-logasyncbuffer)\n",
+                              dropped - nReportedDropped);
+        nReportedDropped = dropped;
+    }
+    return strBatch;
+}
+
+void BCLog::Logger::FlushAsync() {
+    // The log file is unbuffered, so this is a single write of the batch.
+    const std::string strBatch = CollectAsync(false);
+    if (!strBatch.empty()) {
+        WriteToDebugLog(strBatch);
+    }
+}
+
+void BCLog::Logger::FlusherThread() {
+    RenameThread("bitcoin-logflush");
+    std::unique_lock<std::mutex> lock(mutexFlusher);
+    while (!fStopFlusher) {
+        cvFlusher.wait_for(lock, std::chrono::milliseconds(100));
+        lock.unlock();
+        FlushAsync();
+        lock.lock();
+    }
+}
+
+void BCLog::Logger::StartAsyncLogging(size_t maxBufferedBytes) {
+    if (fPrintToConsole || !fPrintToDebugLog || fAsync) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> scoped_lock(mutexDebugLog);
+        if (fileout == nullptr) {
+            return;
         }
     }
-    return ret;
+
+    nMaxBufferedBytes = maxBufferedBytes;
+    fStopFlusher = false;
+    flusherThread = std::thread(&BCLog::Logger::FlusherThread, this);
+    fAsync = true;
+}
+
+void BCLog::Logger::StopAsyncLogging() {
+    if (!fAsync) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutexFlusher);
+        fStopFlusher = true;
+    }
+    cvFlusher.notify_one();
+    flusherThread.join();
+
+    // Stop accepting messages and write out everything still buffered. The
+    // log stays locked until then, so that messages written synchronously
+    // from now on can't overtake buffered ones. Collecting the buffers after
+    // clearing the flag guarantees that no message is buffered after it.
+    std::lock_guard<std::mutex> scoped_lock(mutexDebugLog);
+    fAsync = false;
+    const std::string strBatch = CollectAsync(true);
+    if (!strBatch.empty()) {
+        WriteToDebugLogNL(strBatch);
+    }
 }
 
 void BCLog::Logger::ShrinkDebugFile() {
@@ -8,16 +8,23 @@
 #define BITCOIN_LOGGING_H
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "tinyformat.h"
 
 static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
+static const bool DEFAULT_LOGASYNC = false;
+/** Default for -logasyncbuffer, in megabytes */
+static const size_t DEFAULT_LOGASYNC_BUFFER = 16;
 
 extern bool fLogIPs;
 
@@ -54,10 +61,39 @@ enum LogFlags : uint32_t {
 
 class Logger {
 private:
+    /**
+     * Messages of one thread waiting to be written by the asynchronous
+     * flusher. Only the owning thread and the flusher use the mutex, so
+     * logging threads never wait for each other or for the disk.
+     */
+    struct ThreadBuffer {
+        std::mutex mtx;
+        // Global sequence number and text of every pending message
+        std::vector<std::pair<uint64_t, std::string>> messages;
+    };
+
     FILE *fileout = nullptr;
     std::mutex mutexDebugLog;
     std::list<std::string> vMsgsBeforeOpenLog;
 
+    // Asynchronous logging state
+    std::atomic<bool> fAsync{false};
+    std::atomic<uint64_t> nextSequence{0};
+    std::atomic<size_t> nBufferedBytes{0};
+    std::atomic<uint64_t> nDropped{0};
+    uint64_t nReportedDropped = 0;
+    size_t nMaxBufferedBytes = 0;
+    const uint64_t loggerId;
+    std::mutex mutexThreadBuffers;
+    std::vector<std::shared_ptr<ThreadBuffer>> vThreadBuffers;
+    // Collected messages held back until all earlier ones have been buffered;
+    // only used by the flusher (and by StopAsyncLogging once it has stopped)
+    std::vector<std::pair<uint64_t, std::string>> vPendingMessages;
+    std::mutex mutexFlusher;
+    std::condition_variable cvFlusher;
+    bool fStopFlusher = false;
+    std::thread flusherThread;
+
     /**
      * fStartedNewLine is a state variable that will suppress printing of the
      * timestamp when multiple calls are made that don't end in a newline.
@@ -72,6 +108,26 @@ private:
 
     std::string LogTimestampStr(const std::string &str);
 
+    /** Write to the debug log file, reopening it first if requested */
+    int WriteToDebugLog(const std::string &str);
+    /** Same as WriteToDebugLog, with mutexDebugLog already held */
+    int WriteToDebugLogNL(const std::string &str);
+
+    ThreadBuffer &GetThreadBuffer();
+    /**
+     * Buffer a message (or drop it if the buffer is full); returns false if
+     * asynchronous logging has stopped and it must be written directly.
+     */
+    bool EnqueueAsync(std::string &str);
+    /**
+     * Take the buffered messages that can be written in global order, or all
+     * of them if fFinal, and return them as a single batch
+     */
+    std::string CollectAsync(bool fFinal);
+    /** Write out everything the logging threads have buffered so far */
+    void FlushAsync();
+    void FlusherThread();
+
 public:
     bool fPrintToConsole = false;
     bool fPrintToDebugLog = true;
@@ -81,6 +137,7 @@ public:
 
     std::atomic<bool> fReopenDebugLog{false};
 
+    Logger();
     ~Logger();
 
     /** Send a string to the log output */
@@ -89,6 +146,23 @@ public:
     void OpenDebugLog();
     void ShrinkDebugFile();
 
+    /**
+     * Write debug log messages from a background thread.
+     *
+     * Messages are still formatted and timestamped by the logging thread, but
+     * only appended to a buffer of that thread. Once more than
+     * maxBufferedBytes are waiting, new messages are dropped and counted
+     * instead of blocking the caller; the flusher notes the number of dropped
+     * messages in the log. Has no effect unless logging to the debug log.
+     */
+    void StartAsyncLogging(size_t maxBufferedBytes);
+    /**
+     * Go back to synchronous logging, writing out all pending messages first
+     */
+    void StopAsyncLogging();
+    /** Number of messages dropped because the asynchronous buffer was full */
+    uint64_t GetDroppedMessages() const { return nDropped; }
+
     void EnableCategory(LogFlags category);
     void DisableCategory(LogFlags category);
 
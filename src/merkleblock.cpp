@@ -12,54 +12,44 @@
 #include "utilstrencodings.h"
 #include "streams.h"
 
-CMerkleBlock::CMerkleBlock(const CBlock &block, CBloomFilter &filter) {
-    header = block.GetBlockHeader();
-
-    std::vector<bool> vMatch;
-    std::vector<uint256> vHashes;
-
-    vMatch.reserve(block.vtx.size());
-    vHashes.reserve(block.vtx.size());
-
-    for (size_t i = 0; i < block.vtx.size(); i++) {
-        const CTransaction *tx = block.vtx[i].get();
-        const uint256 &txid = tx->GetId();
-        if (filter.IsRelevantAndUpdate(*tx)) {
-            vMatch.push_back(true);
-            vMatchedTxn.push_back(std::make_pair(i, txid));
-        } else {
-            vMatch.push_back(false);
-        }
-
-        vHashes.push_back(txid);
+CFilterableBlock::CFilterableBlock(const CBlock &block)
+    : header{block.GetBlockHeader()} {
+    for (const CTransactionRef &tx : block.vtx) {
+        elements.AddTransaction(*tx);
     }
+}
 
-    txn = CPartialMerkleTree(vHashes, vMatch);
+CFilterableBlock::CFilterableBlock(CBlockStreamReader<CFileReader> &stream)
+    : header{stream.GetBlockHeader()} {
+    do {
+        elements.AddTransaction(stream.ReadTransaction());
+    } while (!stream.EndOfStream());
 }
 
-CMerkleBlock::CMerkleBlock(
-    CBlockStreamReader<CFileReader>& stream,
-    CBloomFilter& filter)
-    : header{stream.GetBlockHeader()}
-{
+CMerkleBlock::CMerkleBlock(const CBlock &block, CBloomFilter &filter)
+    : CMerkleBlock(CFilterableBlock(block), filter) {}
+
+CMerkleBlock::CMerkleBlock(const CFilterableBlock &block, CBloomFilter &filter)
+    : header{block.GetHeader()} {
+    const CBloomElements &elements = block.GetElements();
+
     std::vector<bool> vMatch;
     std::vector<uint256> vHashes;
 
-    vMatch.reserve(stream.GetRemainingTransactionsCount());
-    vHashes.reserve(stream.GetRemainingTransactionsCount());
-    do
-    {
-        const CTransaction& transaction = stream.ReadTransaction();
-        const uint256& txid = transaction.GetId();
-        if (filter.IsRelevantAndUpdate(transaction)) {
-            vMatchedTxn.emplace_back(vMatch.size(), txid);
+    vMatch.reserve(elements.GetTransactionCount());
+    vHashes.reserve(elements.GetTransactionCount());
+
+    for (size_t i = 0; i < elements.GetTransactionCount(); i++) {
+        const uint256 &txid = elements.GetTxId(i);
+        if (filter.IsRelevantAndUpdate(elements, i)) {
             vMatch.push_back(true);
+            vMatchedTxn.push_back(std::make_pair(i, txid));
         } else {
             vMatch.push_back(false);
         }
 
         vHashes.push_back(txid);
-    } while(!stream.EndOfStream());
+    }
 
     txn = CPartialMerkleTree(vHashes, vMatch);
 }
@@ -145,6 +145,25 @@ public:
                            std::vector<unsigned int> &vnIndex);
 };
 
+/**
+ * A block parsed once into what CMerkleBlock needs to filter it, so it can be
+ * served to many filtered peers without being read and parsed for each one.
+ */
+class CFilterableBlock {
+public:
+    explicit CFilterableBlock(const CBlock &block);
+    explicit CFilterableBlock(CBlockStreamReader<CFileReader> &stream);
+
+    const CBlockHeader &GetHeader() const { return header; }
+    const CBloomElements &GetElements() const { return elements; }
+
+    size_t DynamicMemoryUsage() const { return elements.DynamicMemoryUsage(); }
+
+private:
+    CBlockHeader header;
+    CBloomElements elements;
+};
+
 /**
  * Used to relay blocks as header + vector<merkle branch>
  * to filtered nodes.
@@ -168,7 +187,35 @@ public:
      * transaction, thus the filter will likely be modified.
      */
     CMerkleBlock(const CBlock &block, CBloomFilter &filter);
-    CMerkleBlock(CBlockStreamReader<CFileReader>& stream, CBloomFilter &filter);
+    CMerkleBlock(const CFilterableBlock &block, CBloomFilter &filter);
+
+    /**
+     * Same as above for a block read from the stream one transaction at a
+     * time, for blocks too large to hold as a CFilterableBlock.
+     */
+    template <typename Reader>
+    CMerkleBlock(CBlockStreamReader<Reader> &stream, CBloomFilter &filter)
+        : header{stream.GetBlockHeader()} {
+        std::vector<bool> vMatch;
+        std::vector<uint256> vHashes;
+
+        vMatch.reserve(stream.GetRemainingTransactionsCount());
+        vHashes.reserve(stream.GetRemainingTransactionsCount());
+        do {
+            const CTransaction &transaction = stream.ReadTransaction();
+            const uint256 &txid = transaction.GetId();
+            if (filter.IsRelevantAndUpdate(transaction)) {
+                vMatchedTxn.emplace_back(vMatch.size(), txid);
+                vMatch.push_back(true);
+            } else {
+                vMatch.push_back(false);
+            }
+
+            vHashes.push_back(txid);
+        } while (!stream.EndOfStream());
+
+        txn = CPartialMerkleTree(vHashes, vMatch);
+    }
 
     /**
      * Create from a CBlock, matching the txids in the set.
@@ -238,8 +238,7 @@ bool LegacyBlockAssembler::TestPackageTransactions(
             return false;
         }
 
-        uint64_t nTxSize =
-            ::GetSerializeSize(it->GetTx(), SER_NETWORK, PROTOCOL_VERSION);
+        uint64_t nTxSize = it->GetTx().GetTotalSize();
         if (nPotentialBlockSize + nTxSize >= nMaxGeneratedBlockSize) {
             return false;
         }
@@ -251,9 +250,7 @@ bool LegacyBlockAssembler::TestPackageTransactions(
 }
 
 bool LegacyBlockAssembler::TestForBlock(CTxMemPool::txiter it) {
-    auto blockSizeWithTx =
-        nBlockSize +
-        ::GetSerializeSize(it->GetTx(), SER_NETWORK, PROTOCOL_VERSION);
+    auto blockSizeWithTx = nBlockSize + it->GetTx().GetTotalSize();
     if (blockSizeWithTx >= nMaxGeneratedBlockSize) {
         if (nBlockSize > nMaxGeneratedBlockSize - 100 || lastFewTxs > 50) {
             blockFinished = true;
@@ -702,12 +702,6 @@ void CNode::copyStats(CNodeStats &stats) {
     CService addrLocalUnlocked = GetAddrLocal();
     stats.addrLocal =
         addrLocalUnlocked.IsValid() ? addrLocalUnlocked.ToString() : "";
-
-    {
-        // Fetch size of inventory queue
-        LOCK(cs_mInvList);
-        stats.nInvQueueSize = mInvList.size();
-    }
 }
 
 static bool IsOversizedMessage(const Config &config, const CNetMessage &msg) {
@@ -720,12 +714,13 @@ static bool IsOversizedMessage(const Config &config, const CNetMessage &msg) {
 }
 
 /**
-* Add some new transactions to our pending inventory list.
-* Assumes the caller has taken care of locking access to the mempool,
-* and so can be called in parallel.
+* Fetch the next N transactions for us to announce from the shared log,
+* applying our own filtering to what we find there.
 */
-void CNode::AddTxnsToInventory(const std::vector<CTxnSendingDetails>& txns)
+std::vector<CTxnSendingDetails> CNode::FetchNInventory(const CTxnAnnouncementLog& log, size_t n)
 {
+    std::vector<CTxnSendingDetails> results {};
+
     // Get our minimum fee
     Amount filterrate {0};
     {   
@@ -738,73 +733,33 @@ void CNode::AddTxnsToInventory(const std::vector<CTxnSendingDetails>& txns)
     // inventory before cs_filter to prevent deadlocks
     LOCK(cs_inventory);
     LOCK(cs_filter);
-    LOCK(cs_mInvList);
 
+    CTxnAnnouncementLog::Cursor cursor { mTxnAnnouncementCursor };
     if(!fRelayTxes)
     {
-        // Peer has requested we not relay txns
-        if(!mInvList.empty())
-        {
-            // Clear any txns we have queued for this peer
-            mInvList = InvList{ CompareTxnSendingDetails{&mempool} };
-        }
+        // Peer has requested we not relay txns, so just skip past them
+        cursor = log.getEndCursor();
     }
     else
     {
-        for(const CTxnSendingDetails& txn : txns)
-        {
+        results.reserve(n);
+        log.read(cursor, n, [this, &filterrate, &results](const CTxnSendingDetails& txn) {
             // Don't bother if below peer's fee rate
             if(filterrate != Amount{0} && txn.getInfo().feeRate.GetFeePerK() < filterrate)
-                continue;
+                return false;
 
             // Check and update bloom filters
             if(filterInventoryKnown.contains(txn.getInv().hash))
-                continue;
+                return false;
             if(pfilter && !pfilter->IsRelevantAndUpdate(*(txn.getTxnRef())))
-                continue;
+                return false;
 
-            mInvList.emplace(txn);
+            results.emplace_back(txn);
             filterInventoryKnown.insert(txn.getInv().hash);
-        }
-    }
-}
-
-/**
-* Remove some transactions from our pending inventory list.
-* Assumes the caller has taken care of locking access to the mempool,
-* and so can be called in parallel.
-*/
-void CNode::RemoveTxnsFromInventory(const std::vector<CTxnSendingDetails>& txns)
-{
-    // Remove them
-    LOCK(cs_mInvList);
-    mInvList.erase(txns);
-}
-
-/** Fetch the next N items from our inventory */
-std::vector<CTxnSendingDetails> CNode::FetchNInventory(size_t n)
-{
-    std::vector<CTxnSendingDetails> results {};
-
-    // Try and lock the mempool (for txn ordering) and our inventory list,
-    // if we fail to take either then don't hold up the caller by waiting.
-    std::shared_lock lock(mempool.smtx, std::defer_lock);
-    bool mempoolLocked {false};
-    if (lock.try_lock()) {
-        mempoolLocked = true;
-    }
-    TRY_LOCK(cs_mInvList, invLocked);
-    if(!mempoolLocked || !invLocked)
-        return results;
-
-    for(size_t i = 0; i < n; ++i)
-    {
-        if(mInvList.empty())
-            break;
-
-        results.emplace_back(std::move(mInvList.top()));
-        mInvList.pop();
+            return true;
+        });
     }
+    mTxnAnnouncementCursor = cursor;
 
     return results;
 }
@@ -2801,9 +2756,12 @@ void CConnman::GetNodeStats(std::vector<CNodeStats> &vstats) {
     vstats.clear();
     LOCK(cs_vNodes);
     vstats.reserve(vNodes.size());
+    const CTxnAnnouncementLog& log { mTxnPropagator->getAnnouncementLog() };
     for (const CNodePtr& pnode : vNodes) {
         vstats.emplace_back();
         pnode->copyStats(vstats.back());
+        // Logged transactions the peer has yet to read, before its own filtering
+        vstats.back().nInvQueueSize = log.getUnreadTxnCount(pnode->GetTxnAnnouncementCursor());
     }
 }
 
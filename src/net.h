@@ -16,7 +16,6 @@
 #include "fs.h"
 #include "hash.h"
 #include "limitedmap.h"
-#include "mod_pri_queue.h"
 #include "netaddress.h"
 #include "protocol.h"
 #include "random.h"
@@ -25,6 +24,7 @@
 #include "task_helpers.h"
 #include "threadinterrupt.h"
 #include "txmempool.h"
+#include "txn_announcement_log.h"
 #include "txn_sending_details.h"
 #include "uint256.h"
 #include "validation.h"
@@ -944,10 +944,8 @@ private:
     CService addrLocal {};
     mutable CCriticalSection cs_addrLocal {};
 
-    /** List of priority sorted inventory msgs for transactions to send */
-    using InvList = CModPriQueue<CTxnSendingDetails, std::vector<CTxnSendingDetails>, CompareTxnSendingDetails>;
-    InvList mInvList { CompareTxnSendingDetails{&mempool} };
-    CCriticalSection cs_mInvList {};
+    /** Our position in the shared log of new transactions to announce */
+    std::atomic<CTxnAnnouncementLog::Cursor> mTxnAnnouncementCursor { CTxnAnnouncementLog::UNSET_CURSOR };
 
 
 public:
@@ -957,12 +955,11 @@ public:
         CForwardAsyncReadonlyStream& data,
         size_t maxChunkSize);
 
-    /** Add some new transactions to our pending inventory list */
-    void AddTxnsToInventory(const std::vector<CTxnSendingDetails>& txns);
-    /** Remove some transactions from our pending inventroy list */
-    void RemoveTxnsFromInventory(const std::vector<CTxnSendingDetails>& txns);
-    /** Fetch the next N items from our inventory */
-    std::vector<CTxnSendingDetails> FetchNInventory(size_t n);
+    /** Fetch the next N transactions for us to announce from the shared log */
+    std::vector<CTxnSendingDetails> FetchNInventory(const CTxnAnnouncementLog& log, size_t n);
+    /** Get/set our position in the shared log of new transactions to announce */
+    CTxnAnnouncementLog::Cursor GetTxnAnnouncementCursor() const { return mTxnAnnouncementCursor; }
+    void SetTxnAnnouncementCursor(CTxnAnnouncementLog::Cursor cursor) { mTxnAnnouncementCursor = cursor; }
 
     NodeId GetId() const { return id; }
 
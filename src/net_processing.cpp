@@ -29,6 +29,7 @@
 #include "primitives/transaction.h"
 #include "random.h"
 #include "tinyformat.h"
+#include "txn_propagator.h"
 #include "txmempool.h"
 #include "ui_interface.h"
 #include "util.h"
@@ -1194,6 +1195,85 @@ static void SendBlock(
     connman.PushMessage(pfrom, std::move(blockMsg));
 }
 
+// Blocks recently parsed for filtered peers, most recently used first. SPV
+// clients mostly ask for the same few blocks near the tip, so each of them is
+// read and parsed once rather than once per peer.
+static const size_t MAX_FILTERABLE_BLOCKS_CACHED = 4;
+// Larger blocks (by their size on disk) are streamed from disk and matched
+// against the filter for each request instead, in bounded memory.
+static const size_t MAX_FILTERABLE_BLOCK_CACHED_SIZE = 256 * ONE_MEGABYTE;
+static CCriticalSection cs_filterable_blocks;
+static std::list<std::pair<uint256, std::shared_ptr<const CFilterableBlock>>>
+    filterableBlocks;
+
+static std::shared_ptr<const CFilterableBlock>
+GetFilterableBlock(const CBlockIndex &index) {
+    const uint256 hash = index.GetBlockHash();
+    {
+        LOCK(cs_filterable_blocks);
+        for (auto it = filterableBlocks.begin(); it != filterableBlocks.end();
+             ++it) {
+            if (it->first == hash) {
+                filterableBlocks.splice(filterableBlocks.begin(),
+                                        filterableBlocks, it);
+                return it->second;
+            }
+        }
+    }
+
+    auto stream = GetDiskBlockStreamReader(index.GetBlockPos());
+    if (!stream) {
+        assert(!"can not load block from disk");
+    }
+    auto block = std::make_shared<const CFilterableBlock>(*stream);
+
+    LOCK(cs_filterable_blocks);
+    filterableBlocks.emplace_front(hash, block);
+    if (filterableBlocks.size() > MAX_FILTERABLE_BLOCKS_CACHED) {
+        filterableBlocks.pop_back();
+    }
+
+    return block;
+}
+
+// The size of a block's data on disk, known without reading the block
+static uint64_t GetBlockDiskSize(const CBlockIndex &index) {
+    if (index.nStatus.hasDiskBlockMetaData()) {
+        return index.GetDiskBlockMetaData().diskDataSize;
+    }
+
+    // Otherwise take it from the header in front of the block in its file
+    CDiskBlockPos pos = index.GetBlockPos();
+    if (pos.nPos < sizeof(uint32_t)) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    pos.nPos -= sizeof(uint32_t);
+    CAutoFile file(CDiskFiles::OpenBlockFile(pos, true), SER_DISK,
+                   CLIENT_VERSION);
+    uint32_t nSize = 0;
+    try {
+        file >> nSize;
+    } catch (const std::exception &) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    return nSize;
+}
+
+// Filter a block for a peer. Blocks small enough to cache are matched against
+// their cached CFilterableBlock; larger ones are streamed from disk.
+static CMerkleBlock FilterBlock(const CBlockIndex &index,
+                                CBloomFilter &filter) {
+    if (GetBlockDiskSize(index) <= MAX_FILTERABLE_BLOCK_CACHED_SIZE) {
+        return CMerkleBlock(*GetFilterableBlock(index), filter);
+    }
+
+    auto stream = GetDiskBlockStreamReader(index.GetBlockPos());
+    if (!stream) {
+        assert(!"can not load block from disk");
+    }
+    return CMerkleBlock(*stream, filter);
+}
+
 static void SendUnseenTransactions(
     // requires: ascending ordered
     const std::vector<std::pair<unsigned int, uint256>>& vOrderedUnseenTransactions,
@@ -1342,20 +1422,14 @@ static void ProcessGetData(const Config &config, const CNodePtr& pfrom,
                             connman,
                             *mi->second);
                     } else if (inv.type == MSG_FILTERED_BLOCK) {
-                        auto stream =
-                            GetDiskBlockStreamReader(mi->second->GetBlockPos());
-                        if (!stream) {
-                            assert(!"can not load block from disk");
-                        }
-
                         bool sendMerkleBlock = false;
                         CMerkleBlock merkleBlock;
                         {
                             LOCK(pfrom->cs_filter);
                             if (pfrom->pfilter) {
                                 sendMerkleBlock = true;
-                                merkleBlock =
-                                    CMerkleBlock(*stream, *pfrom->pfilter);
+                                merkleBlock = FilterBlock(*mi->second,
+                                                          *pfrom->pfilter);
                             }
                         }
                         if (sendMerkleBlock) {
@@ -1779,6 +1853,12 @@ static void ProcessVerAckMessage(const CNodePtr& pfrom, const CNetMsgMaker& msgM
                                           fAnnounceUsingCMPCTBLOCK,
                                           nCMPCTBLOCKVersion));
     }
+
+    // Start announcing any new transactions to the peer from this point on.
+    // This must happen before we are marked as connected, after which our
+    // position in the log is taken into account when it is trimmed.
+    pfrom->SetTxnAnnouncementCursor(
+        connman.getTransactionPropagator()->getAnnouncementLog().getEndCursor());
     pfrom->fSuccessfullyConnected = true;
 }
 
@@ -3846,7 +3926,10 @@ void SendTxnInventory(const Config &config, const CNodePtr& pto, CConnman &connm
     std::vector<CInv>& vInv)
 {
     // Get as many TX inventory msgs to send as we can for this peer
-    std::vector<CTxnSendingDetails> vInvTx { pto->FetchNInventory(GetInventoryBroadcastMax(config)) };
+    std::vector<CTxnSendingDetails> vInvTx {
+        pto->FetchNInventory(connman.getTransactionPropagator()->getAnnouncementLog(),
+                             GetInventoryBroadcastMax(config))
+    };
 
     int64_t nNow = GetTimeMicros();
 
@@ -3925,6 +4008,8 @@ void SendInventory(const Config &config, const CNodePtr& pto, CConnman &connman,
 
         LOCK(pto->cs_filter);
 
+        std::vector<uint256> vKnown;
+        vKnown.reserve(vtxinfo.size());
         for (const auto &txinfo : vtxinfo) {
             const uint256 &txid = txinfo.tx->GetId();
             CInv inv(MSG_TX, txid);
@@ -3939,7 +4024,7 @@ void SendInventory(const Config &config, const CNodePtr& pto, CConnman &connman,
                     continue;
                 }
             }
-            pto->filterInventoryKnown.insert(txid);
+            vKnown.push_back(txid);
             vInv.push_back(inv);
             // if next element will cause too large message, then we send it now, as message size is still under limit
             if (vInv.size() == pto->maxInvElements) {
@@ -3947,6 +4032,7 @@ void SendInventory(const Config &config, const CNodePtr& pto, CConnman &connman,
                 vInv.clear();
             }
         }
+        pto->filterInventoryKnown.insert(vKnown);
         pto->timeLastMempoolReq = GetTime();
     }
 
@@ -54,8 +54,11 @@ TxHash CMutableTransaction::GetHash() const {
     return TxHash(ComputeCMutableTransactionHash(*this));
 }
 
-uint256 CTransaction::ComputeHash() const {
-    return SerializeHash(*this, SER_GETHASH, 0);
+CTransaction::Hashed CTransaction::HashTransaction(CMutableTransaction &&tx) {
+    const uint256 hash = SerializeHash(tx, SER_GETHASH, 0);
+    const unsigned int nTotalSize =
+        ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
+    return {std::move(tx), hash, nTotalSize};
 }
 
 /**
@@ -64,13 +67,16 @@ uint256 CTransaction::ComputeHash() const {
  */
 CTransaction::CTransaction()
     : nVersion(CTransaction::CURRENT_VERSION), vin(), vout(), nLockTime(0),
-      hash() {}
+      hash(), nTotalSize(::GetSerializeSize(*this, SER_NETWORK,
+                                            PROTOCOL_VERSION)) {}
 CTransaction::CTransaction(const CMutableTransaction &tx)
-    : nVersion(tx.nVersion), vin(tx.vin), vout(tx.vout),
-      nLockTime(tx.nLockTime), hash(ComputeHash()) {}
+    : CTransaction(HashTransaction(CMutableTransaction(tx))) {}
 CTransaction::CTransaction(CMutableTransaction &&tx)
-    : nVersion(tx.nVersion), vin(std::move(tx.vin)), vout(std::move(tx.vout)),
-      nLockTime(tx.nLockTime), hash(ComputeHash()) {}
+    : CTransaction(HashTransaction(std::move(tx))) {}
+CTransaction::CTransaction(Hashed &&tx)
+    : nVersion(tx.tx.nVersion), vin(std::move(tx.tx.vin)),
+      vout(std::move(tx.tx.vout)), nLockTime(tx.tx.nLockTime), hash(tx.hash),
+      nTotalSize(tx.nTotalSize) {}
 
 Amount CTransaction::GetValueOut() const {
     Amount nValueOut(0);
@@ -109,10 +115,6 @@ unsigned int CTransaction::CalculateModifiedSize(unsigned int nTxSize) const {
     return nTxSize;
 }
 
-unsigned int CTransaction::GetTotalSize() const {
-    return ::GetSerializeSize(*this, SER_NETWORK, PROTOCOL_VERSION);
-}
-
 std::string CTransaction::ToString() const {
     std::string str;
     str += strprintf("CTransaction(txid=%s, ver=%d, vin.size=%u, vout.size=%u, "
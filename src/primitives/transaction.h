@@ -7,6 +7,7 @@
 #define BITCOIN_PRIMITIVES_TRANSACTION_H
 
 #include "amount.h"
+#include "hash.h"
 #include "script/script.h"
 #include "serialize.h"
 #include "uint256.h"
@@ -270,8 +271,13 @@ public:
 private:
     /** Memory only. */
     const uint256 hash;
+    const unsigned int nTotalSize;
 
-    uint256 ComputeHash() const;
+    /** Transaction fields together with their hash and serialized size */
+    struct Hashed;
+    explicit CTransaction(Hashed &&tx);
+    static Hashed HashTransaction(CMutableTransaction &&tx);
+    template <typename Stream> static Hashed UnserializeHashed(Stream &s);
 
 public:
     /** Construct a CTransaction that qualifies as IsNull() */
@@ -288,11 +294,10 @@ public:
     /**
      * This deserializing constructor is provided instead of an Unserialize
      * method. Unserialize is not possible, since it would require overwriting
-     * const fields.
+     * const fields. The hash and size are taken from the bytes as they are
+     * read, rather than by serializing the transaction again.
      */
-    template <typename Stream>
-    CTransaction(deserialize_type, Stream &s)
-        : CTransaction(CMutableTransaction(deserialize, s)) {}
+    template <typename Stream> CTransaction(deserialize_type, Stream &s);
 
     bool IsNull() const { return vin.empty() && vout.empty(); }
 
@@ -316,7 +321,7 @@ public:
      * Get the total transaction size in bytes.
      * @return Total transaction size in bytes
      */
-    unsigned int GetTotalSize() const;
+    unsigned int GetTotalSize() const { return nTotalSize; }
 
     bool IsCoinBase() const {
         return (vin.size() == 1 && vin[0].prevout.IsNull());
@@ -373,6 +378,24 @@ public:
     }
 };
 
+struct CTransaction::Hashed {
+    CMutableTransaction tx;
+    uint256 hash;
+    unsigned int nTotalSize;
+};
+
+template <typename Stream>
+CTransaction::Hashed CTransaction::UnserializeHashed(Stream &s) {
+    CHashingReader<Stream> reader(s);
+    CMutableTransaction tx(deserialize, reader);
+    return {std::move(tx), reader.GetHash(),
+            static_cast<unsigned int>(reader.GetBytesRead())};
+}
+
+template <typename Stream>
+CTransaction::CTransaction(deserialize_type, Stream &s)
+    : CTransaction(UnserializeHashed(s)) {}
+
 typedef std::shared_ptr<const CTransaction> CTransactionRef;
 static inline CTransactionRef MakeTransactionRef() {
     return std::make_shared<const CTransaction>();
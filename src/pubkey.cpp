@@ -167,15 +167,34 @@ static int ecdsa_signature_parse_der_lax(const secp256k1_context *ctx,
     return 1;
 }
 
+static_assert(sizeof(CParsedPubKey) == sizeof(secp256k1_pubkey),
+              "CParsedPubKey must hold a secp256k1_pubkey");
+
 bool CPubKey::Verify(const uint256 &hash,
                      const std::vector<uint8_t> &vchSig) const {
+    CParsedPubKey parsed;
+    if (!Parse(parsed)) {
+        return false;
+    }
+    return Verify(hash, vchSig, parsed);
+}
+
+bool CPubKey::Parse(CParsedPubKey &parsed) const {
     if (!IsValid()) return false;
     secp256k1_pubkey pubkey;
-    secp256k1_ecdsa_signature sig;
     if (!secp256k1_ec_pubkey_parse(secp256k1_context_verify, &pubkey,
                                    &(*this)[0], size())) {
         return false;
     }
+    memcpy(parsed.data, &pubkey, sizeof(pubkey));
+    return true;
+}
+
+bool CPubKey::Verify(const uint256 &hash, const std::vector<uint8_t> &vchSig,
+                     const CParsedPubKey &parsed) {
+    secp256k1_pubkey pubkey;
+    secp256k1_ecdsa_signature sig;
+    memcpy(&pubkey, parsed.data, sizeof(pubkey));
     if (vchSig.size() == 0) {
         return false;
     }
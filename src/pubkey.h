@@ -34,6 +34,15 @@ public:
 
 typedef uint256 ChainCode;
 
+/**
+ * A public key parsed into the representation libsecp256k1 verifies against.
+ * Parsing a compressed key means recovering its y coordinate, so keeping the
+ * parsed form around saves that work when the same key is seen again.
+ */
+struct CParsedPubKey {
+    uint8_t data[64];
+};
+
 /** An encapsulated public key. */
 class CPubKey {
 private:
@@ -137,6 +146,13 @@ public:
      */
     bool Verify(const uint256 &hash, const std::vector<uint8_t> &vchSig) const;
 
+    //! Parse this public key for Verify(); false if it is not fully valid.
+    bool Parse(CParsedPubKey &parsed) const;
+
+    //! Verify a DER signature against an already parsed public key.
+    static bool Verify(const uint256 &hash, const std::vector<uint8_t> &vchSig,
+                       const CParsedPubKey &parsed);
+
     /**
      * Check whether a signature is normalized (lower-S).
      */
@@ -11,11 +11,13 @@
 #include "primitives/block.h"
 #include "primitives/transaction.h"
 #include "rpc/blockchain.h"
+#include "rpc/jsonwriter.h"
 #include "rpc/server.h"
 #include "rpc/tojson.h"
 #include "streams.h"
 #include "sync.h"
 #include "txmempool.h"
+#include "util.h"
 #include "utilstrencodings.h"
 #include "validation.h"
 #include "version.h"
@@ -23,8 +25,12 @@
 #include <boost/algorithm/string.hpp>
 #include <univalue.h>
 
-// Allow a max of 15 outpoints to be queried at once.
-static const size_t MAX_GETUTXOS_OUTPOINTS = 15;
+// Number of found outputs written per chunk of /rest/getutxos.
+static const size_t GETUTXOS_CHUNK_SIZE = 1000;
+
+// Number of mempool entries written per chunk of /rest/mempool/contents. The
+// mempool lock is only held while a chunk is being collected.
+static const size_t MEMPOOL_CONTENTS_CHUNK_SIZE = 1000;
 
 enum RetFormat {
     RF_UNDEF,
@@ -59,7 +65,38 @@ struct CCoin {
 };
 
 extern UniValue mempoolInfoToJSON();
-extern UniValue mempoolToJSON(bool fVerbose = false);
+extern void entryToJSONNL(CJSONWriter &info, const CTxMemPoolEntry &e);
+
+/** Fixed size record of one mempool entry in binary mempool contents */
+struct CMempoolEntryRecord {
+    uint256 txid;
+    int64_t nFee;
+    uint64_t nSize;
+    int64_t nTime;
+    uint64_t nCountWithAncestors;
+    uint64_t nSizeWithAncestors;
+    int64_t nModFeesWithAncestors;
+
+    CMempoolEntryRecord(const CTxMemPoolEntry &e)
+        : txid(e.GetTx().GetId()), nFee(e.GetFee().GetSatoshis()),
+          nSize(e.GetTxSize()), nTime(e.GetTime()),
+          nCountWithAncestors(e.GetCountWithAncestors()),
+          nSizeWithAncestors(e.GetSizeWithAncestors()),
+          nModFeesWithAncestors(e.GetModFeesWithAncestors().GetSatoshis()) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action) {
+        READWRITE(txid);
+        READWRITE(nFee);
+        READWRITE(nSize);
+        READWRITE(nTime);
+        READWRITE(nCountWithAncestors);
+        READWRITE(nSizeWithAncestors);
+        READWRITE(nModFeesWithAncestors);
+    }
+};
 
 static bool RESTERR(HTTPRequest *req, enum HTTPStatusCode status,
                     std::string message) {
@@ -371,6 +408,64 @@ static bool rest_mempool_info(Config &config, HTTPRequest *req,
     return true;
 }
 
+/**
+ * Write the mempool contents in chunks of MEMPOOL_CONTENTS_CHUNK_SIZE entries.
+ *
+ * The txids are taken in one pass and the entries are then looked up a chunk
+ * at a time, so the mempool lock is never held for long and the output is
+ * never built as a whole. Transactions removed in the meantime are skipped.
+ */
+static void writeMempoolContentsChunks(HTTPRequest &req, bool binary) {
+    std::vector<TxId> vTxIds;
+    {
+        std::shared_lock lock(mempool.smtx);
+        vTxIds.reserve(mempool.mapTx.size());
+        for (const CTxMemPoolEntry &e : mempool.mapTx) {
+            vTxIds.emplace_back(e.GetTx().GetId());
+        }
+    }
+
+    std::string strChunk;
+    CJSONWriter writer(strChunk);
+    if (!binary) {
+        writer.writeBeginObject();
+    }
+    for (size_t i = 0; i < vTxIds.size(); i += MEMPOOL_CONTENTS_CHUNK_SIZE) {
+        const size_t end =
+            std::min(vTxIds.size(), i + MEMPOOL_CONTENTS_CHUNK_SIZE);
+        CDataStream ssChunk(SER_NETWORK, PROTOCOL_VERSION);
+        {
+            std::shared_lock lock(mempool.smtx);
+            for (size_t j = i; j < end; ++j) {
+                auto it = mempool.mapTx.find(vTxIds[j]);
+                if (it == mempool.mapTx.end()) {
+                    continue;
+                }
+                if (binary) {
+                    ssChunk << CMempoolEntryRecord(*it);
+                } else {
+                    writer.writeBeginObject(vTxIds[j].ToString());
+                    entryToJSONNL(writer, *it);
+                    writer.writeEndObject();
+                }
+            }
+        }
+        if (binary) {
+            if (!ssChunk.empty()) {
+                req.WriteReplyChunk(ssChunk.str());
+            }
+        } else if (!strChunk.empty()) {
+            req.WriteReplyChunk(strChunk);
+            strChunk.clear();
+        }
+    }
+    if (!binary) {
+        writer.writeEndObject();
+        strChunk += "\n";
+        req.WriteReplyChunk(strChunk);
+    }
+}
+
 static bool rest_mempool_contents(Config &config, HTTPRequest *req,
                                   const std::string &strURIPart) {
     if (!CheckWarmup(req)) {
@@ -381,21 +476,26 @@ static bool rest_mempool_contents(Config &config, HTTPRequest *req,
     const RetFormat rf = ParseDataFormat(param, strURIPart);
 
     switch (rf) {
+        case RF_BINARY: {
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            req->StartWritingChunks(HTTP_OK);
+            writeMempoolContentsChunks(*req, true);
+            break;
+        }
         case RF_JSON: {
-            UniValue mempoolObject = mempoolToJSON(true);
-
-            std::string strJSON = mempoolObject.write() + "\n";
             req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
-            return true;
+            req->StartWritingChunks(HTTP_OK);
+            writeMempoolContentsChunks(*req, false);
+            break;
         }
         default: {
             return RESTERR(req, HTTP_NOT_FOUND,
-                           "output format not found (available: json)");
+                           "output format not found (available: .bin, .json)");
         }
     }
 
-    // not reached
+    req->StopWritingChunks();
+
     // continue to process further HTTP reqs on this cxn
     return true;
 }
@@ -441,9 +541,12 @@ static bool rest_tx(Config &config, HTTPRequest *req,
         }
 
         case RF_JSON: {
-            UniValue objTx(UniValue::VOBJ);
-            TxToUniv(*tx, hashBlock, objTx);
-            std::string strJSON = objTx.write() + "\n";
+            std::string strJSON;
+            CJSONWriter writer(strJSON);
+            writer.writeBeginObject();
+            TxToJSON(*tx, hashBlock, writer);
+            writer.writeEndObject();
+            strJSON += "\n";
             req->WriteHeader("Content-Type", "application/json");
             req->WriteReply(HTTP_OK, strJSON);
             return true;
@@ -564,79 +667,68 @@ static bool rest_getutxos(Config &config, HTTPRequest *req,
     }
 
     // limit max outpoints
-    if (vOutPoints.size() > MAX_GETUTXOS_OUTPOINTS) {
+    const size_t maxOutPoints = gArgs.GetArg("-maxgetutxosoutpoints",
+                                             DEFAULT_MAX_GETUTXOS_OUTPOINTS);
+    if (vOutPoints.size() > maxOutPoints) {
         return RESTERR(
             req, HTTP_BAD_REQUEST,
             strprintf("Error: max outpoints exceeded (max: %d, tried: %d)",
-                      MAX_GETUTXOS_OUTPOINTS, vOutPoints.size()));
+                      maxOutPoints, vOutPoints.size()));
     }
 
     // check spentness and form a bitmap (as well as a JSON capable
     // human-readable string representation)
+    const CUTXOQueryResult result {
+        GetUTXOs(vOutPoints, fCheckMemPool, true)};
     std::vector<uint8_t> bitmap;
-    std::vector<CCoin> outs;
+    std::vector<const Coin *> outs;
     std::string bitmapStringRepresentation;
-    std::vector<bool> hits;
     bitmap.resize((vOutPoints.size() + 7) / 8);
-    {
-        LOCK(cs_main);
-        std::shared_lock lock(mempool.smtx);
-
-        CCoinsView viewDummy;
-        CCoinsViewCache view(&viewDummy);
-
-        CCoinsViewCache &viewChain = *pcoinsTip;
-        CCoinsViewMemPool viewMempool(&viewChain, mempool);
-
-        if (fCheckMemPool) {
-            // switch cache backend to db+mempool in case user likes to query
-            // mempool.
-            view.SetBackend(viewMempool);
-        }
-
-        for (size_t i = 0; i < vOutPoints.size(); i++) {
-            Coin coin;
-            bool hit = false;
-            if (view.GetCoin(vOutPoints[i], coin) &&
-                !mempool.IsSpentNL(vOutPoints[i])) {
-                hit = true;
-                outs.emplace_back(std::move(coin));
-            }
-
-            hits.push_back(hit);
-            // form a binary string representation (human-readable for json
-            // output)
-            bitmapStringRepresentation.append(hit ? "1" : "0");
-            bitmap[i / 8] |= ((uint8_t)hit) << (i % 8);
+    for (size_t i = 0; i < result.vCoins.size(); i++) {
+        const bool hit = !result.vCoins[i].IsSpent();
+        if (hit) {
+            outs.push_back(&result.vCoins[i]);
         }
+        // form a binary string representation (human-readable for json
+        // output)
+        bitmapStringRepresentation.append(hit ? "1" : "0");
+        bitmap[i / 8] |= ((uint8_t)hit) << (i % 8);
     }
 
+    // The found outputs are written in chunks, so a large response is never
+    // built as a whole.
     switch (rf) {
-        case RF_BINARY: {
+        case RF_BINARY:
+        case RF_HEX: {
             // serialize data
             // use exact same output as mentioned in Bip64
-            CDataStream ssGetUTXOResponse(SER_NETWORK, PROTOCOL_VERSION);
-            ssGetUTXOResponse << chainActive.Height()
-                              << chainActive.Tip()->GetBlockHash() << bitmap
-                              << outs;
-            std::string ssGetUTXOResponseString = ssGetUTXOResponse.str();
-
-            req->WriteHeader("Content-Type", "application/octet-stream");
-            req->WriteReply(HTTP_OK, ssGetUTXOResponseString);
-            return true;
-        }
+            const bool fHex = (rf == RF_HEX);
+            auto writeChunk = [req, fHex](const CDataStream &ss) {
+                if (fHex) {
+                    req->WriteReplyChunk(HexStr(ss.begin(), ss.end()));
+                } else {
+                    req->WriteReplyChunk(ss.str());
+                }
+            };
 
-        case RF_HEX: {
+            req->WriteHeader("Content-Type", fHex ? "text/plain"
+                                                  : "application/octet-stream");
+            req->StartWritingChunks(HTTP_OK);
             CDataStream ssGetUTXOResponse(SER_NETWORK, PROTOCOL_VERSION);
-            ssGetUTXOResponse << chainActive.Height()
-                              << chainActive.Tip()->GetBlockHash() << bitmap
-                              << outs;
-            std::string strHex =
-                HexStr(ssGetUTXOResponse.begin(), ssGetUTXOResponse.end()) +
-                "\n";
-
-            req->WriteHeader("Content-Type", "text/plain");
-            req->WriteReply(HTTP_OK, strHex);
+            ssGetUTXOResponse << result.nHeight << result.hashBlock << bitmap;
+            WriteCompactSize(ssGetUTXOResponse, outs.size());
+            for (size_t i = 0; i < outs.size(); i++) {
+                ssGetUTXOResponse << CCoin(*outs[i]);
+                if ((i + 1) % GETUTXOS_CHUNK_SIZE == 0) {
+                    writeChunk(ssGetUTXOResponse);
+                    ssGetUTXOResponse.clear();
+                }
+            }
+            writeChunk(ssGetUTXOResponse);
+            if (fHex) {
+                req->WriteReplyChunk("\n");
+            }
+            req->StopWritingChunks();
             return true;
         }
 
@@ -645,31 +737,42 @@ static bool rest_getutxos(Config &config, HTTPRequest *req,
 
             // pack in some essentials
             // use more or less the same output as mentioned in Bip64
+            objGetUTXOResponse.push_back(Pair("chainHeight", result.nHeight));
             objGetUTXOResponse.push_back(
-                Pair("chainHeight", chainActive.Height()));
-            objGetUTXOResponse.push_back(Pair(
-                "chaintipHash", chainActive.Tip()->GetBlockHash().GetHex()));
+                Pair("chaintipHash", result.hashBlock.GetHex()));
             objGetUTXOResponse.push_back(
                 Pair("bitmap", bitmapStringRepresentation));
 
-            UniValue utxos(UniValue::VARR);
-            for (const CCoin &coin : outs) {
+            // the header fields are written as an object without its closing
+            // brace, followed by the utxos array
+            std::string strJSON = objGetUTXOResponse.write();
+            strJSON.pop_back();
+            strJSON += ",\"utxos\":[";
+
+            req->WriteHeader("Content-Type", "application/json");
+            req->StartWritingChunks(HTTP_OK);
+            for (size_t i = 0; i < outs.size(); i++) {
+                const CTxOut &out = outs[i]->GetTxOut();
                 UniValue utxo(UniValue::VOBJ);
-                utxo.push_back(Pair("height", int32_t(coin.nHeight)));
-                utxo.push_back(Pair("value", ValueFromAmount(coin.out.nValue)));
+                utxo.push_back(Pair("height", int32_t(outs[i]->GetHeight())));
+                utxo.push_back(Pair("value", ValueFromAmount(out.nValue)));
 
                 // include the script in a json output
                 UniValue o(UniValue::VOBJ);
-                ScriptPubKeyToUniv(coin.out.scriptPubKey, o, true);
+                ScriptPubKeyToUniv(out.scriptPubKey, o, true);
                 utxo.push_back(Pair("scriptPubKey", o));
-                utxos.push_back(utxo);
+                if (i > 0) {
+                    strJSON += ",";
+                }
+                strJSON += utxo.write();
+                if ((i + 1) % GETUTXOS_CHUNK_SIZE == 0) {
+                    req->WriteReplyChunk(strJSON);
+                    strJSON.clear();
+                }
             }
-            objGetUTXOResponse.push_back(Pair("utxos", utxos));
-
-            // return json string
-            std::string strJSON = objGetUTXOResponse.write() + "\n";
-            req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
+            strJSON += "]}\n";
+            req->WriteReplyChunk(strJSON);
+            req->StopWritingChunks();
             return true;
         }
         default: {
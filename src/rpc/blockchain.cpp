@@ -17,6 +17,7 @@
 #include "mining/journal_builder.h"
 #include "policy/policy.h"
 #include "primitives/transaction.h"
+#include "rpc/jsonwriter.h"
 #include "rpc/server.h"
 #include "rpc/tojson.h"
 #include "streams.h"
@@ -33,6 +34,7 @@
 #include <condition_variable>
 #include <cstdint>
 #include <mutex>
+#include <numeric>
 
 struct CUpdatedBlock {
     uint256 hash;
@@ -388,6 +390,36 @@ void entryToJSONNL(UniValue &info, const CTxMemPoolEntry &e) {
     info.push_back(Pair("depends", depends));
 }
 
+void entryToJSONNL(CJSONWriter &info, const CTxMemPoolEntry &e) {
+    info.pushKV("size", (int)e.GetTxSize());
+    info.pushKVJSONFormatted("fee", ValueFromAmount(e.GetFee()).getValStr());
+    info.pushKVJSONFormatted("modifiedfee",
+                             ValueFromAmount(e.GetModifiedFee()).getValStr());
+    info.pushKV("time", e.GetTime());
+    info.pushKV("height", (int)e.GetHeight());
+    info.pushKV("startingpriority", e.GetPriority(e.GetHeight()));
+    info.pushKV("currentpriority", e.GetPriority(chainActive.Height()));
+    info.pushKV("descendantcount", e.GetCountWithDescendants());
+    info.pushKV("descendantsize", e.GetSizeWithDescendants());
+    info.pushKV("descendantfees", e.GetModFeesWithDescendants().GetSatoshis());
+    info.pushKV("ancestorcount", e.GetCountWithAncestors());
+    info.pushKV("ancestorsize", e.GetSizeWithAncestors());
+    info.pushKV("ancestorfees", e.GetModFeesWithAncestors().GetSatoshis());
+    const CTransaction &tx = e.GetTx();
+    std::set<std::string> setDepends;
+    for (const CTxIn &txin : tx.vin) {
+        if (mempool.ExistsNL(txin.prevout.GetTxId())) {
+            setDepends.insert(txin.prevout.GetTxId().ToString());
+        }
+    }
+
+    info.writeBeginArray("depends");
+    for (const std::string &dep : setDepends) {
+        info.pushV(dep);
+    }
+    info.writeEndArray();
+}
+
 UniValue mempoolToJSON(bool fVerbose = false) {
     if (fVerbose) {
         std::shared_lock lock(mempool.smtx);
@@ -396,7 +428,8 @@ UniValue mempoolToJSON(bool fVerbose = false) {
             const uint256 &txid = e.GetTx().GetId();
             UniValue info(UniValue::VOBJ);
             entryToJSONNL(info, e);
-            o.push_back(Pair(txid.ToString(), info));
+            // txids are unique, so skip the linear duplicate key lookup
+            o.__pushKV(txid.ToString(), info);
         }
         return o;
     } else {
@@ -900,6 +933,9 @@ void writeBlockChunksAndUpdateMetadata(bool isHexEncoded, HTTPRequest &req,
     }
 }
 
+// Size from which the JSON of getblock is written out as a chunk
+static const size_t BLOCK_JSON_CHUNK_SIZE = 1024 * 1024;
+
 void writeBlockJsonChunksAndUpdateMetadata(const Config &config, HTTPRequest &req,
                         bool showTxDetails, CBlockIndex& blockIndex) {
 
@@ -914,17 +950,22 @@ void writeBlockJsonChunksAndUpdateMetadata(const Config &config, HTTPRequest &re
         assert(!"cannot load block from disk");
     }
 
-    std::string delimiter;
-
-    req.WriteReplyChunk("{\"tx\":[");
+    // Transactions are written into one buffer that is handed to the HTTP
+    // reply whenever it grows past BLOCK_JSON_CHUNK_SIZE.
+    std::string buffer {"{\"tx\":"};
+    CJSONWriter writer {buffer};
+    writer.writeBeginArray();
     do
     {
         const CTransaction& transaction = reader->ReadTransaction();
-        UniValue objBlockTx = blockTxToJSON(config, transaction, showTxDetails);
-        std::string strJSON = delimiter + objBlockTx.write();
-        req.WriteReplyChunk(strJSON);
-        delimiter = ",";  
+        blockTxToJSON(config, transaction, showTxDetails, writer);
+        if (buffer.size() >= BLOCK_JSON_CHUNK_SIZE) {
+            req.WriteReplyChunk(buffer);
+            buffer.clear();
+        }
     } while(!reader->EndOfStream());
+    writer.writeEndArray();
+    req.WriteReplyChunk(buffer);
 
     CBlockHeader header = reader->GetBlockHeader();
 
@@ -934,7 +975,7 @@ void writeBlockJsonChunksAndUpdateMetadata(const Config &config, HTTPRequest &re
         SetBlockIndexFileMetaDataIfNotSet(blockIndex, metadata);
     }
 
-    req.WriteReplyChunk("]," + headerBlockToJSON(config, header, &blockIndex) + "}");
+    req.WriteReplyChunk("," + headerBlockToJSON(config, header, &blockIndex) + "}");
 }
 
 std::string headerBlockToJSON(const Config &config, const CBlockHeader &blockHeader,
@@ -977,14 +1018,15 @@ std::string headerBlockToJSON(const Config &config, const CBlockHeader &blockHea
     return headerJSON.substr(1, headerJSON.size() - 2);
 }
 
-UniValue blockTxToJSON(const Config &config, const CTransaction& tx, bool txDetails) {
+void blockTxToJSON(const Config &config, const CTransaction& tx, bool txDetails,
+                   CJSONWriter& writer) {
     if (txDetails) {
-        UniValue objTx(UniValue::VOBJ);
-        TxToUniv(tx, uint256(), objTx);
-        return objTx;
-    } 
-
-    return tx.GetId().GetHex();
+        writer.writeBeginObject();
+        TxToJSON(tx, uint256(), writer);
+        writer.writeEndObject();
+    } else {
+        writer.pushV(tx.GetId().GetHex());
+    }
 }
 
 struct CCoinsStats {
@@ -1258,6 +1300,159 @@ UniValue gettxout(const Config &config, const JSONRPCRequest &request) {
     return ret;
 }
 
+CUTXOQueryResult GetUTXOs(const std::vector<COutPoint> &vOutPoints,
+                          bool fIncludeMempool, bool fExcludeMempoolSpent) {
+    std::vector<size_t> vOrder(vOutPoints.size());
+    std::iota(vOrder.begin(), vOrder.end(), 0);
+    std::sort(vOrder.begin(), vOrder.end(),
+              [&vOutPoints](size_t a, size_t b) {
+                  return vOutPoints[a] < vOutPoints[b];
+              });
+
+    CUTXOQueryResult result {};
+    result.vCoins.resize(vOutPoints.size());
+
+    LOCK(cs_main);
+    std::shared_lock lock(mempool.smtx);
+    CCoinsViewMemPool viewMempool(pcoinsTip, mempool);
+    const CCoinsView &view {
+        fIncludeMempool ? static_cast<const CCoinsView &>(viewMempool)
+                        : *pcoinsTip};
+
+    const size_t none {vOutPoints.size()};
+    size_t prev {none};
+    for (size_t idx : vOrder) {
+        const COutPoint &out = vOutPoints[idx];
+        if (prev != none && vOutPoints[prev] == out) {
+            result.vCoins[idx] = result.vCoins[prev];
+            continue;
+        }
+        prev = idx;
+
+        Coin coin;
+        if (view.GetCoin(out, coin) &&
+            !(fExcludeMempoolSpent && mempool.IsSpentNL(out))) {
+            result.vCoins[idx] = std::move(coin);
+        }
+    }
+
+    result.nHeight = chainActive.Height();
+    result.hashBlock = chainActive.Tip()->GetBlockHash();
+    return result;
+}
+
+UniValue gettxouts(const Config &config, const JSONRPCRequest &request) {
+    if (request.fHelp || request.params.size() < 1 ||
+        request.params.size() > 2) {
+        throw std::runtime_error(
+            "gettxouts [{\"txid\":\"id\",\"n\":n},...] ( include_mempool )\n"
+            "\nReturns details about a batch of transaction outputs, all "
+            "resolved against the same chain tip.\n"
+            "\nArguments:\n"
+            "1. \"outpoints\"        (array, required) The outputs to look up "
+            "(at most -maxgetutxosoutpoints)\n"
+            "     [\n"
+            "       {\n"
+            "         \"txid\":\"id\",  (string, required) The transaction id\n"
+            "         \"n\":n         (numeric, required) The output number\n"
+            "       }\n"
+            "       ,...\n"
+            "     ]\n"
+            "2. \"include_mempool\"  (boolean, optional) Whether to include "
+            "the mempool. Default: true."
+            "     Note that an unspent output that is spent in the mempool "
+            "won't appear.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"bestblock\" : \"hash\",    (string) the block hash\n"
+            "  \"height\" : n,              (numeric) the block height\n"
+            "  \"txouts\" : [               (array) in the order of the "
+            "outpoints, null for outputs that are spent or unknown\n"
+            "    {\n"
+            "      \"confirmations\" : n,   (numeric) The number of "
+            "confirmations\n"
+            "      \"value\" : x.xxx,       (numeric) The transaction value "
+            "in " +
+            CURRENCY_UNIT +
+            "\n"
+            "      \"scriptPubKey\" : {...}, (json object) As in gettxout\n"
+            "      \"coinbase\" : true|false (boolean) Coinbase or not\n"
+            "    }\n"
+            "    ,...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("gettxouts",
+                           "\"[{\\\"txid\\\":\\\"mytxid\\\",\\\"n\\\":0}]\"") +
+            HelpExampleRpc("gettxouts",
+                           "[{\"txid\":\"mytxid\",\"n\":0}]"));
+    }
+
+    RPCTypeCheck(request.params, {UniValue::VARR, UniValue::VBOOL}, true);
+
+    const UniValue &outpoints = request.params[0].get_array();
+    const size_t maxOutPoints = gArgs.GetArg(
+        "-maxgetutxosoutpoints", DEFAULT_MAX_GETUTXOS_OUTPOINTS);
+    if (outpoints.size() > maxOutPoints) {
+        throw JSONRPCError(
+            RPC_INVALID_PARAMETER,
+            strprintf("Too many outpoints (max: %d, tried: %d)", maxOutPoints,
+                      outpoints.size()));
+    }
+
+    std::vector<COutPoint> vOutPoints;
+    vOutPoints.reserve(outpoints.size());
+    for (size_t i = 0; i < outpoints.size(); i++) {
+        const UniValue &o = outpoints[i].get_obj();
+        RPCTypeCheckObj(o, {
+                               {"txid", UniValueType(UniValue::VSTR)},
+                               {"n", UniValueType(UniValue::VNUM)},
+                           });
+        const int n = find_value(o, "n").get_int();
+        if (n < 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER,
+                               "Invalid parameter, n must be positive");
+        }
+        vOutPoints.emplace_back(ParseHashO(o, "txid"), n);
+    }
+
+    bool fMempool = true;
+    if (request.params.size() > 1) {
+        fMempool = request.params[1].get_bool();
+    }
+
+    const CUTXOQueryResult result {GetUTXOs(vOutPoints, fMempool, fMempool)};
+
+    UniValue txouts(UniValue::VARR);
+    for (const Coin &coin : result.vCoins) {
+        if (coin.IsSpent()) {
+            txouts.push_back(NullUniValue);
+            continue;
+        }
+        UniValue txout(UniValue::VOBJ);
+        if (coin.GetHeight() == MEMPOOL_HEIGHT) {
+            txout.push_back(Pair("confirmations", 0));
+        } else {
+            txout.push_back(Pair(
+                "confirmations",
+                int64_t(result.nHeight - int64_t(coin.GetHeight()) + 1)));
+        }
+        txout.push_back(
+            Pair("value", ValueFromAmount(coin.GetTxOut().nValue)));
+        UniValue o(UniValue::VOBJ);
+        ScriptPubKeyToUniv(coin.GetTxOut().scriptPubKey, o, true);
+        txout.push_back(Pair("scriptPubKey", o));
+        txout.push_back(Pair("coinbase", coin.IsCoinBase()));
+        txouts.push_back(txout);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("bestblock", result.hashBlock.GetHex()));
+    ret.push_back(Pair("height", result.nHeight));
+    ret.push_back(Pair("txouts", txouts));
+    return ret;
+}
+
 UniValue verifychain(const Config &config, const JSONRPCRequest &request) {
     int nCheckLevel = gArgs.GetArg("-checklevel", DEFAULT_CHECKLEVEL);
     int nCheckDepth = gArgs.GetArg("-checkblocks", DEFAULT_CHECKBLOCKS);
@@ -1847,24 +2042,25 @@ UniValue rebuildjournal(const Config &config, const JSONRPCRequest &request) {
 
 // clang-format off
 static const CRPCCommand commands[] = {
-    //  category            name                      actor (function)        okSafe argNames
-    //  ------------------- ------------------------  ----------------------  ------ ----------
+    //  category            name                      actor (function)        okSafe argNames  parallelSafe
+    //  ------------------- ------------------------  ----------------------  ------ ----------  ------------
     { "blockchain",         "getblockchaininfo",      getblockchaininfo,      true,  {} },
     { "blockchain",         "getchaintxstats",        &getchaintxstats,       true,  {"nblocks", "blockhash"} },
-    { "blockchain",         "getbestblockhash",       getbestblockhash,       true,  {} },
-    { "blockchain",         "getblockcount",          getblockcount,          true,  {} },
+    { "blockchain",         "getbestblockhash",       getbestblockhash,       true,  {}, true },
+    { "blockchain",         "getblockcount",          getblockcount,          true,  {}, true },
     // getblock command is processed in a special way, because it uses streaming
     // { "blockchain",         "getblock",               getblock,               true,  {"blockhash","verbosity|verbose"} },
-    { "blockchain",         "getblockhash",           getblockhash,           true,  {"height"} },
-    { "blockchain",         "getblockheader",         getblockheader,         true,  {"blockhash","verbose"} },
+    { "blockchain",         "getblockhash",           getblockhash,           true,  {"height"}, true },
+    { "blockchain",         "getblockheader",         getblockheader,         true,  {"blockhash","verbose"}, true },
     { "blockchain",         "getchaintips",           getchaintips,           true,  {} },
     { "blockchain",         "getdifficulty",          getdifficulty,          true,  {} },
-    { "blockchain",         "getmempoolancestors",    getmempoolancestors,    true,  {"txid","verbose"} },
-    { "blockchain",         "getmempooldescendants",  getmempooldescendants,  true,  {"txid","verbose"} },
-    { "blockchain",         "getmempoolentry",        getmempoolentry,        true,  {"txid"} },
+    { "blockchain",         "getmempoolancestors",    getmempoolancestors,    true,  {"txid","verbose"}, true },
+    { "blockchain",         "getmempooldescendants",  getmempooldescendants,  true,  {"txid","verbose"}, true },
+    { "blockchain",         "getmempoolentry",        getmempoolentry,        true,  {"txid"}, true },
     { "blockchain",         "getmempoolinfo",         getmempoolinfo,         true,  {} },
     { "blockchain",         "getrawmempool",          getrawmempool,          true,  {"verbose"} },
-    { "blockchain",         "gettxout",               gettxout,               true,  {"txid","n","include_mempool"} },
+    { "blockchain",         "gettxout",               gettxout,               true,  {"txid","n","include_mempool"}, true },
+    { "blockchain",         "gettxouts",              gettxouts,              true,  {"outpoints","include_mempool"}, true },
     { "blockchain",         "gettxoutsetinfo",        gettxoutsetinfo,        true,  {} },
     { "blockchain",         "pruneblockchain",        pruneblockchain,        true,  {"height"} },
     { "blockchain",         "verifychain",            verifychain,            true,  {"checklevel","nblocks"} },
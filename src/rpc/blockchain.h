@@ -10,11 +10,37 @@
 #include "httpserver.h"
 #include "uint256.h"
 #include "chain.h"
+#include "coins.h"
+
+#include <vector>
 
 class CBlockIndex;
 class Config;
 class JSONRPCRequest;
 
+/** Default for -maxgetutxosoutpoints */
+static const size_t DEFAULT_MAX_GETUTXOS_OUTPOINTS = 10000;
+
+/** Result of GetUTXOs() */
+struct CUTXOQueryResult {
+    //! Height and hash of the tip the outpoints were resolved against
+    int nHeight {-1};
+    uint256 hashBlock {};
+    //! One coin per queried outpoint, in query order; spent if not found
+    std::vector<Coin> vCoins {};
+};
+
+/**
+ * Look up a batch of outpoints.
+ *
+ * All outpoints are resolved against the same tip (and mempool, if
+ * fIncludeMempool is set). They are looked up in coins database key order
+ * and duplicates only once. If fExcludeMempoolSpent is set, outputs spent by
+ * a mempool transaction are reported as not found.
+ */
+CUTXOQueryResult GetUTXOs(const std::vector<COutPoint> &vOutPoints,
+                          bool fIncludeMempool, bool fExcludeMempoolSpent);
+
 UniValue getblockchaininfo(const Config &config, const JSONRPCRequest &request);
 void getblock(const Config &config, const JSONRPCRequest &request, HTTPRequest *req, bool processedInBatch);
 void writeBlockJsonChunksAndUpdateMetadata(const Config &config, HTTPRequest &req,
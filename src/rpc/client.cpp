@@ -86,6 +86,8 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     {"getchaintxstats", 0, "nblocks"},
     {"gettransaction", 1, "include_watchonly"},
     {"getrawtransaction", 1, "verbose"},
+    {"getrawtransactions", 0, "txids"},
+    {"getrawtransactions", 1, "verbose"},
     {"createrawtransaction", 0, "inputs"},
     {"createrawtransaction", 1, "outputs"},
     {"createrawtransaction", 2, "locktime"},
@@ -95,6 +97,8 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     {"fundrawtransaction", 1, "options"},
     {"gettxout", 1, "n"},
     {"gettxout", 2, "include_mempool"},
+    {"gettxouts", 0, "outpoints"},
+    {"gettxouts", 1, "include_mempool"},
     {"gettxoutproof", 0, "txids"},
     {"lockunspent", 0, "unlock"},
     {"lockunspent", 1, "transactions"},
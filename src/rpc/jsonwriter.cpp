@@ -0,0 +1,171 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "rpc/jsonwriter.h"
+
+#include <univalue.h>
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Two hex digits for every byte value, so encoding is a table lookup and a
+// fixed size copy per byte without any branches.
+struct HexTable {
+    std::array<char, 512> digits {};
+
+    HexTable() {
+        static const char hexmap[] = "0123456789abcdef";
+        for (size_t i = 0; i < 256; ++i) {
+            digits[2 * i] = hexmap[i >> 4];
+            digits[2 * i + 1] = hexmap[i & 15];
+        }
+    }
+};
+
+const HexTable hexTable {};
+
+// Same characters UniValue escapes when writing strings
+bool NeedsEscape(unsigned char ch) {
+    return ch < 0x20 || ch == '"' || ch == '\\' || ch == 0x7f;
+}
+
+} // namespace
+
+void CJSONWriter::writeSeparator() {
+    if (mNeedSeparator) {
+        mBuffer.push_back(',');
+    }
+    mNeedSeparator = true;
+}
+
+void CJSONWriter::writeKey(std::string_view key) {
+    writeSeparator();
+    writeString(key);
+    mBuffer.push_back(':');
+}
+
+void CJSONWriter::writeString(std::string_view str) {
+    mBuffer.push_back('"');
+    size_t begin = 0;
+    for (size_t i = 0; i < str.size(); ++i) {
+        const unsigned char ch = str[i];
+        if (!NeedsEscape(ch)) {
+            continue;
+        }
+        mBuffer.append(str.data() + begin, i - begin);
+        begin = i + 1;
+        switch (ch) {
+            case '"':
+                mBuffer.append("\\\"");
+                break;
+            case '\\':
+                mBuffer.append("\\\\");
+                break;
+            case '\b':
+                mBuffer.append("\\b");
+                break;
+            case '\t':
+                mBuffer.append("\\t");
+                break;
+            case '\n':
+                mBuffer.append("\\n");
+                break;
+            case '\f':
+                mBuffer.append("\\f");
+                break;
+            case '\r':
+                mBuffer.append("\\r");
+                break;
+            default: {
+                char escaped[7];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+                mBuffer.append(escaped, 6);
+            }
+        }
+    }
+    mBuffer.append(str.data() + begin, str.size() - begin);
+    mBuffer.push_back('"');
+}
+
+void CJSONWriter::writeHex(const uint8_t *data, size_t size) {
+    mBuffer.push_back('"');
+    const size_t pos = mBuffer.size();
+    mBuffer.resize(pos + 2 * size);
+    char *out = &mBuffer[pos];
+    for (size_t i = 0; i < size; ++i) {
+        std::memcpy(out + 2 * i, &hexTable.digits[2 * data[i]], 2);
+    }
+    mBuffer.push_back('"');
+}
+
+void CJSONWriter::writeBeginObject(std::string_view objectName) {
+    if (objectName.empty()) {
+        writeSeparator();
+    } else {
+        writeKey(objectName);
+    }
+    mBuffer.push_back('{');
+    mNeedSeparator = false;
+}
+
+void CJSONWriter::writeEndObject() {
+    mBuffer.push_back('}');
+    mNeedSeparator = true;
+}
+
+void CJSONWriter::writeBeginArray(std::string_view arrayName) {
+    if (arrayName.empty()) {
+        writeSeparator();
+    } else {
+        writeKey(arrayName);
+    }
+    mBuffer.push_back('[');
+    mNeedSeparator = false;
+}
+
+void CJSONWriter::writeEndArray() {
+    mBuffer.push_back(']');
+    mNeedSeparator = true;
+}
+
+void CJSONWriter::pushKV(std::string_view key, std::string_view value) {
+    writeKey(key);
+    writeString(value);
+}
+
+void CJSONWriter::pushKV(std::string_view key, bool value) {
+    pushKVJSONFormatted(key, value ? "true" : "false");
+}
+
+void CJSONWriter::pushKV(std::string_view key, double value) {
+    pushKVJSONFormatted(key, UniValue(value).getValStr());
+}
+
+void CJSONWriter::pushKVNull(std::string_view key) {
+    pushKVJSONFormatted(key, "null");
+}
+
+void CJSONWriter::pushKVJSONFormatted(std::string_view key,
+                                      std::string_view json) {
+    writeKey(key);
+    mBuffer.append(json.data(), json.size());
+}
+
+void CJSONWriter::pushKVHex(std::string_view key, const uint8_t *data,
+                            size_t size) {
+    writeKey(key);
+    writeHex(data, size);
+}
+
+void CJSONWriter::pushV(std::string_view value) {
+    writeSeparator();
+    writeString(value);
+}
+
+void CJSONWriter::pushVJSONFormatted(std::string_view json) {
+    writeSeparator();
+    mBuffer.append(json.data(), json.size());
+}
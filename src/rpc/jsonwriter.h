@@ -0,0 +1,71 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#ifndef BITCOIN_RPCJSONWRITER_H
+#define BITCOIN_RPCJSONWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * Writes compact JSON text straight into a string buffer.
+ *
+ * The output is byte for byte what UniValue::write() produces for the same
+ * document, but no intermediate UniValue tree or temporary strings are
+ * built. Separators between members and elements are inserted automatically.
+ * The caller may hand out and clear the buffer between any two calls, which
+ * is how large documents are streamed in chunks.
+ */
+class CJSONWriter {
+public:
+    explicit CJSONWriter(std::string &buffer) : mBuffer{buffer} {}
+
+    CJSONWriter(const CJSONWriter &) = delete;
+    CJSONWriter &operator=(const CJSONWriter &) = delete;
+
+    // Begin/end an object or array; objectName is only given for members
+    void writeBeginObject(std::string_view objectName = {});
+    void writeEndObject();
+    void writeBeginArray(std::string_view arrayName = {});
+    void writeEndArray();
+
+    // Object members
+    void pushKV(std::string_view key, std::string_view value);
+    void pushKV(std::string_view key, const char *value) {
+        pushKV(key, std::string_view{value});
+    }
+    void pushKV(std::string_view key, bool value);
+    template <typename T,
+              typename std::enable_if<std::is_integral<T>::value &&
+                                          !std::is_same<T, bool>::value,
+                                      int>::type = 0>
+    void pushKV(std::string_view key, T value) {
+        pushKVJSONFormatted(key, std::to_string(value));
+    }
+    void pushKV(std::string_view key, double value);
+    void pushKVNull(std::string_view key);
+    // Member whose value is already valid JSON (for example a number string)
+    void pushKVJSONFormatted(std::string_view key, std::string_view json);
+    // String member holding the lower case hex encoding of the given bytes
+    void pushKVHex(std::string_view key, const uint8_t *data, size_t size);
+
+    // Array elements
+    void pushV(std::string_view value);
+    void pushVJSONFormatted(std::string_view json);
+
+    std::string &buffer() { return mBuffer; }
+
+private:
+    void writeSeparator();
+    void writeKey(std::string_view key);
+    void writeString(std::string_view str);
+    void writeHex(const uint8_t *data, size_t size);
+
+    std::string &mBuffer;
+    bool mNeedSeparator {false};
+};
+
+#endif // BITCOIN_RPCJSONWRITER_H
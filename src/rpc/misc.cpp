@@ -18,6 +18,7 @@
 #include "util.h"
 #include "utilstrencodings.h"
 #include "validation.h"
+#include "validationinterface.h"
 #ifdef ENABLE_WALLET
 #include "wallet/rpcwallet.h"
 #include "wallet/wallet.h"
@@ -84,8 +85,10 @@ static UniValue getinfo(const Config &config, const JSONRPCRequest &request) {
             "  \"errors\": \"...\",            (string) any error messages\n"
             "  \"maxblocksize\": xxxxx,      (numeric) The absolute maximum block "
             "size we will accept from any source\n"
-            "  \"maxminedblocksize\": xxxxx  (numeric) The maximum block size "
+            "  \"maxminedblocksize\": xxxxx, (numeric) The maximum block size "
             "we will mine\n"
+            "  \"droppedlogmessages\": xxxxx (numeric) The number of debug log "
+            "messages dropped because the -logasync buffer was full\n"
             "}\n"
             "\nExamples:\n" +
             HelpExampleCli("getinfo", "") + HelpExampleRpc("getinfo", ""));
@@ -142,6 +145,8 @@ static UniValue getinfo(const Config &config, const JSONRPCRequest &request) {
     obj.push_back(Pair("errors", GetWarnings("statusbar")));
     obj.push_back(Pair("maxblocksize", config.GetMaxBlockSize()));
     obj.push_back(Pair("maxminedblocksize", config.GetMaxGeneratedBlockSize()));
+    obj.push_back(Pair("droppedlogmessages",
+                       GetLogger().GetDroppedMessages()));
     return obj;
 }
 
@@ -645,6 +650,42 @@ static UniValue getmemoryinfo(const Config &config,
     return obj;
 }
 
+static UniValue getvalidationqueueinfo(const Config &config,
+                                       const JSONRPCRequest &request) {
+    if (request.fHelp || request.params.size() != 0) {
+        throw std::runtime_error(
+            "getvalidationqueueinfo\n"
+            "Returns an object containing information about the queues of "
+            "block and transaction notifications that are delivered "
+            "asynchronously (for example to ZMQ).\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"subscribers\": xxxxx,   (numeric) Number of subscribers with "
+            "asynchronous delivery\n"
+            "  \"queued\": xxxxx,        (numeric) Number of notifications "
+            "waiting to be delivered\n"
+            "  \"maxqueued\": xxxxx,     (numeric) Maximum number of queued "
+            "notifications per subscriber\n"
+            "  \"dropped\": xxxxx,       (numeric) Number of notifications "
+            "dropped because a queue was full\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getvalidationqueueinfo", "") +
+            HelpExampleRpc("getvalidationqueueinfo", ""));
+    }
+
+    const CValidationInterfaceQueueStats stats {
+        GetValidationInterfaceQueueStats()
+    };
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("subscribers", uint64_t(stats.nAsyncSubscribers)));
+    obj.push_back(Pair("queued", uint64_t(stats.nQueued)));
+    obj.push_back(
+        Pair("maxqueued", uint64_t(DEFAULT_VALIDATION_QUEUE_MAX_SIZE)));
+    obj.push_back(Pair("dropped", stats.nDropped));
+    return obj;
+}
+
 static UniValue echo(const Config &config, const JSONRPCRequest &request) {
     if (request.fHelp) {
         throw std::runtime_error(
@@ -665,6 +706,7 @@ static const CRPCCommand commands[] = {
     //  ------------------- ------------------------  ----------------------  ----------
     { "control",            "getinfo",                getinfo,                true,  {} }, /* uses wallet if enabled */
     { "control",            "getmemoryinfo",          getmemoryinfo,          true,  {} },
+    { "control",            "getvalidationqueueinfo", getvalidationqueueinfo, true,  {} },
     { "util",               "validateaddress",        validateaddress,        true,  {"address"} }, /* uses wallet if enabled */
     { "util",               "createmultisig",         createmultisig,         true,  {"nrequired","keys"} },
     { "util",               "verifymessage",          verifymessage,          true,  {"address","signature","message"} },
@@ -111,7 +111,7 @@ static UniValue getpeerinfo(const Config &config,
             "due to addnode and is using an addnode slot\n"
             "    \"startingheight\": n,       (numeric) The starting height "
             "(block) of the peer\n"
-            "    \"txninvsize\": n,           (numeric) The number of queued transaction inventory msgs we have for this peer\n "
+            "    \"txninvsize\": n,           (numeric) The number of new transactions this peer has yet to be considered for announcing\n "
             "    \"banscore\": n,             (numeric) The ban score\n"
             "    \"synced_headers\": n,       (numeric) The last header we "
             "have in common with this peer\n"
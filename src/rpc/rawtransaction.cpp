@@ -17,6 +17,7 @@
 #include "net.h"
 #include "policy/policy.h"
 #include "primitives/transaction.h"
+#include "rpc/jsonwriter.h"
 #include "rpc/server.h"
 #include "rpc/tojson.h"
 #include "script/script.h"
@@ -26,6 +27,7 @@
 #include "txmempool.h"
 #include "txn_validator.h"
 #include "uint256.h"
+#include "utilmoneystr.h"
 #include "utilstrencodings.h"
 #include "validation.h"
 #ifdef ENABLE_WALLET
@@ -66,6 +68,84 @@ void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
     }
 }
 
+void ScriptPubKeyToJSON(const CScript &scriptPubKey, bool fIncludeHex,
+                        CJSONWriter &entry) {
+    txnouttype type;
+    std::vector<CTxDestination> addresses;
+    int nRequired;
+
+    entry.pushKV("asm", ScriptToAsmStr(scriptPubKey));
+    if (fIncludeHex) {
+        entry.pushKVHex("hex", scriptPubKey.data(), scriptPubKey.size());
+    }
+
+    if (!ExtractDestinations(scriptPubKey, type, addresses, nRequired)) {
+        entry.pushKV("type", GetTxnOutputType(type));
+        return;
+    }
+
+    entry.pushKV("reqSigs", nRequired);
+    entry.pushKV("type", GetTxnOutputType(type));
+
+    entry.writeBeginArray("addresses");
+    for (const CTxDestination &addr : addresses) {
+        entry.pushV(EncodeDestination(addr));
+    }
+    entry.writeEndArray();
+}
+
+void TxToJSON(const CTransaction &tx, const uint256 &hashBlock,
+              CJSONWriter &entry) {
+    // The serialised transaction gives both the size and the hex member.
+    CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION);
+    ssTx << tx;
+
+    entry.pushKV("txid", tx.GetId().GetHex());
+    entry.pushKV("hash", tx.GetHash().GetHex());
+    entry.pushKV("version", tx.nVersion);
+    entry.pushKV("size", static_cast<int>(ssTx.size()));
+    entry.pushKV("locktime", static_cast<int64_t>(tx.nLockTime));
+
+    entry.writeBeginArray("vin");
+    for (const CTxIn &txin : tx.vin) {
+        entry.writeBeginObject();
+        const CScript &scriptSig = txin.scriptSig;
+        if (tx.IsCoinBase()) {
+            entry.pushKVHex("coinbase", scriptSig.data(), scriptSig.size());
+        } else {
+            entry.pushKV("txid", txin.prevout.GetTxId().GetHex());
+            entry.pushKV("vout", static_cast<int64_t>(txin.prevout.GetN()));
+            entry.writeBeginObject("scriptSig");
+            entry.pushKV("asm", ScriptToAsmStr(scriptSig, true));
+            entry.pushKVHex("hex", scriptSig.data(), scriptSig.size());
+            entry.writeEndObject();
+        }
+        entry.pushKV("sequence", static_cast<int64_t>(txin.nSequence));
+        entry.writeEndObject();
+    }
+    entry.writeEndArray();
+
+    entry.writeBeginArray("vout");
+    for (size_t i = 0; i < tx.vout.size(); i++) {
+        const CTxOut &txout = tx.vout[i];
+        entry.writeBeginObject();
+        entry.pushKVJSONFormatted("value", FormatMoney(txout.nValue));
+        entry.pushKV("n", static_cast<int64_t>(i));
+        entry.writeBeginObject("scriptPubKey");
+        ScriptPubKeyToJSON(txout.scriptPubKey, true, entry);
+        entry.writeEndObject();
+        entry.writeEndObject();
+    }
+    entry.writeEndArray();
+
+    if (!hashBlock.IsNull()) {
+        entry.pushKV("blockhash", hashBlock.GetHex());
+    }
+
+    entry.pushKVHex("hex", reinterpret_cast<const uint8_t *>(ssTx.data()),
+                    ssTx.size());
+}
+
 static UniValue getrawtransaction(const Config &config,
                                   const JSONRPCRequest &request) {
     if (request.fHelp || request.params.size() < 1 ||
@@ -152,8 +232,6 @@ static UniValue getrawtransaction(const Config &config,
             HelpExampleRpc("getrawtransaction", "\"mytxid\", true"));
     }
 
-    LOCK(cs_main);
-
     TxId txid = TxId(ParseHashV(request.params[0], "parameter 1"));
 
     // Accept either a bool (true) or a num (>=1) to indicate verbose output.
@@ -191,12 +269,95 @@ static UniValue getrawtransaction(const Config &config,
         return strHex;
     }
 
+    LOCK(cs_main);
     UniValue result(UniValue::VOBJ);
     result.push_back(Pair("hex", strHex));
     TxToJSON(*tx, hashBlock, result);
     return result;
 }
 
+static UniValue getrawtransactions(const Config &config,
+                                   const JSONRPCRequest &request) {
+    if (request.fHelp || request.params.size() < 1 ||
+        request.params.size() > 2) {
+        throw std::runtime_error(
+            "getrawtransactions [\"txid\",...] ( verbose )\n"
+
+            "\nReturn the raw transaction data for several transactions.\n"
+            "Transactions found in the transaction index are read in disk "
+            "order.\n"
+            "Unlike getrawtransaction, blockchain transactions are only found "
+            "with -txindex.\n"
+
+            "\nArguments:\n"
+            "1. \"txids\"     (array, required) The transaction ids\n"
+            "     [\n"
+            "       \"txid\"  (string) A transaction id\n"
+            "       ,...\n"
+            "     ]\n"
+            "2. verbose       (bool, optional, default=false) If false, return "
+            "strings, otherwise return json objects\n"
+
+            "\nResult:\n"
+            "[                 (array) One entry per txid, in the given order\n"
+            "  \"data\"        (string or json object) The transaction as "
+            "returned by getrawtransaction, or null if it wasn't found\n"
+            "  ,...\n"
+            "]\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getrawtransactions",
+                           "\"[\\\"mytxid\\\",\\\"myothertxid\\\"]\"") +
+            HelpExampleCli("getrawtransactions",
+                           "\"[\\\"mytxid\\\",\\\"myothertxid\\\"]\" true") +
+            HelpExampleRpc("getrawtransactions",
+                           "[\"mytxid\",\"myothertxid\"], true"));
+    }
+
+    const UniValue &txids = request.params[0].get_array();
+    std::vector<TxId> vTxIds {};
+    vTxIds.reserve(txids.size());
+    for (size_t i = 0; i < txids.size(); ++i) {
+        vTxIds.emplace_back(ParseHashV(txids[i], "txid"));
+    }
+
+    bool fVerbose = false;
+    if (request.params.size() > 1) {
+        fVerbose = request.params[1].get_bool();
+    }
+
+    std::vector<CTransactionRef> vTxs {};
+    std::vector<uint256> vHashBlocks {};
+    GetTransactions(vTxIds, vTxs, vHashBlocks);
+
+    UniValue result(UniValue::VARR);
+    if (!fVerbose) {
+        for (const CTransactionRef &tx : vTxs) {
+            if (tx) {
+                result.push_back(EncodeHexTx(*tx, RPCSerializationFlags()));
+            } else {
+                result.push_back(NullUniValue);
+            }
+        }
+        return result;
+    }
+
+    // Only the verbose output needs the chain.
+    LOCK(cs_main);
+    for (size_t i = 0; i < vTxs.size(); ++i) {
+        if (!vTxs[i]) {
+            result.push_back(NullUniValue);
+            continue;
+        }
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(
+            Pair("hex", EncodeHexTx(*vTxs[i], RPCSerializationFlags())));
+        TxToJSON(*vTxs[i], vHashBlocks[i], entry);
+        result.push_back(entry);
+    }
+    return result;
+}
+
 static UniValue gettxoutproof(const Config &config,
                               const JSONRPCRequest &request) {
     if (request.fHelp ||
@@ -1133,12 +1294,13 @@ static UniValue sendrawtransaction(const Config &config,
 
 // clang-format off
 static const CRPCCommand commands[] = {
-    //  category            name                      actor (function)        okSafeMode
+    //  category            name                      actor (function)        okSafeMode  argNames  parallelSafe
     //  ------------------- ------------------------  ----------------------  ----------
-    { "rawtransactions",    "getrawtransaction",      getrawtransaction,      true,  {"txid","verbose"} },
+    { "rawtransactions",    "getrawtransaction",      getrawtransaction,      true,  {"txid","verbose"}, true },
+    { "rawtransactions",    "getrawtransactions",     getrawtransactions,     true,  {"txids","verbose"}, true },
     { "rawtransactions",    "createrawtransaction",   createrawtransaction,   true,  {"inputs","outputs","locktime"} },
-    { "rawtransactions",    "decoderawtransaction",   decoderawtransaction,   true,  {"hexstring"} },
-    { "rawtransactions",    "decodescript",           decodescript,           true,  {"hexstring"} },
+    { "rawtransactions",    "decoderawtransaction",   decoderawtransaction,   true,  {"hexstring"}, true },
+    { "rawtransactions",    "decodescript",           decodescript,           true,  {"hexstring"}, true },
     { "rawtransactions",    "sendrawtransaction",     sendrawtransaction,     false, {"hexstring","allowhighfees"} },
     { "rawtransactions",    "signrawtransaction",     signrawtransaction,     false, {"hexstring","prevtxs","privkeys","sighashtype"} }, /* uses wallet if enabled */
 
@@ -11,6 +11,7 @@
 #include "init.h"
 #include "random.h"
 #include "sync.h"
+#include "task_helpers.h"
 #include "ui_interface.h"
 #include "util.h"
 #include "utilstrencodings.h"
@@ -325,8 +326,21 @@ bool CRPCTable::appendCommand(const std::string &name,
     return true;
 }
 
+/**
+ * Threads for running batch entries concurrently. RPC commands can wait on
+ * the disk for a long time, so they get their own pool rather than sharing
+ * the one used for latency critical validation work.
+ */
+static CCriticalSection cs_rpcBatchPool;
+static std::shared_ptr<CThreadPool<CQueueAdaptor>> rpcBatchPool;
+
 bool StartRPC() {
     LogPrint(BCLog::RPC, "Starting RPC\n");
+    {
+        LOCK(cs_rpcBatchPool);
+        rpcBatchPool = std::make_shared<CThreadPool<CQueueAdaptor>>(
+            "RPCBatchPool", std::max(1, GetNumCores()));
+    }
     fRPCRunning = true;
     g_rpcSignals.Started();
     return true;
@@ -342,6 +356,11 @@ void StopRPC() {
     LogPrint(BCLog::RPC, "Stopping RPC\n");
     deadlineTimers.clear();
     DeleteAuthCookie();
+    {
+        // Batches still running keep their reference to the pool
+        LOCK(cs_rpcBatchPool);
+        rpcBatchPool.reset();
+    }
     g_rpcSignals.Stopped();
 }
 
@@ -420,18 +439,90 @@ static void JSONRPCExecOne(Config &config, JSONRPCRequest jreq,
     }
 }
 
+/**
+ * Execute a single (non streaming) batch entry and return its serialised
+ * reply, so that it can be run away from the HTTP request.
+ */
+static std::string JSONRPCExecToString(Config &config, JSONRPCRequest jreq,
+                                       const UniValue &req) {
+    try {
+        jreq.parse(req);
+        UniValue result = tableRPC.execute(config, jreq);
+        return JSONRPCReplyObj(result, NullUniValue, jreq.id).write();
+    } catch (const UniValue &objError) {
+        return JSONRPCReplyObj(NullUniValue, objError, jreq.id).write();
+    } catch (const std::exception &e) {
+        return JSONRPCReplyObj(NullUniValue,
+                               JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id)
+            .write();
+    }
+}
+
+/** Whether the batch entry calls a command marked as parallelSafe */
+static bool IsParallelSafeBatchEntry(const UniValue &req) {
+    if (!req.isObject()) {
+        return false;
+    }
+    const UniValue &valMethod = find_value(req.get_obj(), "method");
+    if (!valMethod.isStr()) {
+        return false;
+    }
+    const CRPCCommand *pcmd = tableRPC[valMethod.get_str()];
+    return pcmd && pcmd->parallelSafe;
+}
+
 void JSONRPCExecBatch(Config &config, const JSONRPCRequest &jreq,
                              const UniValue &vReq, HTTPRequest& httpReq) {
 
     httpReq.WriteHeader("Content-Type", "application/json");
     httpReq.StartWritingChunks(HTTP_OK);
 
+    std::shared_ptr<CThreadPool<CQueueAdaptor>> pool {};
+    {
+        LOCK(cs_rpcBatchPool);
+        pool = rpcBatchPool;
+    }
+
     httpReq.WriteReplyChunk("[");
     std::string delimiter;
-    for (size_t i = 0; i < vReq.size(); i++) {
-        httpReq.WriteReplyChunk(delimiter);
-        JSONRPCExecOne(config, jreq, vReq[i], httpReq);
-        delimiter = ",";
+    size_t i = 0;
+    while (i < vReq.size()) {
+        // Consecutive entries calling side effect free commands are executed
+        // concurrently; every other entry waits for the ones before it and
+        // runs on its own, as if the batch was executed serially. Replies are
+        // always written in request order.
+        size_t end = i;
+        while (end < vReq.size() && IsParallelSafeBatchEntry(vReq[end])) {
+            ++end;
+        }
+        if (end - i < 2 || !pool) {
+            httpReq.WriteReplyChunk(delimiter);
+            JSONRPCExecOne(config, jreq, vReq[i], httpReq);
+            delimiter = ",";
+            ++i;
+            continue;
+        }
+
+        const std::vector<std::vector<std::string>> vReplies {
+            parallel_for_chunks(
+                *pool, end - i, 1, pool->getPoolSize() + 1,
+                [&config, &jreq, &vReq, i](size_t begin, size_t end) {
+                    std::vector<std::string> replies {};
+                    replies.reserve(end - begin);
+                    for (size_t j = i + begin; j < i + end; ++j) {
+                        replies.emplace_back(
+                            JSONRPCExecToString(config, jreq, vReq[j]));
+                    }
+                    return replies;
+                })};
+        for (const std::vector<std::string> &replies : vReplies) {
+            for (const std::string &reply : replies) {
+                httpReq.WriteReplyChunk(delimiter);
+                httpReq.WriteReplyChunk(reply);
+                delimiter = ",";
+            }
+        }
+        i = end;
     }
     httpReq.WriteReplyChunk("]\n");
     httpReq.StopWritingChunks();
@@ -160,12 +160,19 @@ private:
 
 public:
     std::vector<std::string> argNames;
+    /**
+     * The command has no side effects, so entries of a JSON-RPC batch that
+     * call it may be executed concurrently with each other.
+     */
+    bool parallelSafe;
 
     CRPCCommand(std::string _category, std::string _name, rpcfn_type _actor,
-                bool _okSafeMode, std::vector<std::string> _argNames)
+                bool _okSafeMode, std::vector<std::string> _argNames,
+                bool _parallelSafe = false)
         : category{std::move(_category)}, name{std::move(_name)},
           okSafeMode{_okSafeMode}, useConstConfig{false}, argNames{std::move(
-                                                              _argNames)} {
+                                                              _argNames)},
+          parallelSafe{_parallelSafe} {
         actor.fn = _actor;
     }
 
@@ -176,10 +183,11 @@ public:
      */
     CRPCCommand(std::string _category, std::string _name,
                 const_rpcfn_type _actor, bool _okSafeMode,
-                std::vector<std::string> _argNames)
+                std::vector<std::string> _argNames, bool _parallelSafe = false)
         : category{std::move(_category)}, name{std::move(_name)},
           okSafeMode{_okSafeMode}, useConstConfig{true}, argNames{std::move(
-                                                             _argNames)} {
+                                                             _argNames)},
+          parallelSafe{_parallelSafe} {
         actor.cfn = _actor;
     }
 
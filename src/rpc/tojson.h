@@ -9,15 +9,30 @@
 
 #include <univalue.h>
 
+class CBlockHeader;
+class CBlockIndex;
+class CJSONWriter;
 class CScript;
+class CTransaction;
+class Config;
 
 void ScriptPubKeyToJSON(const Config &config, const CScript &scriptPubKey,
                         UniValue &out, bool fIncludeHex);
 void TxToJSON(const Config &config, const CTransaction &tx,
               const uint256 hashBlock, UniValue &entry);
+
+/**
+ * Write the members of the scriptPubKey and transaction objects that
+ * ScriptPubKeyToUniv() and TxToUniv() build, straight into a JSON writer.
+ */
+void ScriptPubKeyToJSON(const CScript &scriptPubKey, bool fIncludeHex,
+                        CJSONWriter &entry);
+void TxToJSON(const CTransaction &tx, const uint256 &hashBlock,
+              CJSONWriter &entry);
 std::string headerBlockToJSON(const Config &config, const CBlockHeader &blockHeader,
                      const CBlockIndex *blockindex);
-UniValue blockTxToJSON(const Config &config, const CTransaction& tx, bool txDetails);
+void blockTxToJSON(const Config &config, const CTransaction& tx, bool txDetails,
+                   CJSONWriter& writer);
 UniValue blockheaderToJSON(const CBlockIndex *blockindex);
 
 #endif // BITCOIN_RPCTOJSON_H
@@ -115,13 +115,67 @@ bool CastToBool(const valtype &vch) {
  */
 #define stacktop(i) (stack.at(stack.size() + (i)))
 #define altstacktop(i) (altstack.at(altstack.size() + (i)))
+
+namespace {
+
+/**
+ * Buffers of popped stack elements, kept for reuse by later pushes.
+ *
+ * Elements are pushed and popped all the time while a script runs; recycling
+ * their buffers means that, once warmed up, evaluation rarely needs to go to
+ * the heap. The pool is per thread, so it needs no locking, and bounded by
+ * the script limits.
+ */
+class CStackElementPool {
+public:
+    valtype Acquire() {
+        if (mBuffers.empty()) {
+            return valtype{};
+        }
+        valtype buffer{std::move(mBuffers.back())};
+        mBuffers.pop_back();
+        buffer.clear();
+        return buffer;
+    }
+
+    void Release(valtype &&buffer) {
+        if (buffer.capacity() > 0 &&
+            buffer.capacity() <= MAX_SCRIPT_ELEMENT_SIZE &&
+            mBuffers.size() < MAX_STACK_SIZE) {
+            mBuffers.emplace_back(std::move(buffer));
+        }
+    }
+
+private:
+    std::vector<valtype> mBuffers{};
+};
+
+thread_local CStackElementPool stackElementPool;
+
+} // namespace
+
 static inline void popstack(std::vector<valtype> &stack) {
     if (stack.empty()) {
         throw std::runtime_error("popstack(): stack empty");
     }
+    stackElementPool.Release(std::move(stack.back()));
     stack.pop_back();
 }
 
+/** Push a copy of vch, in a recycled buffer if there is one */
+static inline void pushcopy(std::vector<valtype> &stack, const valtype &vch) {
+    valtype elem{stackElementPool.Acquire()};
+    elem.assign(vch.begin(), vch.end());
+    stack.push_back(std::move(elem));
+}
+
+/** Move the top element of one stack to the top of another */
+static inline void movetop(std::vector<valtype> &from,
+                           std::vector<valtype> &to) {
+    to.push_back(std::move(from.back()));
+    from.pop_back();
+}
+
 static bool IsCompressedOrUncompressedPubKey(const valtype &vchPubKey) {
     if (vchPubKey.size() < 33) {
         //  Non-canonical public key: too short
@@ -416,7 +470,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                     !CheckMinimalPush(vchPushValue, opcode)) {
                     return set_error(serror, SCRIPT_ERR_MINIMALDATA);
                 }
-                stack.push_back(vchPushValue);
+                pushcopy(stack, vchPushValue);
             } else if (fExec || (OP_IF <= opcode && opcode <= OP_ENDIF)) {
                 switch (opcode) {
                     //
@@ -641,8 +695,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
                         }
-                        altstack.push_back(stacktop(-1));
-                        popstack(stack);
+                        movetop(stack, altstack);
                     } break;
 
                     case OP_FROMALTSTACK: {
@@ -650,8 +703,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, SCRIPT_ERR_INVALID_ALTSTACK_OPERATION);
                         }
-                        stack.push_back(altstacktop(-1));
-                        popstack(altstack);
+                        movetop(altstack, stack);
                     } break;
 
                     case OP_2DROP: {
@@ -670,10 +722,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-2);
-                        valtype vch2 = stacktop(-1);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
+                        pushcopy(stack, stacktop(-2));
+                        pushcopy(stack, stacktop(-2));
                     } break;
 
                     case OP_3DUP: {
@@ -682,12 +732,9 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-3);
-                        valtype vch2 = stacktop(-2);
-                        valtype vch3 = stacktop(-1);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
-                        stack.push_back(vch3);
+                        pushcopy(stack, stacktop(-3));
+                        pushcopy(stack, stacktop(-3));
+                        pushcopy(stack, stacktop(-3));
                     } break;
 
                     case OP_2OVER: {
@@ -696,10 +743,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-4);
-                        valtype vch2 = stacktop(-3);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
+                        pushcopy(stack, stacktop(-4));
+                        pushcopy(stack, stacktop(-4));
                     } break;
 
                     case OP_2ROT: {
@@ -708,11 +753,11 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-6);
-                        valtype vch2 = stacktop(-5);
+                        valtype vch1 = std::move(stacktop(-6));
+                        valtype vch2 = std::move(stacktop(-5));
                         stack.erase(stack.end() - 6, stack.end() - 4);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
+                        stack.push_back(std::move(vch1));
+                        stack.push_back(std::move(vch2));
                     } break;
 
                     case OP_2SWAP: {
@@ -731,9 +776,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-1);
-                        if (CastToBool(vch)) {
-                            stack.push_back(vch);
+                        if (CastToBool(stacktop(-1))) {
+                            pushcopy(stack, stacktop(-1));
                         }
                     } break;
 
@@ -758,8 +802,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-1);
-                        stack.push_back(vch);
+                        pushcopy(stack, stacktop(-1));
                     } break;
 
                     case OP_NIP: {
@@ -768,6 +811,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
                         }
+                        stackElementPool.Release(std::move(stacktop(-2)));
                         stack.erase(stack.end() - 2);
                     } break;
 
@@ -777,8 +821,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-2);
-                        stack.push_back(vch);
+                        pushcopy(stack, stacktop(-2));
                     } break;
 
                     case OP_PICK:
@@ -796,11 +839,13 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-n - 1);
                         if (opcode == OP_ROLL) {
+                            valtype vch = std::move(stacktop(-n - 1));
                             stack.erase(stack.end() - n - 1);
+                            stack.push_back(std::move(vch));
+                        } else {
+                            pushcopy(stack, stacktop(-n - 1));
                         }
-                        stack.push_back(vch);
                     } break;
 
                     case OP_ROT: {
@@ -830,8 +875,9 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-1);
-                        stack.insert(stack.end() - 2, vch);
+                        valtype vch{stackElementPool.Acquire()};
+                        vch.assign(stacktop(-1).begin(), stacktop(-1).end());
+                        stack.insert(stack.end() - 2, std::move(vch));
                     } break;
 
                     case OP_SIZE: {
@@ -957,7 +1003,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             //    fEqual = !fEqual;
                             popstack(stack);
                             popstack(stack);
-                            stack.push_back(fEqual ? vchTrue : vchFalse);
+                            pushcopy(stack, fEqual ? vchTrue : vchFalse);
                             if (opcode == OP_EQUALVERIFY) {
                                 if (fEqual) {
                                     popstack(stack);
@@ -1132,7 +1178,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                         popstack(stack);
                         popstack(stack);
                         popstack(stack);
-                        stack.push_back(fValue ? vchTrue : vchFalse);
+                        pushcopy(stack, fValue ? vchTrue : vchFalse);
                     } break;
 
                     //
@@ -1149,11 +1195,12 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
                         }
                         valtype &vch = stacktop(-1);
-                        valtype vchHash((opcode == OP_RIPEMD160 ||
-                                         opcode == OP_SHA1 ||
-                                         opcode == OP_HASH160)
-                                            ? 20
-                                            : 32);
+                        valtype vchHash{stackElementPool.Acquire()};
+                        vchHash.resize((opcode == OP_RIPEMD160 ||
+                                        opcode == OP_SHA1 ||
+                                        opcode == OP_HASH160)
+                                           ? 20
+                                           : 32);
                         if (opcode == OP_RIPEMD160) {
                             CRIPEMD160()
                                 .Write(vch.data(), vch.size())
@@ -1176,7 +1223,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 .Finalize(vchHash.data());
                         }
                         popstack(stack);
-                        stack.push_back(vchHash);
+                        stack.push_back(std::move(vchHash));
                     } break;
 
                     case OP_CODESEPARATOR: {
@@ -1217,7 +1264,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
 
                         popstack(stack);
                         popstack(stack);
-                        stack.push_back(fSuccess ? vchTrue : vchFalse);
+                        pushcopy(stack, fSuccess ? vchTrue : vchFalse);
                         if (opcode == OP_CHECKSIGVERIFY) {
                             if (fSuccess) {
                                 popstack(stack);
@@ -1350,7 +1397,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                         }
                         popstack(stack);
 
-                        stack.push_back(fSuccess ? vchTrue : vchFalse);
+                        pushcopy(stack, fSuccess ? vchTrue : vchFalse);
 
                         if (opcode == OP_CHECKMULTISIGVERIFY) {
                             if (fSuccess) {
@@ -1479,7 +1526,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
             }
 
             // Size limits
-            if (stack.size() + altstack.size() > 1000) {
+            if (stack.size() + altstack.size() > MAX_STACK_SIZE) {
                 return set_error(serror, SCRIPT_ERR_STACK_SIZE);
             }
         }
@@ -9,12 +9,11 @@
 #include "primitives/transaction.h"
 #include "random.h"
 #include "script/sigcache.h"
-#include "sync.h"
 #include "util.h"
 #include "validation.h"
 
-CCriticalSection cs_script_cache;
-static CuckooCache::cache<uint256, SignatureCacheHasher> scriptExecutionCache;
+static CuckooCache::sharded_cache<uint256, SignatureCacheHasher>
+    scriptExecutionCache;
 static uint256 scriptExecutionCacheNonce(GetRandHash());
 
 void InitScriptExecutionCache() {
@@ -48,11 +47,9 @@ uint256 GetScriptCacheKey(const CTransaction &tx, uint32_t flags) {
 }
 
 bool IsKeyInScriptCache(uint256 key, bool erase) {
-    LOCK(cs_script_cache);
     return scriptExecutionCache.contains(key, erase);
 }
 
 void AddKeyInScriptCache(uint256 key) {
-    LOCK(cs_script_cache);
     scriptExecutionCache.insert(key);
 }
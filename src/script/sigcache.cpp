@@ -6,13 +6,15 @@
 #include "sigcache.h"
 
 #include "cuckoocache.h"
+#include "hash.h"
 #include "memusage.h"
 #include "pubkey.h"
 #include "random.h"
 #include "uint256.h"
 #include "util.h"
 
-#include <boost/thread.hpp>
+#include <array>
+#include <mutex>
 
 namespace {
 
@@ -25,9 +27,9 @@ class CSignatureCache {
 private:
     //! Entries are SHA256(nonce || signature hash || public key || signature):
     uint256 nonce;
-    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    typedef CuckooCache::sharded_cache<uint256, SignatureCacheHasher>
+        map_type;
     map_type setValid;
-    boost::shared_mutex cs_sigcache;
 
 public:
     CSignatureCache() { GetRandBytes(nonce.begin(), 32); }
@@ -44,14 +46,10 @@ public:
     }
 
     bool Get(const uint256 &entry, const bool erase) {
-        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
         return setValid.contains(entry, erase);
     }
 
-    void Set(uint256 &entry) {
-        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
-        setValid.insert(entry);
-    }
+    void Set(uint256 &entry) { setValid.insert(entry); }
     uint32_t setup_bytes(size_t n) { return setValid.setup_bytes(n); }
 };
 
@@ -63,6 +61,68 @@ public:
  * signatureCache could be made local to VerifySignature.
  */
 static CSignatureCache signatureCache;
+
+/**
+ * Cache of parsed public keys, keyed by their serialization.
+ *
+ * Each key maps to exactly one slot, chosen by a salted hash, and a new key
+ * simply replaces whatever the slot held. Lookups cost one hash and a compare,
+ * memory is allocated once up front, and colliding keys can only cause cache
+ * misses. Slots are guarded by a fixed set of striped locks.
+ */
+class CPubKeyCache {
+private:
+    struct Entry {
+        CPubKey pubkey;
+        CParsedPubKey parsed;
+    };
+
+    static constexpr size_t LOCK_STRIPES = 64;
+
+    uint64_t k0;
+    uint64_t k1;
+    std::vector<Entry> entries;
+    std::array<std::mutex, LOCK_STRIPES> locks;
+
+    size_t Slot(const CPubKey &pubkey) const {
+        return CSipHasher(k0, k1).Write(pubkey.begin(), pubkey.size())
+                   .Finalize() %
+               entries.size();
+    }
+
+public:
+    CPubKeyCache() : k0(GetRand(UINT64_MAX)), k1(GetRand(UINT64_MAX)) {}
+
+    // Not thread safe; called once before any lookups
+    size_t setup_bytes(size_t bytes) {
+        entries.assign(bytes / sizeof(Entry), Entry{});
+        return entries.size();
+    }
+
+    bool Parse(const CPubKey &pubkey, CParsedPubKey &parsed) {
+        if (entries.empty() || !pubkey.IsValid()) {
+            return pubkey.Parse(parsed);
+        }
+        const size_t slot = Slot(pubkey);
+        Entry &entry = entries[slot];
+        {
+            std::lock_guard<std::mutex> lock(locks[slot % LOCK_STRIPES]);
+            if (entry.pubkey == pubkey) {
+                parsed = entry.parsed;
+                return true;
+            }
+        }
+        if (!pubkey.Parse(parsed)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(locks[slot % LOCK_STRIPES]);
+        entry.pubkey = pubkey;
+        entry.parsed = parsed;
+        return true;
+    }
+};
+
+static CPubKeyCache pubkeyCache;
 } // namespace
 
 // To be called once in AppInit2/TestingSetup to initialize the signatureCache
@@ -79,6 +139,26 @@ void InitSignatureCache() {
     LogPrintf("Using %zu MiB out of %zu requested for signature cache, able to "
               "store %zu elements\n",
               (nElems * sizeof(uint256)) >> 20, nMaxCacheSize >> 20, nElems);
+
+    size_t nMaxPubKeyCacheSize =
+        std::min(std::max(int64_t(0),
+                          gArgs.GetArg("-maxpubkeycachesize",
+                                       DEFAULT_MAX_PUBKEY_CACHE_SIZE)),
+                 MAX_MAX_SIG_CACHE_SIZE) *
+        (size_t(1) << 20);
+    size_t nPubKeys = pubkeyCache.setup_bytes(nMaxPubKeyCacheSize);
+    LogPrintf("Using %zu MiB for parsed public key cache, able to store %zu "
+              "keys\n",
+              nMaxPubKeyCacheSize >> 20, nPubKeys);
+}
+
+bool VerifyWithPubKeyCache(const CPubKey &pubkey, const uint256 &hash,
+                           const std::vector<uint8_t> &vchSig) {
+    CParsedPubKey parsed;
+    if (!pubkeyCache.Parse(pubkey, parsed)) {
+        return false;
+    }
+    return CPubKey::Verify(hash, vchSig, parsed);
 }
 
 bool CachingTransactionSignatureChecker::VerifySignature(
@@ -89,8 +169,7 @@ bool CachingTransactionSignatureChecker::VerifySignature(
     if (signatureCache.Get(entry, !store)) {
         return true;
     }
-    if (!TransactionSignatureChecker::VerifySignature(vchSig, pubkey,
-                                                      sighash)) {
+    if (!VerifyWithPubKeyCache(pubkey, sighash, vchSig)) {
         return false;
     }
     if (store) {
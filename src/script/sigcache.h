@@ -16,6 +16,8 @@
 static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 32;
 // Maximum sig cache size allowed
 static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
+// Parsed public key cache size in MiB, about 60000 keys
+static const unsigned int DEFAULT_MAX_PUBKEY_CACHE_SIZE = 8;
 
 class CPubKey;
 
@@ -58,4 +60,12 @@ public:
 
 void InitSignatureCache();
 
+/**
+ * Verify a signature like CPubKey::Verify, but take the parsed public key from
+ * a cache shared by all threads, so keys that sign many inputs (exchange and
+ * pool payout keys, for example) are only parsed once.
+ */
+bool VerifyWithPubKeyCache(const CPubKey &pubkey, const uint256 &hash,
+                           const std::vector<uint8_t> &vchSig);
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
@@ -0,0 +1,31 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "task_helpers.h"
+
+#include <cassert>
+#include <memory>
+
+namespace
+{
+    std::unique_ptr<CThreadPool<CQueueAdaptor>> pParallelTaskPool {};
+}
+
+void InitParallelTaskPool(size_t numThreads)
+{
+    assert(!pParallelTaskPool);
+    pParallelTaskPool = std::make_unique<CThreadPool<CQueueAdaptor>>(
+        "ParallelPool", std::max<size_t>(1, numThreads));
+}
+
+void ShutdownParallelTaskPool()
+{
+    // Joins the pool threads after they have finished their current tasks
+    pParallelTaskPool.reset();
+}
+
+CThreadPool<CQueueAdaptor>& GetParallelTaskPool()
+{
+    assert(pParallelTaskPool);
+    return *pParallelTaskPool;
+}
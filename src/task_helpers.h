@@ -6,8 +6,10 @@
 #include "task.h"
 #include "threadpool.h"
 
+#include <algorithm>
 #include <future>
 #include <type_traits>
+#include <vector>
 
 // Helper method to create task with a specified priority.
 template<typename ThreadPool, typename Priority, typename Callable, typename... Args>
@@ -29,3 +31,74 @@ auto make_task(ThreadPool& pool, Callable&& call, Args&&... args)
     CTask::Priority priority { CTask::Priority::Medium };
     return make_task(pool, priority, std::forward<Callable>(call), std::forward<Args>(args)...);
 }
+
+/**
+* Run a callable over the index range [0, count) split into contiguous chunks,
+* in parallel.
+*
+* The range is split into at most maxChunks chunks of at least minChunkSize
+* elements each and func(begin, end) is called once per chunk; the first chunk
+* runs on the calling thread and the rest as tasks on the given pool. The
+* results are returned in chunk order.
+*
+* Must not be called from a task running on the same pool.
+*/
+template<typename ThreadPool, typename Callable>
+auto parallel_for_chunks(ThreadPool& pool, size_t count, size_t minChunkSize,
+                         size_t maxChunks, Callable&& func)
+    -> std::vector<typename std::result_of<Callable(size_t, size_t)>::type>
+{
+    using resultType = typename std::result_of<Callable(size_t, size_t)>::type;
+
+    const size_t numChunks {
+        std::max<size_t>(1, std::min(maxChunks, count / std::max<size_t>(1, minChunkSize)))
+    };
+    const size_t chunkSize { (count + numChunks - 1) / numChunks };
+
+    std::vector<std::future<resultType>> futures {};
+    futures.reserve(numChunks - 1);
+    std::vector<resultType> results {};
+    results.reserve(numChunks);
+    try
+    {
+        for(size_t chunk = 1; chunk < numChunks; ++chunk)
+        {
+            const size_t begin { std::min(count, chunk * chunkSize) };
+            const size_t end { std::min(count, begin + chunkSize) };
+            futures.emplace_back(make_task(pool, func, begin, end));
+        }
+
+        results.emplace_back(func(0, std::min(count, chunkSize)));
+        for(auto& future : futures)
+        {
+            results.emplace_back(future.get());
+        }
+    }
+    catch(...)
+    {
+        // Tasks may still be referring to the caller's data
+        for(auto& future : futures)
+        {
+            if(future.valid())
+                future.wait();
+        }
+        throw;
+    }
+
+    return results;
+}
+
+/**
+* The shared pool for splitting short CPU bound work across all cores with
+* parallel_for_chunks(). Latency critical work such as compact block
+* reconstruction runs on it and its queue is FIFO, so it is reserved for tasks
+* that neither touch the disk nor wait on locks; longer running work must use
+* a pool of its own.
+*
+* The pool is created by InitParallelTaskPool() during startup and stopped by
+* ShutdownParallelTaskPool(); GetParallelTaskPool() must only be called in
+* between.
+*/
+void InitParallelTaskPool(size_t numThreads);
+void ShutdownParallelTaskPool();
+CThreadPool<CQueueAdaptor>& GetParallelTaskPool();
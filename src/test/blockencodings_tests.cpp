@@ -368,6 +368,137 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(LargeMempoolRoundTripTest) {
+    constexpr size_t mempoolTxns = 50000;
+    constexpr size_t blockTxnStride = 1000;
+
+    CTxMemPool pool;
+    TestMemPoolEntryHelper entry;
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig.resize(10);
+    coinbase.vout.resize(1);
+    coinbase.vout[0].nValue = Amount(42);
+
+    CBlock block;
+    block.vtx.emplace_back(MakeTransactionRef(std::move(coinbase)));
+    block.nVersion = 42;
+    block.hashPrevBlock = InsecureRand256();
+    block.nBits = 0x207fffff;
+
+    for (size_t i = 0; i < mempoolTxns; i++) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+        tx.vout.resize(1);
+        tx.vout[0].nValue = Amount(42);
+        CTransactionRef txRef = MakeTransactionRef(std::move(tx));
+        pool.AddUnchecked(txRef->GetId(), entry.FromTx(*txRef), nullChangeSet);
+        // Include the last mempool transaction so that the final chunk of
+        // the scan is covered as well.
+        if (i % blockTxnStride == 0 || i == mempoolTxns - 1) {
+            block.vtx.emplace_back(txRef);
+        }
+    }
+
+    bool mutated;
+    block.hashMerkleRoot = BlockMerkleRoot(block, &mutated);
+    assert(!mutated);
+
+    GlobalConfig config;
+    while (!CheckProofOfWork(block.GetHash(), block.nBits, config)) {
+        ++block.nNonce;
+    }
+
+    CBlockHeaderAndShortTxIDs shortIDs(block);
+    PartiallyDownloadedBlock partialBlock(GlobalConfig::GetConfig(), &pool);
+    // Force the scan to be split up regardless of the number of cores
+    partialBlock.SetShortIdScanChunking(8, 1000);
+    BOOST_CHECK(partialBlock.InitData(shortIDs, extra_txn) == READ_STATUS_OK);
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        BOOST_CHECK(partialBlock.IsTxAvailable(i));
+    }
+
+    CBlock block2;
+    BOOST_CHECK(partialBlock.FillBlock(block2, {}) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(block.GetHash().ToString(), block2.GetHash().ToString());
+    BOOST_CHECK_EQUAL(block.hashMerkleRoot.ToString(),
+                      BlockMerkleRoot(block2, &mutated).ToString());
+    BOOST_CHECK(!mutated);
+}
+
+static CTransactionRef BuildCollisionTestTx(uint32_t n) {
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(uint256(), n);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = Amount(42);
+    return MakeTransactionRef(std::move(tx));
+}
+
+// Reconstruct a compact block for txA and txC from a mempool holding txA, txB
+// and txC at the given positions among unrelated transactions, scanning the
+// mempool in the given number of chunks. txA and txB have the same short ID.
+static std::vector<bool> ReconstructWithCollision(size_t posA, size_t posB,
+                                                  size_t posC,
+                                                  size_t numChunks) {
+    // Found by brute force search: with the header and nonce below, these
+    // two transactions have the same short ID.
+    CTransactionRef txA = BuildCollisionTestTx(18739731);
+    CTransactionRef txB = BuildCollisionTestTx(32879511);
+    CTransactionRef txC = BuildCollisionTestTx(1);
+
+    CBlock block;
+    block.nVersion = 42;
+    block.nBits = 0x207fffff;
+    block.vtx.push_back(BuildCollisionTestTx(0));
+    TestHeaderAndShortIDs shortIDs(block);
+    shortIDs.nonce = 0;
+    shortIDs.prefilledtxn.resize(1);
+    shortIDs.prefilledtxn[0] = {0, block.vtx[0]};
+    shortIDs.shorttxids = {shortIDs.GetShortID(txA->GetId()),
+                           shortIDs.GetShortID(txC->GetId())};
+    BOOST_REQUIRE_EQUAL(shortIDs.GetShortID(txA->GetId()),
+                        shortIDs.GetShortID(txB->GetId()));
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << shortIDs;
+    CBlockHeaderAndShortTxIDs cmpctblock;
+    stream >> cmpctblock;
+
+    CTxMemPool pool;
+    TestMemPoolEntryHelper entry;
+    for (size_t i = 0; i < 40; i++) {
+        CTransactionRef tx = (i == posA) ? txA
+                             : (i == posB) ? txB
+                             : (i == posC) ? txC
+                             : BuildCollisionTestTx(1000 + i);
+        pool.AddUnchecked(tx->GetId(), entry.FromTx(*tx), nullChangeSet);
+    }
+
+    PartiallyDownloadedBlock partialBlock(GlobalConfig::GetConfig(), &pool);
+    partialBlock.SetShortIdScanChunking(numChunks, 1);
+    BOOST_REQUIRE(partialBlock.InitData(cmpctblock, extra_txn) ==
+                  READ_STATUS_OK);
+    return {partialBlock.IsTxAvailable(0), partialBlock.IsTxAvailable(1),
+            partialBlock.IsTxAvailable(2)};
+}
+
+BOOST_AUTO_TEST_CASE(ShortIdCollisionAcrossChunksTest) {
+    // The colliding transaction is seen before the scan completes, so the
+    // collided slot must be requested.
+    std::vector<bool> expected {true, false, true};
+    BOOST_CHECK(ReconstructWithCollision(0, 15, 30, 1) == expected);
+    BOOST_CHECK(ReconstructWithCollision(0, 15, 30, 4) == expected);
+
+    // The scan stops as soon as all short IDs are matched, before reaching the
+    // colliding transaction in a later chunk.
+    expected = {true, true, true};
+    BOOST_CHECK(ReconstructWithCollision(0, 30, 10, 1) == expected);
+    BOOST_CHECK(ReconstructWithCollision(0, 30, 10, 4) == expected);
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = InsecureRand256();
@@ -0,0 +1,155 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "blockfileinfostore.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Block files far away from the ones used by the test chain
+    constexpr int TEST_FILE { 1000 };
+
+    std::vector<uint8_t> ReadFile(BlockFileType type, int nFile)
+    {
+        CDiskBlockPos pos { nFile, 0 };
+        FILE* file { type == BlockFileType::BLOCK ?
+            CDiskFiles::OpenBlockFile(pos, true) :
+            CDiskFiles::OpenUndoFile(pos, true) };
+        BOOST_REQUIRE(file);
+        std::vector<uint8_t> contents {};
+        uint8_t buf[256];
+        size_t nRead {};
+        while((nRead = fread(buf, 1, sizeof(buf), file)) > 0)
+        {
+            contents.insert(contents.end(), buf, buf + nRead);
+        }
+        fclose(file);
+        return contents;
+    }
+
+    // Records the order in which files are committed and the block index is
+    // flushed.
+    class EventLog
+    {
+      public:
+        void Add(const std::string& event)
+        {
+            std::lock_guard<std::mutex> lock { mMtx };
+            mEvents.push_back(event);
+        }
+        std::vector<std::string> Get() const
+        {
+            std::lock_guard<std::mutex> lock { mMtx };
+            return mEvents;
+        }
+
+      private:
+        mutable std::mutex mMtx {};
+        std::vector<std::string> mEvents {};
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(blockfilewriter_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(writes_in_order)
+{
+    CBlockFileWriter writer {};
+
+    std::vector<uint8_t> first(100, 0x01);
+    std::vector<uint8_t> second(50, 0x02);
+    std::vector<uint8_t> undo(20, 0x03);
+    BOOST_CHECK(writer.Write(BlockFileType::BLOCK, { TEST_FILE, 0 }, std::vector<uint8_t>{first}));
+    BOOST_CHECK(writer.Write(BlockFileType::BLOCK, { TEST_FILE, 100 }, std::vector<uint8_t>{second}));
+    BOOST_CHECK(writer.Write(BlockFileType::UNDO, { TEST_FILE, 0 }, std::vector<uint8_t>{undo}));
+
+    writer.WaitForWrites(BlockFileType::BLOCK, TEST_FILE);
+    std::vector<uint8_t> expected { first };
+    expected.insert(expected.end(), second.begin(), second.end());
+    BOOST_CHECK(ReadFile(BlockFileType::BLOCK, TEST_FILE) == expected);
+
+    writer.WaitForWrites(BlockFileType::UNDO, TEST_FILE);
+    BOOST_CHECK(ReadFile(BlockFileType::UNDO, TEST_FILE) == undo);
+    BOOST_CHECK_EQUAL(writer.GetQueuedBytes(), 0U);
+
+    // Finalizing truncates the files to their final sizes
+    writer.Finalize(TEST_FILE, 120, 10);
+    BOOST_CHECK(writer.Sync(TEST_FILE));
+    expected.resize(120);
+    BOOST_CHECK(ReadFile(BlockFileType::BLOCK, TEST_FILE) == expected);
+    undo.resize(10);
+    BOOST_CHECK(ReadFile(BlockFileType::UNDO, TEST_FILE) == undo);
+
+    writer.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(sync_commits_before_index_flush)
+{
+    EventLog events {};
+    // A slow disk
+    CBlockFileWriter writer { DEFAULT_MAX_QUEUED_BLOCK_FILE_WRITES,
+        [&events](FILE* file) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{50});
+            FileCommit(file);
+            events.Add("commit");
+        }
+    };
+
+    // Data in a finalized file and in the current one
+    BOOST_CHECK(writer.Write(BlockFileType::BLOCK, { TEST_FILE, 0 }, std::vector<uint8_t>(10)));
+    writer.Finalize(TEST_FILE, 10, 0);
+    BOOST_CHECK(writer.Write(BlockFileType::BLOCK, { TEST_FILE + 1, 0 }, std::vector<uint8_t>(10)));
+
+    // Flushing the block index must wait for both block and undo files of
+    // both block files to be committed.
+    BOOST_CHECK(writer.Sync(TEST_FILE + 1));
+    events.Add("index");
+
+    BOOST_CHECK((events.Get() ==
+        std::vector<std::string>{"commit", "commit", "commit", "commit", "index"}));
+
+    writer.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(queue_is_bounded)
+{
+    std::promise<void> release {};
+    std::shared_future<void> released { release.get_future() };
+    CBlockFileWriter writer { 15,
+        [released](FILE* file) {
+            released.wait();
+            FileCommit(file);
+        }
+    };
+
+    // Hold up the writer thread
+    writer.Finalize(TEST_FILE, 0, 0);
+
+    // A write that doesn't fit only goes in once the queue has room, but a
+    // write larger than the limit still goes into an empty queue.
+    BOOST_CHECK(writer.Write(BlockFileType::BLOCK, { TEST_FILE + 1, 0 }, std::vector<uint8_t>(10)));
+    BOOST_CHECK_EQUAL(writer.GetQueuedBytes(), 10U);
+    std::future<bool> blocked { std::async(std::launch::async,
+        [&writer] {
+            return writer.Write(BlockFileType::BLOCK, { TEST_FILE + 1, 10 }, std::vector<uint8_t>(20));
+        })
+    };
+    BOOST_CHECK(blocked.wait_for(std::chrono::milliseconds{100}) == std::future_status::timeout);
+    BOOST_CHECK_EQUAL(writer.GetQueuedBytes(), 10U);
+
+    release.set_value();
+    BOOST_CHECK(blocked.get());
+    BOOST_CHECK(writer.Sync(TEST_FILE + 1));
+    BOOST_CHECK_EQUAL(ReadFile(BlockFileType::BLOCK, TEST_FILE + 1).size(), 30U);
+
+    writer.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,289 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "chain.h"
+#include "chainparams.h"
+#include "config.h"
+#include "pow.h"
+#include "random.h"
+#include "txdb.h"
+#include "util.h"
+#include "validation.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    struct RegtestingSetup : public TestingSetup {
+        RegtestingSetup() : TestingSetup(CBaseChainParams::REGTEST) {}
+    };
+
+    constexpr uint32_t TEST_BITS = 0x207fffff;
+
+    // A chain of block index entries to write to the database
+    class TestChain {
+    public:
+        explicit TestChain(size_t length) {
+            const Config &config = GlobalConfig::GetConfig();
+            hashes.reserve(length + 1);
+            entries.reserve(length + 1);
+            for (size_t i = 0; i < length; ++i) {
+                CBlockHeader header = MakeHeader(i);
+                while (!CheckProofOfWork(header.GetHash(), header.nBits,
+                                         config)) {
+                    ++header.nNonce;
+                }
+                Add(header);
+            }
+        }
+
+        // Add an entry on top of the chain that fails its proof of work check.
+        // Entries are stored in hash order, so pick one that sorts around
+        // 95% of the way through the database.
+        const uint256 &AddInvalid() {
+            const Config &config = GlobalConfig::GetConfig();
+            CBlockHeader header = MakeHeader(entries.size());
+            while (CheckProofOfWork(header.GetHash(), header.nBits, config) ||
+                   *header.GetHash().begin() < 0xf0 ||
+                   *header.GetHash().begin() >= 0xf8) {
+                ++header.nNonce;
+            }
+            Add(header);
+            return hashes.back();
+        }
+
+        void Write(CBlockTreeDB &blocktree) const {
+            std::vector<const CBlockIndex *> blockinfo {};
+            for (const auto &entry : entries) {
+                blockinfo.push_back(entry.get());
+            }
+            BOOST_REQUIRE(blocktree.WriteBatchSync({}, 0, blockinfo));
+        }
+
+        std::vector<uint256> hashes {};
+        std::vector<std::unique_ptr<CBlockIndex>> entries {};
+
+    private:
+        CBlockHeader MakeHeader(size_t height) const {
+            CBlockHeader header {};
+            header.nVersion = 1;
+            header.hashPrevBlock = hashes.empty() ? uint256() : hashes.back();
+            header.hashMerkleRoot = InsecureRand256();
+            header.nTime = height;
+            header.nBits = TEST_BITS;
+            return header;
+        }
+
+        void Add(const CBlockHeader &header) {
+            // Hashes are reserved up front so these pointers stay valid
+            hashes.push_back(header.GetHash());
+            entries.push_back(std::make_unique<CBlockIndex>(header));
+            CBlockIndex &entry = *entries.back();
+            entry.phashBlock = &hashes.back();
+            entry.nHeight = entries.size() - 1;
+            entry.pprev = entries.size() > 1 ? entries[entries.size() - 2].get()
+                                             : nullptr;
+        }
+    };
+
+    // Somewhere to load block index entries into
+    struct LoadedIndex {
+        std::unordered_map<uint256, std::unique_ptr<CBlockIndex>, BlockHasher>
+            entries {};
+
+        CBlockIndex *Insert(const uint256 &hash) {
+            if (hash.IsNull()) {
+                return nullptr;
+            }
+            auto it = entries.find(hash);
+            if (it == entries.end()) {
+                it = entries.emplace(hash, std::make_unique<CBlockIndex>())
+                         .first;
+                it->second->phashBlock = &it->first;
+            }
+            return it->second.get();
+        }
+
+        bool Load(CBlockTreeDB &blocktree) {
+            return blocktree.LoadBlockIndexGuts(
+                [this](const uint256 &hash) { return Insert(hash); });
+        }
+
+        bool LoadSnapshot(CBlockTreeDB &blocktree, const fs::path &path) {
+            return blocktree.LoadBlockIndexSnapshot(
+                path, [this](const uint256 &hash) { return Insert(hash); });
+        }
+    };
+
+    std::vector<const CBlockIndex *> GetEntries(const LoadedIndex &index) {
+        std::vector<const CBlockIndex *> entries {};
+        for (const auto &entry : index.entries) {
+            entries.push_back(entry.second.get());
+        }
+        return entries;
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(blockindex_load_tests, RegtestingSetup)
+
+BOOST_AUTO_TEST_CASE(load_several_batches) {
+    // Enough entries for several batches, the last of them partial
+    TestChain chain { nBlockIndexLoadBatchSize * 5 / 2 };
+    CBlockTreeDB blocktree { 1 << 20, true };
+    chain.Write(blocktree);
+
+    LoadedIndex loaded {};
+    BOOST_REQUIRE(loaded.Load(blocktree));
+    BOOST_CHECK_EQUAL(loaded.entries.size(), chain.entries.size());
+
+    for (const auto &entry : chain.entries) {
+        const auto it = loaded.entries.find(entry->GetBlockHash());
+        BOOST_REQUIRE(it != loaded.entries.end());
+        const CBlockIndex &pindex = *it->second;
+        BOOST_CHECK_EQUAL(pindex.nHeight, entry->nHeight);
+        BOOST_CHECK_EQUAL(pindex.nNonce, entry->nNonce);
+        BOOST_CHECK(pindex.hashMerkleRoot == entry->hashMerkleRoot);
+        if (entry->pprev) {
+            BOOST_REQUIRE(pindex.pprev);
+            BOOST_CHECK(pindex.pprev->GetBlockHash() ==
+                        entry->pprev->GetBlockHash());
+            BOOST_CHECK(pindex.pprev ==
+                        loaded.entries.at(entry->pprev->GetBlockHash()).get());
+        } else {
+            BOOST_CHECK(!pindex.pprev);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(load_invalid_pow) {
+    TestChain chain { nBlockIndexLoadBatchSize * 5 / 2 };
+    const uint256 invalid { chain.AddInvalid() };
+    CBlockTreeDB blocktree { 1 << 20, true };
+    chain.Write(blocktree);
+
+    // The invalid entry is well into the last batch; loading stops there,
+    // before any of the entries sorting after it are loaded.
+    LoadedIndex loaded {};
+    BOOST_CHECK(!loaded.Load(blocktree));
+    BOOST_REQUIRE(loaded.entries.count(invalid));
+    BOOST_CHECK(loaded.entries.at(invalid)->nBits == TEST_BITS);
+    size_t numLoaded { 0 };
+    for (const auto &entry : loaded.entries) {
+        // Entries only referred to as a previous block are left empty
+        if (entry.second->nBits == TEST_BITS) {
+            ++numLoaded;
+            BOOST_CHECK(!(invalid < entry.first));
+        }
+    }
+    BOOST_CHECK_GT(numLoaded, nBlockIndexLoadBatchSize * 2);
+    BOOST_CHECK_LT(numLoaded, chain.entries.size());
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_round_trip) {
+    TestChain chain { 1000 };
+    CBlockTreeDB blocktree { 1 << 20, true };
+    chain.Write(blocktree);
+    LoadedIndex fromDB {};
+    BOOST_REQUIRE(fromDB.Load(blocktree));
+
+    // No snapshot has been written yet
+    const fs::path path { GetDataDir() / "index.snapshot" };
+    LoadedIndex fromSnapshot {};
+    BOOST_CHECK(!fromSnapshot.LoadSnapshot(blocktree, path));
+
+    BOOST_REQUIRE(blocktree.WriteBlockIndexSnapshot(path, GetEntries(fromDB)));
+    BOOST_REQUIRE(fromSnapshot.LoadSnapshot(blocktree, path));
+    BOOST_CHECK_EQUAL(fromSnapshot.entries.size(), fromDB.entries.size());
+    for (const auto &entry : fromDB.entries) {
+        const auto it = fromSnapshot.entries.find(entry.first);
+        BOOST_REQUIRE(it != fromSnapshot.entries.end());
+        const CBlockIndex &expected = *entry.second;
+        const CBlockIndex &pindex = *it->second;
+        BOOST_CHECK_EQUAL(pindex.nHeight, expected.nHeight);
+        BOOST_CHECK_EQUAL(pindex.nTime, expected.nTime);
+        BOOST_CHECK_EQUAL(pindex.nNonce, expected.nNonce);
+        BOOST_CHECK(pindex.hashMerkleRoot == expected.hashMerkleRoot);
+        if (expected.pprev) {
+            BOOST_REQUIRE(pindex.pprev);
+            BOOST_CHECK(pindex.pprev->GetBlockHash() ==
+                        expected.pprev->GetBlockHash());
+        } else {
+            BOOST_CHECK(!pindex.pprev);
+        }
+    }
+
+    // The snapshot can be loaded again
+    LoadedIndex again {};
+    BOOST_CHECK(again.LoadSnapshot(blocktree, path));
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_stale_or_corrupt) {
+    TestChain chain { 100 };
+    CBlockTreeDB blocktree { 1 << 20, true };
+    chain.Write(blocktree);
+    LoadedIndex fromDB {};
+    BOOST_REQUIRE(fromDB.Load(blocktree));
+    const fs::path path { GetDataDir() / "index.snapshot" };
+
+    // Writing block index entries to the database makes the snapshot stale
+    BOOST_REQUIRE(blocktree.WriteBlockIndexSnapshot(path, GetEntries(fromDB)));
+    BOOST_REQUIRE(
+        blocktree.WriteBatchSync({}, 0, {chain.entries.back().get()}));
+    LoadedIndex loaded {};
+    BOOST_CHECK(!loaded.LoadSnapshot(blocktree, path));
+    BOOST_CHECK(loaded.entries.empty());
+
+    // A corrupted snapshot is rejected
+    BOOST_REQUIRE(blocktree.WriteBlockIndexSnapshot(path, GetEntries(fromDB)));
+    {
+        FILE *file = fsbridge::fopen(path, "r+b");
+        BOOST_REQUIRE(file);
+        BOOST_REQUIRE_EQUAL(fseek(file, 100, SEEK_SET), 0);
+        const int byte = fgetc(file);
+        BOOST_REQUIRE_EQUAL(fseek(file, 100, SEEK_SET), 0);
+        fputc(byte ^ 0x01, file);
+        fclose(file);
+    }
+    BOOST_CHECK(!loaded.LoadSnapshot(blocktree, path));
+    BOOST_CHECK(loaded.entries.empty());
+
+    // As is a missing one
+    fs::remove(path);
+    BOOST_CHECK(!loaded.LoadSnapshot(blocktree, path));
+}
+
+BOOST_AUTO_TEST_CASE(unload_mixed_entries) {
+    // The genesis block was added by AddToBlockIndex() during setup; add some
+    // entries allocated as they would be when loading from disk.
+    BOOST_CHECK(!mapBlockIndex.empty());
+    std::vector<uint256> hashes {};
+    {
+        LOCK(cs_main);
+        for (size_t i = 0; i < 20000; ++i) {
+            hashes.push_back(InsecureRand256());
+            BOOST_CHECK(InsertBlockIndex(hashes.back()));
+        }
+        BOOST_CHECK(InsertBlockIndex(hashes[0]) ==
+                    mapBlockIndex.at(hashes[0]));
+    }
+
+    UnloadBlockIndex();
+    BOOST_CHECK(mapBlockIndex.empty());
+
+    // Entries can be allocated again after unloading
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(InsertBlockIndex(hashes[0]));
+        BOOST_CHECK_EQUAL(mapBlockIndex.size(), 1);
+    }
+    UnloadBlockIndex();
+    BOOST_CHECK(mapBlockIndex.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,13 +5,17 @@
 #include "bloom.h"
 
 #include "base58.h"
+#include "blockstreams.h"
 #include "clientversion.h"
+#include "consensus/merkle.h"
 #include "key.h"
 #include "merkleblock.h"
 #include "random.h"
+#include "script/standard.h"
 #include "serialize.h"
 #include "streams.h"
 #include "test/test_bitcoin.h"
+#include "stream_test_helpers.h"
 #include "uint256.h"
 #include "util.h"
 #include "utilstrencodings.h"
@@ -1069,6 +1073,112 @@ static std::vector<uint8_t> RandomData() {
     return std::vector<uint8_t>(r.begin(), r.end());
 }
 
+BOOST_AUTO_TEST_CASE(bloom_elements_match_like_transactions) {
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+
+    // Pays to the key in various ways, then spends some of those payments
+    CMutableTransaction pay;
+    pay.vin.resize(1);
+    pay.vin[0].scriptSig = CScript() << OP_0 << std::vector<uint8_t>(5, 1);
+    pay.vout.resize(4);
+    pay.vout[0].scriptPubKey = CScript() << ToByteVector(pubkey)
+                                         << OP_CHECKSIG;
+    pay.vout[1].scriptPubKey = GetScriptForDestination(pubkey.GetID());
+    pay.vout[2].scriptPubKey = GetScriptForMultisig(1, {pubkey});
+    pay.vout[3].scriptPubKey = CScript() << OP_FALSE << OP_RETURN;
+    const CTransaction payTx {pay};
+
+    CMutableTransaction spend;
+    spend.vin.resize(3);
+    for (unsigned int i = 0; i < spend.vin.size(); i++) {
+        spend.vin[i].prevout = COutPoint(payTx.GetId(), i);
+    }
+    spend.vout.resize(1);
+    spend.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    const CTransaction spendTx {spend};
+
+    CBloomElements elements;
+    elements.AddTransaction(payTx);
+    elements.AddTransaction(spendTx);
+    BOOST_CHECK_EQUAL(elements.GetTransactionCount(), 2U);
+    BOOST_CHECK(elements.GetTxId(1) == spendTx.GetId());
+
+    for (uint8_t flags :
+         {BLOOM_UPDATE_NONE, BLOOM_UPDATE_ALL, BLOOM_UPDATE_P2PUBKEY_ONLY}) {
+        for (const std::vector<uint8_t> &element :
+             {ToByteVector(pubkey), ToByteVector(pubkey.GetID()),
+              std::vector<uint8_t>(5, 1), std::vector<uint8_t>(5, 2)}) {
+            CBloomFilter txFilter(10, 0.000001, 0, flags);
+            txFilter.insert(element);
+            CBloomFilter elementsFilter = txFilter;
+
+            BOOST_CHECK_EQUAL(txFilter.IsRelevantAndUpdate(payTx),
+                              elementsFilter.IsRelevantAndUpdate(elements, 0));
+            BOOST_CHECK_EQUAL(txFilter.IsRelevantAndUpdate(spendTx),
+                              elementsFilter.IsRelevantAndUpdate(elements, 1));
+
+            CDataStream txStream(SER_NETWORK, PROTOCOL_VERSION);
+            txStream << txFilter;
+            CDataStream elementsStream(SER_NETWORK, PROTOCOL_VERSION);
+            elementsStream << elementsFilter;
+            BOOST_CHECK_EQUAL(HexStr(txStream), HexStr(elementsStream));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(merkle_block_streamed) {
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+
+    // A block paying to the key and spending that payment
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    coinbase.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    CMutableTransaction pay;
+    pay.vin.resize(1);
+    pay.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+    pay.vout.resize(1);
+    pay.vout[0].scriptPubKey = CScript() << ToByteVector(pubkey)
+                                         << OP_CHECKSIG;
+    const CTransaction payTx {pay};
+    CMutableTransaction spend;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(payTx.GetId(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].scriptPubKey = CScript() << OP_TRUE;
+
+    CBlock block;
+    block.vtx = {MakeTransactionRef(coinbase), MakeTransactionRef(payTx),
+                 MakeTransactionRef(spend)};
+    bool mutated;
+    block.hashMerkleRoot = BlockMerkleRoot(block, &mutated);
+    const std::vector<uint8_t> data {Serialize(block)};
+
+    // Matching the block as it is streamed gives the same merkle block and
+    // filter updates as matching it whole
+    for (uint8_t flags : {BLOOM_UPDATE_NONE, BLOOM_UPDATE_ALL}) {
+        CBloomFilter wholeFilter(10, 0.000001, 0, flags);
+        wholeFilter.insert(ToByteVector(pubkey));
+        CBloomFilter streamFilter = wholeFilter;
+
+        CMerkleBlock whole(block, wholeFilter);
+        CBlockStreamReader<CMemoryReader> stream {
+            data, {SER_NETWORK, INIT_PROTO_VERSION}};
+        CMerkleBlock streamed(stream, streamFilter);
+
+        BOOST_CHECK_EQUAL(streamed.vMatchedTxn.size(),
+                          flags == BLOOM_UPDATE_ALL ? 2U : 1U);
+        BOOST_CHECK(whole.vMatchedTxn == streamed.vMatchedTxn);
+        BOOST_CHECK_EQUAL(HexStr(Serialize(whole)), HexStr(Serialize(streamed)));
+        BOOST_CHECK_EQUAL(HexStr(Serialize(wholeFilter)),
+                          HexStr(Serialize(streamFilter)));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(rolling_bloom) {
     // last-100-entry, 1% false positive:
     CRollingBloomFilter rb1(100, 0.01);
@@ -1140,6 +1250,17 @@ BOOST_AUTO_TEST_CASE(rolling_bloom) {
         BOOST_CHECK(rb2.contains(data[i]));
     }
 
+    // A batch inserts like one key at a time
+    CRollingBloomFilter rb3(100, 0.01);
+    std::vector<uint256> batch;
+    for (int i = 0; i < 25; i++) {
+        batch.push_back(InsecureRand256());
+    }
+    rb3.insert(batch);
+    for (const uint256 &hash : batch) {
+        BOOST_CHECK(rb3.contains(hash));
+    }
+
     BOOST_CHECK_EXCEPTION(CRollingBloomFilter filter(3, 0.0), std::runtime_error,inValidConstructorParameterException);
     BOOST_CHECK_EXCEPTION(CRollingBloomFilter filter(3, 1.181), std::runtime_error,inValidConstructorParameterException);
 }
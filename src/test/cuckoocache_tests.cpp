@@ -128,6 +128,18 @@ BOOST_AUTO_TEST_CASE(cuckoocache_hit_rate_ok) {
     }
 }
 
+/** Sharding must not cost hit rate: the same bound holds */
+BOOST_AUTO_TEST_CASE(cuckoocache_sharded_hit_rate_ok) {
+    double HitRateThresh = 0.98;
+    size_t megabytes = 32;
+    for (double load = 0.1; load < 2; load *= 2) {
+        double hits = test_cache<
+            CuckooCache::sharded_cache<uint256, SignatureCacheHasher>>(
+            megabytes, load);
+        BOOST_CHECK(normalize_hit_rate(hits, load) > HitRateThresh);
+    }
+}
+
 /** This helper checks that erased elements are preferentially inserted onto and
  * that the hit rate of "fresher" keys is reasonable*/
 template <typename Cache> void test_cache_erase(size_t megabytes) {
@@ -276,6 +288,14 @@ BOOST_AUTO_TEST_CASE(cuckoocache_erase_parallel_ok) {
         CuckooCache::cache<uint256, SignatureCacheHasher>>(megabytes);
 }
 
+BOOST_AUTO_TEST_CASE(cuckoocache_sharded_erase_ok) {
+    size_t megabytes = 32;
+    test_cache_erase<
+        CuckooCache::sharded_cache<uint256, SignatureCacheHasher>>(megabytes);
+    test_cache_erase_parallel<
+        CuckooCache::sharded_cache<uint256, SignatureCacheHasher>>(megabytes);
+}
+
 template <typename Cache> void test_cache_generations() {
     // This test checks that for a simulation of network activity, the fresh hit
     // rate is never below 99%, and the number of times that it is worse than
@@ -43,6 +43,45 @@ BOOST_AUTO_TEST_CASE(dbwrapper) {
     }
 }
 
+// Test the tuning profiles, with a filter-less and a compressed one too
+BOOST_AUTO_TEST_CASE(dbwrapper_tuning) {
+    CDBTuning noFilter;
+    noFilter.nBloomBitsPerKey = 0;
+    CDBTuning compressed;
+    compressed.fCompress = true;
+    for (const CDBTuning &tuning : {CDBTuning::Chainstate(),
+                                    CDBTuning::BlockIndex(), noFilter,
+                                    compressed}) {
+        fs::path ph = fs::temp_directory_path() / fs::unique_path();
+        CDBWrapper dbw(ph, (1 << 20), true, false, true, tuning);
+
+        CDBBatch batch(dbw);
+        for (uint32_t n = 0; n < 1000; n++) {
+            batch.Write(std::make_pair('k', n), std::vector<uint8_t>(100, n));
+        }
+        dbw.WriteBatch(batch);
+        dbw.CompactRange(std::make_pair('k', uint32_t(0)),
+                         std::make_pair('k', uint32_t(1000)));
+
+        std::vector<uint8_t> res;
+        BOOST_CHECK(dbw.Read(std::make_pair('k', uint32_t(999)), res));
+        BOOST_CHECK(res == std::vector<uint8_t>(100, uint8_t(999)));
+        BOOST_CHECK(!dbw.Exists(std::make_pair('k', uint32_t(1000))));
+    }
+}
+
+// Block index compression is only turned on when LevelDB can do it
+BOOST_AUTO_TEST_CASE(dbwrapper_blockindex_compression) {
+    BOOST_CHECK(!CDBTuning::BlockIndex().fCompress);
+    gArgs.ForceSetArg("-blockindexcompression", "1");
+#ifdef SNAPPY
+    BOOST_CHECK(CDBTuning::BlockIndex().fCompress);
+#else
+    BOOST_CHECK(!CDBTuning::BlockIndex().fCompress);
+#endif
+    gArgs.ClearArg("-blockindexcompression");
+}
+
 // Test batch operations
 BOOST_AUTO_TEST_CASE(dbwrapper_batch) {
     // Perform tests both obfuscated and non-obfuscated.
@@ -0,0 +1,144 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "blockfileinfostore.h"
+#include "config.h"
+#include "primitives/transaction.h"
+#include "script/standard.h"
+#include "test/test_bitcoin.h"
+#include "txmempool.h"
+#include "validation.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+namespace
+{
+    // Create an empty block file so that the cache can open it
+    void CreateBlockFile(int nFile)
+    {
+        FILE* file { CDiskFiles::OpenBlockFile(CDiskBlockPos(nFile, 0)) };
+        BOOST_REQUIRE(file);
+        fclose(file);
+    }
+
+    // Enable the txindex for blocks connected during a test
+    struct TxIndexSetup : TestChain100Setup
+    {
+        TxIndexSetup() { fTxIndex = true; }
+        ~TxIndexSetup()
+        {
+            fTxIndex = false;
+            mempool.Clear();
+        }
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(gettransactions_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(read_cache_hits)
+{
+    CreateBlockFile(1);
+    CBlockFileReadCache cache { 2 };
+
+    FILE* file { cache.Take(1) };
+    BOOST_REQUIRE(file);
+    BOOST_CHECK(cache.GetCachedFiles().empty());
+
+    // A returned handle is handed out again, and only to one reader
+    cache.Return(1, file);
+    BOOST_CHECK((cache.GetCachedFiles() == std::vector<int>{1}));
+    BOOST_CHECK_EQUAL(cache.Take(1), file);
+    BOOST_CHECK(cache.GetCachedFiles().empty());
+    FILE* other { cache.Take(1) };
+    BOOST_REQUIRE(other);
+    BOOST_CHECK(other != file);
+
+    cache.Return(1, file);
+    cache.Return(1, other);
+    BOOST_CHECK((cache.GetCachedFiles() == std::vector<int>{1, 1}));
+}
+
+BOOST_AUTO_TEST_CASE(read_cache_eviction)
+{
+    for(int nFile : {1, 2, 3})
+    {
+        CreateBlockFile(nFile);
+    }
+    CBlockFileReadCache cache { 2 };
+
+    FILE* file1 { cache.Take(1) };
+    FILE* file2 { cache.Take(2) };
+    FILE* file3 { cache.Take(3) };
+    cache.Return(1, file1);
+    cache.Return(2, file2);
+    BOOST_CHECK((cache.GetCachedFiles() == std::vector<int>{2, 1}));
+
+    // The least recently returned handle is closed when the cache is full
+    cache.Return(3, file3);
+    BOOST_CHECK((cache.GetCachedFiles() == std::vector<int>{3, 2}));
+    BOOST_CHECK_EQUAL(cache.Take(2), file2);
+    BOOST_CHECK((cache.GetCachedFiles() == std::vector<int>{3}));
+
+    // A handle taken again moves to the front when it is returned
+    cache.Return(2, file2);
+    BOOST_CHECK_EQUAL(cache.Take(3), file3);
+    cache.Return(3, file3);
+    BOOST_CHECK((cache.GetCachedFiles() == std::vector<int>{3, 2}));
+}
+
+BOOST_FIXTURE_TEST_CASE(mixed_batch, TxIndexSetup)
+{
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey())
+                                     << OP_CHECKSIG;
+    CBlock block1 { CreateAndProcessBlock({}, scriptPubKey) };
+    CBlock block2 { CreateAndProcessBlock({}, scriptPubKey) };
+
+    CMutableTransaction spend {};
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(coinbaseTxns[0].GetId(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = coinbaseTxns[0].vout[0].nValue;
+    spend.vout[0].scriptPubKey = scriptPubKey;
+    CTransaction mempoolTx { spend };
+    TestMemPoolEntryHelper entry {};
+    mining::CJournalChangeSetPtr nullChangeSet {nullptr};
+    mempool.AddUnchecked(mempoolTx.GetId(), entry.FromTx(mempoolTx), nullChangeSet);
+
+    // Found in later and earlier blocks, in the mempool, and not at all
+    const TxId missing { InsecureRand256() };
+    std::vector<TxId> txids {
+        block2.vtx[0]->GetId(), mempoolTx.GetId(), missing, block1.vtx[0]->GetId()
+    };
+    std::vector<CTransactionRef> txs {};
+    std::vector<uint256> hashBlocks {};
+    GetTransactions(txids, txs, hashBlocks);
+
+    BOOST_REQUIRE_EQUAL(txs.size(), txids.size());
+    BOOST_REQUIRE_EQUAL(hashBlocks.size(), txids.size());
+    BOOST_REQUIRE(txs[0]);
+    BOOST_CHECK(txs[0]->GetId() == block2.vtx[0]->GetId());
+    BOOST_CHECK(hashBlocks[0] == block2.GetHash());
+    BOOST_REQUIRE(txs[1]);
+    BOOST_CHECK(txs[1]->GetId() == mempoolTx.GetId());
+    BOOST_CHECK(hashBlocks[1].IsNull());
+    BOOST_CHECK(!txs[2]);
+    BOOST_CHECK(hashBlocks[2].IsNull());
+    BOOST_REQUIRE(txs[3]);
+    BOOST_CHECK(txs[3]->GetId() == block1.vtx[0]->GetId());
+    BOOST_CHECK(hashBlocks[3] == block1.GetHash());
+
+    // The single lookup agrees
+    for(size_t i = 0; i < txids.size(); ++i)
+    {
+        CTransactionRef tx {};
+        uint256 hashBlock {};
+        BOOST_CHECK_EQUAL(
+            GetTransaction(GlobalConfig::GetConfig(), txids[i], tx, hashBlock),
+            txs[i] != nullptr);
+        BOOST_CHECK(hashBlock == hashBlocks[i]);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
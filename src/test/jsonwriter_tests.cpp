@@ -0,0 +1,121 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "rpc/jsonwriter.h"
+
+#include "core_io.h"
+#include "key.h"
+#include "primitives/transaction.h"
+#include "rpc/tojson.h"
+#include "script/standard.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <univalue.h>
+
+namespace {
+
+std::string WriteTx(const CTransaction &tx, const uint256 &hashBlock) {
+    std::string json;
+    CJSONWriter writer {json};
+    writer.writeBeginObject();
+    TxToJSON(tx, hashBlock, writer);
+    writer.writeEndObject();
+    return json;
+}
+
+std::string WriteTxUniValue(const CTransaction &tx, const uint256 &hashBlock) {
+    UniValue entry(UniValue::VOBJ);
+    TxToUniv(tx, hashBlock, entry);
+    return entry.write();
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(jsonwriter_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(nesting_and_values) {
+    std::string json;
+    CJSONWriter writer {json};
+    writer.writeBeginObject();
+    writer.pushKV("str", "a\"b\\c\n\x01\x7f");
+    writer.pushKV("int", -5);
+    writer.pushKV("uint64", std::numeric_limits<uint64_t>::max());
+    writer.pushKV("bool", true);
+    writer.pushKV("double", 0.1);
+    writer.pushKVNull("null");
+    const uint8_t bytes[] {0x00, 0x0f, 0xab, 0xff};
+    writer.pushKVHex("hex", bytes, sizeof(bytes));
+    writer.writeBeginArray("array");
+    writer.pushV("x");
+    writer.writeBeginObject();
+    writer.writeEndObject();
+    writer.pushVJSONFormatted("1.5");
+    writer.writeEndArray();
+    writer.writeBeginObject("empty");
+    writer.writeEndObject();
+    writer.writeEndObject();
+
+    UniValue expected(UniValue::VOBJ);
+    expected.pushKV("str", "a\"b\\c\n\x01\x7f");
+    expected.pushKV("int", -5);
+    expected.pushKV("uint64", std::numeric_limits<uint64_t>::max());
+    expected.pushKV("bool", UniValue(true));
+    expected.pushKV("double", 0.1);
+    expected.pushKV("null", NullUniValue);
+    expected.pushKV("hex", "000fabff");
+    UniValue array(UniValue::VARR);
+    array.push_back("x");
+    array.push_back(UniValue(UniValue::VOBJ));
+    array.push_back(UniValue(UniValue::VNUM, "1.5"));
+    expected.pushKV("array", array);
+    expected.pushKV("empty", UniValue(UniValue::VOBJ));
+
+    BOOST_CHECK_EQUAL(json, expected.write());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_matches_univalue) {
+    CKey key;
+    key.MakeNewKey(true);
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig = CScript() << OP_0 << OP_1;
+    coinbase.vout.resize(1);
+    coinbase.vout[0].nValue = Amount(5000000000);
+    coinbase.vout[0].scriptPubKey =
+        GetScriptForDestination(key.GetPubKey().GetID());
+    const CTransaction coinbaseTx {coinbase};
+    BOOST_CHECK_EQUAL(WriteTx(coinbaseTx, uint256()),
+                      WriteTxUniValue(coinbaseTx, uint256()));
+
+    CMutableTransaction spend;
+    spend.nVersion = 2;
+    spend.nLockTime = 1234;
+    spend.vin.resize(2);
+    spend.vin[0].prevout = COutPoint(coinbaseTx.GetId(), 0);
+    spend.vin[0].scriptSig = CScript() << std::vector<uint8_t>(72, 0x30)
+                                       << ToByteVector(key.GetPubKey());
+    spend.vin[1].prevout = COutPoint(coinbaseTx.GetId(), 1);
+    spend.vin[1].nSequence = 0;
+    spend.vout.resize(3);
+    spend.vout[0].nValue = Amount(123);
+    spend.vout[0].scriptPubKey = GetScriptForRawPubKey(key.GetPubKey());
+    spend.vout[1].nValue = Amount(0);
+    spend.vout[1].scriptPubKey = CScript() << OP_FALSE << OP_RETURN
+                                           << std::vector<uint8_t>(100, 'a');
+    spend.vout[2].nValue = Amount(1);
+    spend.vout[2].scriptPubKey =
+        GetScriptForMultisig(1, {key.GetPubKey(), key.GetPubKey()});
+    const CTransaction spendTx {spend};
+    BOOST_CHECK_EQUAL(WriteTx(spendTx, uint256()),
+                      WriteTxUniValue(spendTx, uint256()));
+
+    const uint256 hashBlock {InsecureRand256()};
+    BOOST_CHECK_EQUAL(WriteTx(spendTx, hashBlock),
+                      WriteTxUniValue(spendTx, hashBlock));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -7,6 +7,7 @@
 #include "base58.h"
 #include "dstencode.h"
 #include "script/script.h"
+#include "script/sigcache.h"
 #include "test/test_bitcoin.h"
 #include "uint256.h"
 #include "util.h"
@@ -208,4 +209,34 @@ BOOST_AUTO_TEST_CASE(key_test1) {
                          "8ab9a69566962e8771b5944d"));
 }
 
+BOOST_AUTO_TEST_CASE(pubkey_cache) {
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    CKey other;
+    other.MakeNewKey(false);
+
+    for (int i = 0; i < 3; ++i) {
+        // The first round parses the key, later ones find it in the cache
+        const uint256 hash = InsecureRand256();
+        std::vector<uint8_t> vchSig;
+        BOOST_CHECK(key.Sign(hash, vchSig));
+        BOOST_CHECK(VerifyWithPubKeyCache(pubkey, hash, vchSig));
+        BOOST_CHECK(!VerifyWithPubKeyCache(pubkey, InsecureRand256(), vchSig));
+        BOOST_CHECK(!VerifyWithPubKeyCache(other.GetPubKey(), hash, vchSig));
+        BOOST_CHECK(!VerifyWithPubKeyCache(pubkey, hash, {}));
+    }
+
+    // Keys that do not parse are rejected and never cached
+    std::vector<uint8_t> vchInvalid(33, 0xff);
+    vchInvalid[0] = 0x02;
+    const CPubKey invalid(vchInvalid.begin(), vchInvalid.end());
+    BOOST_CHECK(invalid.IsValid() && !invalid.IsFullyValid());
+    const uint256 hash = InsecureRand256();
+    std::vector<uint8_t> vchSig;
+    BOOST_CHECK(key.Sign(hash, vchSig));
+    BOOST_CHECK(!VerifyWithPubKeyCache(invalid, hash, vchSig));
+    BOOST_CHECK(!VerifyWithPubKeyCache(invalid, hash, vchSig));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,164 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "logging.h"
+#include "util.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+fs::path DebugLogPath() {
+    return GetDataDir() / "bitcoind.log";
+}
+
+std::vector<std::string> ReadLines(const fs::path &path) {
+    std::vector<std::string> lines;
+    std::ifstream file(path.string());
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(logging_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(async_keeps_order) {
+    fs::remove(DebugLogPath());
+    BCLog::Logger logger;
+    logger.fLogTimestamps = false;
+    logger.LogPrintStr("before open\n");
+    logger.OpenDebugLog();
+    logger.StartAsyncLogging(1 << 24);
+
+    constexpr int THREADS = 4;
+    constexpr int MESSAGES = 1000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&logger, t] {
+            for (int n = 0; n < MESSAGES; ++n) {
+                logger.LogPrintStr(strprintf("%d %d\n", t, n));
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    logger.StopAsyncLogging();
+    BOOST_CHECK_EQUAL(logger.GetDroppedMessages(), 0);
+
+    // Synchronous again after stopping
+    logger.LogPrintStr("after stop\n");
+
+    const std::vector<std::string> lines {ReadLines(DebugLogPath())};
+    BOOST_REQUIRE_EQUAL(lines.size(), THREADS * MESSAGES + 2);
+    BOOST_CHECK_EQUAL(lines.front(), "before open");
+    BOOST_CHECK_EQUAL(lines.back(), "after stop");
+    std::map<int, int> next;
+    for (size_t i = 1; i + 1 < lines.size(); ++i) {
+        int t, n;
+        BOOST_REQUIRE(sscanf(lines[i].c_str(), "%d %d", &t, &n) == 2);
+        BOOST_CHECK_EQUAL(n, next[t]++);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(async_keeps_global_order) {
+    fs::remove(DebugLogPath());
+    BCLog::Logger logger;
+    logger.fLogTimestamps = false;
+    logger.OpenDebugLog();
+    logger.StartAsyncLogging(1 << 24);
+
+    // Messages are numbered in the order they are logged across all threads
+    constexpr int THREADS = 4;
+    constexpr int MESSAGES = 20000;
+    std::mutex mtx;
+    int counter = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&] {
+            for (int n = 0; n < MESSAGES / THREADS; ++n) {
+                std::lock_guard<std::mutex> lock(mtx);
+                logger.LogPrintStr(strprintf("%d\n", counter++));
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    logger.StopAsyncLogging();
+
+    const std::vector<std::string> lines {ReadLines(DebugLogPath())};
+    BOOST_REQUIRE_EQUAL(lines.size(), MESSAGES);
+    for (int i = 0; i < MESSAGES; ++i) {
+        BOOST_CHECK_EQUAL(lines[i], std::to_string(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(async_stop_loses_nothing) {
+    fs::remove(DebugLogPath());
+    BCLog::Logger logger;
+    logger.fLogTimestamps = false;
+    logger.OpenDebugLog();
+    logger.StartAsyncLogging(1 << 24);
+
+    // Keep logging while asynchronous logging is stopped
+    std::atomic<bool> fStop {false};
+    int logged = 0;
+    std::thread thread([&] {
+        while (!fStop) {
+            logger.LogPrintStr(strprintf("%d\n", logged++));
+            if (logged % 1000 == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    logger.StopAsyncLogging();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    fStop = true;
+    thread.join();
+    BOOST_CHECK_EQUAL(logger.GetDroppedMessages(), 0);
+
+    const std::vector<std::string> lines {ReadLines(DebugLogPath())};
+    BOOST_REQUIRE_EQUAL(lines.size(), logged);
+    for (int i = 0; i < logged; ++i) {
+        BOOST_CHECK_EQUAL(lines[i], std::to_string(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(async_drops_when_full) {
+    fs::remove(DebugLogPath());
+    BCLog::Logger logger;
+    logger.fLogTimestamps = false;
+    logger.OpenDebugLog();
+    // Room for a single message only
+    logger.StartAsyncLogging(10);
+
+    logger.LogPrintStr("kept\n");
+    for (int n = 0; n < 100; ++n) {
+        logger.LogPrintStr("dropped\n");
+    }
+    logger.StopAsyncLogging();
+    BOOST_CHECK_EQUAL(logger.GetDroppedMessages(), 100);
+
+    const std::vector<std::string> lines {ReadLines(DebugLogPath())};
+    BOOST_REQUIRE_EQUAL(lines.size(), 2);
+    BOOST_CHECK_EQUAL(lines[0], "kept");
+    BOOST_CHECK(lines[1].find("100 log messages dropped") == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,6 +21,7 @@
 #include "rpc/server.h"
 #include "script/scriptcache.h"
 #include "script/sigcache.h"
+#include "task_helpers.h"
 #include "txdb.h"
 #include "txmempool.h"
 #include "ui_interface.h"
@@ -52,6 +53,7 @@ BasicTestingSetup::BasicTestingSetup(const std::string &chainName) {
     SetupNetworking();
     InitSignatureCache();
     InitScriptExecutionCache();
+    InitParallelTaskPool(GetNumCores());
 
     // Don't want to write to bitcoind.log file.
     GetLogger().fPrintToDebugLog = false;
@@ -63,6 +65,7 @@ BasicTestingSetup::BasicTestingSetup(const std::string &chainName) {
 }
 
 BasicTestingSetup::~BasicTestingSetup() {
+    ShutdownParallelTaskPool();
     ECC_Stop();
     g_connman.reset();
 }
@@ -99,6 +102,8 @@ TestingSetup::TestingSetup(const std::string &chainName)
     nScriptCheckThreads = 3;
     for (int i = 0; i < nScriptCheckThreads - 1; i++) {
         threadGroup.create_thread([i]() { return ThreadScriptCheck(i); });
+        threadGroup.create_thread(
+            [i]() { return ThreadMempoolScriptCheck(i); });
     }
 
     // Deterministic randomness for tests.
@@ -0,0 +1,264 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "chainparams.h"
+#include "net.h"
+#include "txn_announcement_log.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+
+namespace
+{
+    CService ip(uint32_t i)
+    {
+        struct in_addr s;
+        s.s_addr = i;
+        return CService(CNetAddr(s), Params().GetDefaultPort());
+    }
+
+    // Make a batch of the given number of (forced relay) transactions
+    CTxnAnnouncementLog::Batch MakeBatch(size_t numTxns)
+    {
+        CTxnAnnouncementLog::Batch batch {};
+        for(size_t i = 0; i < numTxns; ++i)
+        {
+            CMutableTransaction tx {};
+            tx.vin.resize(1);
+            tx.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+            tx.vout.resize(1);
+            CTransactionRef txn { MakeTransactionRef(tx) };
+            batch.emplace_back(CInv { MSG_TX, txn->GetId() }, txn);
+        }
+        return batch;
+    }
+
+    // Make a batch of the given number of transactions that are also added
+    // to the mempool
+    CTxnAnnouncementLog::Batch MakeMempoolBatch(size_t numTxns)
+    {
+        static mining::CJournalChangeSetPtr nullChangeSet {nullptr};
+        TestMemPoolEntryHelper entry {};
+
+        CTxnAnnouncementLog::Batch batch {};
+        for(size_t i = 0; i < numTxns; ++i)
+        {
+            CMutableTransaction tx {};
+            tx.vin.resize(1);
+            tx.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+            tx.vout.resize(1);
+            tx.vout[0].nValue = Amount(1000);
+            const TxId txid { tx.GetId() };
+            mempool.AddUnchecked(txid, entry.Fee(Amount(1000)).FromTx(tx), nullChangeSet);
+            batch.emplace_back(CInv { MSG_TX, txid }, mempool.Info(txid));
+        }
+        return batch;
+    }
+
+    CNodePtr MakeNode(NodeId id)
+    {
+        CAddress addr { ip(0xa0b0c001 + id), NODE_NONE };
+        CNodePtr node { std::make_shared<CNode>(id, NODE_NETWORK, 0, INVALID_SOCKET, addr, 0, 0, "", true) };
+        node->fRelayTxes = true;
+        return node;
+    }
+
+    bool Contains(const std::vector<CTxnSendingDetails>& txns, const uint256& hash)
+    {
+        return std::any_of(txns.begin(), txns.end(),
+            [&hash](const CTxnSendingDetails& txn) { return txn.getInv().hash == hash; });
+    }
+
+    // Read everything from the cursor onwards, accepting the lot
+    std::vector<CTxnSendingDetails> ReadAll(const CTxnAnnouncementLog& log, CTxnAnnouncementLog::Cursor& cursor)
+    {
+        std::vector<CTxnSendingDetails> txns {};
+        log.read(cursor, std::numeric_limits<size_t>::max(),
+            [&txns](const CTxnSendingDetails& txn) { txns.push_back(txn); return true; });
+        return txns;
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(test_txn_announcement_log, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(append_and_read)
+{
+    CTxnAnnouncementLog log {};
+    BOOST_CHECK_EQUAL(log.getBatchCount(), 0);
+
+    // A new reader starts at the end of the log
+    CTxnAnnouncementLog::Cursor cursor { CTxnAnnouncementLog::UNSET_CURSOR };
+    log.append(MakeBatch(2));
+    BOOST_CHECK(ReadAll(log, cursor).empty());
+    BOOST_CHECK_EQUAL(cursor, log.getEndCursor());
+
+    // Transactions are seen in order and only once
+    CTxnAnnouncementLog::Batch batch1 { MakeBatch(3) };
+    CTxnAnnouncementLog::Batch batch2 { MakeBatch(1) };
+    log.append(CTxnAnnouncementLog::Batch { batch1 });
+    log.append(CTxnAnnouncementLog::Batch { batch2 });
+    BOOST_CHECK_EQUAL(log.getEndCursor(), cursor + 4);
+    std::vector<CTxnSendingDetails> txns { ReadAll(log, cursor) };
+    BOOST_REQUIRE_EQUAL(txns.size(), 4);
+    BOOST_CHECK(txns[0].getInv().hash == batch1[0].getInv().hash);
+    BOOST_CHECK(txns[2].getInv().hash == batch1[2].getInv().hash);
+    BOOST_CHECK(txns[3].getInv().hash == batch2[0].getInv().hash);
+    BOOST_CHECK(ReadAll(log, cursor).empty());
+
+    // Empty batches aren't logged
+    log.append(CTxnAnnouncementLog::Batch {});
+    BOOST_CHECK_EQUAL(log.getBatchCount(), 3);
+    BOOST_CHECK_EQUAL(log.getTxnCount(), 6);
+}
+
+BOOST_AUTO_TEST_CASE(partial_read)
+{
+    CTxnAnnouncementLog log {};
+    CTxnAnnouncementLog::Cursor cursor { log.getEndCursor() };
+    CTxnAnnouncementLog::Batch batch1 { MakeBatch(3) };
+    CTxnAnnouncementLog::Batch batch2 { MakeBatch(3) };
+    log.append(CTxnAnnouncementLog::Batch { batch1 });
+    log.append(CTxnAnnouncementLog::Batch { batch2 });
+
+    // Rejected transactions don't count towards the limit, and reading stops
+    // part way through a batch once the limit is reached
+    std::vector<CTxnSendingDetails> txns {};
+    size_t numRead { log.read(cursor, 2, [&txns](const CTxnSendingDetails& txn) {
+        txns.push_back(txn);
+        return txns.size() != 2;
+    }) };
+    BOOST_CHECK_EQUAL(numRead, 2);
+    BOOST_REQUIRE_EQUAL(txns.size(), 3);
+    BOOST_CHECK(txns[2].getInv().hash == batch1[2].getInv().hash);
+
+    // The next read carries on from where the last one stopped
+    txns = ReadAll(log, cursor);
+    BOOST_REQUIRE_EQUAL(txns.size(), 3);
+    BOOST_CHECK(txns[0].getInv().hash == batch2[0].getInv().hash);
+    BOOST_CHECK_EQUAL(cursor, log.getEndCursor());
+}
+
+BOOST_AUTO_TEST_CASE(trim)
+{
+    CTxnAnnouncementLog log {};
+    CTxnAnnouncementLog::Cursor slowReader { log.getEndCursor() };
+    CTxnAnnouncementLog::Cursor fastReader { log.getEndCursor() };
+
+    log.append(MakeBatch(1));
+    log.append(MakeBatch(2));
+    BOOST_CHECK_EQUAL(ReadAll(log, fastReader).size(), 3);
+
+    // Trimming to the slowest reader keeps everything it has yet to see
+    log.trim(slowReader);
+    BOOST_CHECK_EQUAL(log.getBatchCount(), 2);
+
+    // A batch a reader is part way through is kept
+    CTxnAnnouncementLog::Cursor partReader { slowReader + 2 };
+    log.trim(partReader);
+    BOOST_CHECK_EQUAL(log.getBatchCount(), 1);
+    BOOST_CHECK_EQUAL(ReadAll(log, partReader).size(), 1);
+
+    // Trimming past a reader loses transactions for it
+    log.append(MakeBatch(4));
+    log.trim(fastReader);
+    BOOST_CHECK_EQUAL(log.getBatchCount(), 1);
+    BOOST_CHECK_EQUAL(log.getTxnCount(), 4);
+    BOOST_CHECK_EQUAL(ReadAll(log, slowReader).size(), 4);
+    BOOST_CHECK_EQUAL(slowReader, log.getEndCursor());
+
+    // Trimming to the end empties the log
+    log.trim(log.getEndCursor());
+    BOOST_CHECK_EQUAL(log.getBatchCount(), 0);
+    BOOST_CHECK_EQUAL(log.getTxnCount(), 0);
+    BOOST_CHECK(ReadAll(log, fastReader).empty());
+    BOOST_CHECK_EQUAL(fastReader, log.getEndCursor());
+}
+
+BOOST_AUTO_TEST_CASE(erase)
+{
+    CTxnAnnouncementLog log {};
+    CTxnAnnouncementLog::Cursor cursor { log.getEndCursor() };
+
+    CTxnAnnouncementLog::Batch batch1 { MakeBatch(3) };
+    CTxnAnnouncementLog::Batch batch2 { MakeBatch(2) };
+    const std::vector<CTxnSendingDetails> erased { batch1[1], batch2[0], MakeBatch(1)[0] };
+    log.append(CTxnAnnouncementLog::Batch { batch1 });
+    log.append(CTxnAnnouncementLog::Batch { batch2 });
+
+    log.erase(erased);
+    BOOST_CHECK_EQUAL(log.getBatchCount(), 2);
+    BOOST_CHECK_EQUAL(log.getTxnCount(), 3);
+    log.erase(erased);
+    BOOST_CHECK_EQUAL(log.getTxnCount(), 3);
+    BOOST_CHECK_EQUAL(log.getUnreadTxnCount(cursor), 3);
+    BOOST_CHECK_EQUAL(log.getUnreadTxnCount(cursor + 2), 2);
+
+    // Erased transactions are skipped but still read past
+    std::vector<CTxnSendingDetails> txns { ReadAll(log, cursor) };
+    BOOST_REQUIRE_EQUAL(txns.size(), 3);
+    BOOST_CHECK(txns[0].getInv().hash == batch1[0].getInv().hash);
+    BOOST_CHECK(txns[1].getInv().hash == batch1[2].getInv().hash);
+    BOOST_CHECK(txns[2].getInv().hash == batch2[1].getInv().hash);
+    BOOST_CHECK_EQUAL(cursor, log.getEndCursor());
+    BOOST_CHECK_EQUAL(log.getUnreadTxnCount(cursor), 0);
+
+    log.trim(cursor);
+    BOOST_CHECK_EQUAL(log.getTxnCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(node_inventory)
+{
+    CTxnAnnouncementLog log {};
+    log.append(MakeMempoolBatch(2));
+
+    // Nodes start reading from the end of the log at the point they connect
+    CNodePtr fastNode { MakeNode(0) };
+    CNodePtr slowNode { MakeNode(1) };
+    fastNode->SetTxnAnnouncementCursor(log.getEndCursor());
+    slowNode->SetTxnAnnouncementCursor(log.getEndCursor());
+
+    // Fetching inventory reads the new txns and advances the cursor
+    CTxnAnnouncementLog::Batch batch1 { MakeMempoolBatch(3) };
+    log.append(CTxnAnnouncementLog::Batch { batch1 });
+    std::vector<CTxnSendingDetails> inv { fastNode->FetchNInventory(log, 2) };
+    BOOST_CHECK_EQUAL(inv.size(), 2);
+    inv = fastNode->FetchNInventory(log, 10);
+    BOOST_CHECK_EQUAL(inv.size(), 1);
+    BOOST_CHECK(inv[0].getInv().hash == batch1[2].getInv().hash);
+    BOOST_CHECK_EQUAL(fastNode->GetTxnAnnouncementCursor(), log.getEndCursor());
+    BOOST_CHECK(fastNode->FetchNInventory(log, 10).empty());
+
+    // Trimming is bounded by the node that has read the least
+    log.trim(std::min(fastNode->GetTxnAnnouncementCursor(), slowNode->GetTxnAnnouncementCursor()));
+    BOOST_CHECK_EQUAL(log.getBatchCount(), 1);
+
+    // Txns erased from the log before a node reads it are never announced
+    CTxnAnnouncementLog::Batch batch2 { MakeMempoolBatch(2) };
+    log.append(CTxnAnnouncementLog::Batch { batch2 });
+    log.erase({ batch2[0] });
+    inv = slowNode->FetchNInventory(log, 10);
+    BOOST_CHECK_EQUAL(slowNode->GetTxnAnnouncementCursor(), log.getEndCursor());
+    BOOST_CHECK_EQUAL(inv.size(), batch1.size() + 1);
+    BOOST_CHECK(!Contains(inv, batch2[0].getInv().hash));
+    BOOST_CHECK(Contains(inv, batch2[1].getInv().hash));
+
+    // Txns a node already knows about aren't announced to it again
+    CTxnAnnouncementLog::Batch batch3 { MakeMempoolBatch(1) };
+    log.append(CTxnAnnouncementLog::Batch { batch3 });
+    log.append(CTxnAnnouncementLog::Batch { batch3 });
+    BOOST_CHECK_EQUAL(slowNode->FetchNInventory(log, 10).size(), 1);
+
+    // A node that doesn't want txns still reads past them
+    {
+        LOCK(fastNode->cs_filter);
+        fastNode->fRelayTxes = false;
+    }
+    BOOST_CHECK(fastNode->FetchNInventory(log, 10).empty());
+    BOOST_CHECK_EQUAL(fastNode->GetTxnAnnouncementCursor(), log.getEndCursor());
+
+    mempool.Clear();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
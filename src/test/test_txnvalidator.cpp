@@ -229,6 +229,45 @@ BOOST_AUTO_TEST_CASE(txnvalidator_doublespend_synch_api) {
     BOOST_CHECK_EQUAL(mempool.Size(), 1);
 }
 
+/**
+ * TxnValidator: Test synch batch interface.
+ */
+BOOST_AUTO_TEST_CASE(txnvalidator_doublespend_synch_batch_api) {
+    // Create txn validator
+    std::shared_ptr<CTxnValidator> txnValidator {
+        std::make_shared<CTxnValidator>(
+                GlobalConfig::GetConfig(),
+                mempool,
+                std::make_shared<CTxnDoubleSpendDetector>())
+    };
+    // Clear mempool before validation
+    mempool.Clear();
+    // Mempool Journal ChangeSet
+    mining::CJournalChangeSetPtr changeSet {nullptr};
+    // Validate all txns as one batch
+    std::vector<TxInputDataSPtr> vTxInputData { TxInputDataVec(TxSource::file, spendsN) };
+    std::vector<CValidationState> states {
+        txnValidator->processValidation(vTxInputData, changeSet)
+    };
+    // There is a state for each txn and only one of the double spends is accepted
+    BOOST_REQUIRE_EQUAL(states.size(), spendsN.size());
+    size_t nAccepted {0};
+    for (size_t i = 0; i < states.size(); ++i) {
+        if (states[i].IsValid()) {
+            ++nAccepted;
+            BOOST_CHECK(mempool.Exists(spendsN[i].GetId()));
+        }
+    }
+    BOOST_CHECK_EQUAL(nAccepted, 1);
+    BOOST_CHECK_EQUAL(mempool.Size(), 1);
+    // Resubmitting the batch rejects all txns
+    vTxInputData = TxInputDataVec(TxSource::file, spendsN);
+    states = txnValidator->processValidation(vTxInputData, changeSet);
+    BOOST_CHECK(std::none_of(states.begin(), states.end(),
+                    [](const CValidationState& state) { return state.IsValid(); }));
+    BOOST_CHECK_EQUAL(mempool.Size(), 1);
+}
+
 /**
  * TxnValidator: Test asynch interface.
  */
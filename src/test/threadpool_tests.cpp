@@ -111,5 +111,25 @@ BOOST_AUTO_TEST_CASE(Prioritised)
     BOOST_CHECK(taskResults == expectedResults);
 }
 
+// Test tasks submitted by a worker get run by other workers
+BOOST_AUTO_TEST_CASE(Stealing)
+{
+    CThreadPool<CQueueAdaptor> pool { "TestPool", 2 };
+
+    // The outer task blocks its worker until the inner one, which is queued
+    // on that same worker, has been stolen and run by the other one.
+    std::thread::id outerThread {};
+    std::thread::id innerThread {};
+    auto outer { make_task(pool, [&pool, &outerThread, &innerThread]() {
+        outerThread = std::this_thread::get_id();
+        make_task(pool, [&innerThread]() {
+            innerThread = std::this_thread::get_id();
+        }).get();
+    }) };
+    outer.get();
+
+    BOOST_CHECK(outerThread != innerThread);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
 
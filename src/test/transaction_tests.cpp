@@ -211,6 +211,46 @@ BOOST_AUTO_TEST_CASE(tx_invalid) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(tx_id_and_size) {
+    // The id and size of a deserialized txn are taken from the bytes it was
+    // read from; they must match those of its serialization.
+    for (const std::string &json :
+         {std::string(json_tests::tx_valid,
+                      json_tests::tx_valid + sizeof(json_tests::tx_valid)),
+          std::string(json_tests::tx_invalid,
+                      json_tests::tx_invalid + sizeof(json_tests::tx_invalid))}) {
+        UniValue tests = read_json(json);
+        for (size_t idx = 0; idx < tests.size(); idx++) {
+            UniValue test = tests[idx];
+            if (!test[0].isArray() || test.size() < 2 || !test[1].isStr()) {
+                continue;
+            }
+            std::string strTest = test.write();
+
+            const std::vector<uint8_t> data {ParseHex(test[1].get_str())};
+            CDataStream stream(data, SER_NETWORK, PROTOCOL_VERSION);
+            CTransaction tx(deserialize, stream);
+            if (!stream.empty()) {
+                // Trailing bytes (e.g. segwit encoding) aren't part of the txn
+                continue;
+            }
+
+            BOOST_CHECK_MESSAGE(tx.GetId() == TxId(SerializeHash(tx)), strTest);
+            BOOST_CHECK_MESSAGE(tx.GetTotalSize() ==
+                                    GetSerializeSize(tx, SER_NETWORK,
+                                                     PROTOCOL_VERSION),
+                                strTest);
+            BOOST_CHECK_MESSAGE(tx.GetTotalSize() == data.size(), strTest);
+
+            // The same for the txn built from a mutable copy
+            CTransaction copy {CMutableTransaction(tx)};
+            BOOST_CHECK_MESSAGE(copy.GetId() == tx.GetId(), strTest);
+            BOOST_CHECK_MESSAGE(copy.GetTotalSize() == tx.GetTotalSize(),
+                                strTest);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(basic_transaction_tests) {
     // Random real transaction
     // (e2769b09e784f32f62ef849763d4f45b98e07ba658647343b915ff832b110436)
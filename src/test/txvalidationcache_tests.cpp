@@ -2,11 +2,13 @@
 // Copyright (c) 2019 Bitcoin Association
 // Distributed under the Open BSV software license, see the accompanying file LICENSE.
 
+#include "checkqueue.h"
 #include "config.h"
 #include "consensus/validation.h"
 #include "key.h"
 #include "keystore.h"
 #include "mining/legacy.h"
+#include "policy/policy.h"
 #include "pubkey.h"
 #include "random.h"
 #include "script/scriptcache.h"
@@ -114,6 +116,27 @@ namespace {
             }
         }
     }
+
+    // A transaction spending numInputs coins added to the view, each locked by
+    // OP_VERIFY OP_TRUE and unlocked with a push of 1.
+    CMutableTransaction CreateManyInputsTx(CCoinsViewCache &view,
+                                           size_t numInputs) {
+        CMutableTransaction tx;
+        tx.nVersion = 1;
+        tx.vin.resize(numInputs);
+        for (size_t i = 0; i < numInputs; i++) {
+            tx.vin[i].prevout = COutPoint(InsecureRand256(), 0);
+            tx.vin[i].scriptSig = CScript() << OP_1;
+            view.AddCoin(tx.vin[i].prevout,
+                         Coin(CTxOut(CENT, CScript() << OP_VERIFY << OP_TRUE),
+                              1, false),
+                         false);
+        }
+        tx.vout.resize(1);
+        tx.vout[0].nValue = CENT;
+        tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+        return tx;
+    }
 }
 
 BOOST_FIXTURE_TEST_SUITE(txvalidationcache_tests, TestChain100Setup2)
@@ -418,4 +441,96 @@ BOOST_AUTO_TEST_CASE(checkinputs_test) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(checkinputs_parallel) {
+    // Check the scripts of any transaction with more than one input on the
+    // mempool script-checking threads.
+    const unsigned int nOldParallelInputs = nParallelScriptCheckInputs;
+    nParallelScriptCheckInputs = 2;
+    const uint32_t flags = STANDARD_SCRIPT_VERIFY_FLAGS;
+
+    CCoinsViewCache view(pcoinsTip);
+    CMutableTransaction tx = CreateManyInputsTx(view, 100);
+    {
+        CValidationState state;
+        CTransaction transaction(tx);
+        PrecomputedTransactionData txdata(transaction);
+        BOOST_CHECK(CheckInputs(transaction, state, view, true, flags, true,
+                                false, txdata, nullptr));
+        BOOST_CHECK(state.IsValid());
+    }
+
+    // A single input failing a mandatory check is reported as such
+    {
+        CMutableTransaction invalid(tx);
+        invalid.vin[63].scriptSig = CScript() << OP_0;
+        CValidationState state;
+        CTransaction transaction(invalid);
+        PrecomputedTransactionData txdata(transaction);
+        BOOST_CHECK(!CheckInputs(transaction, state, view, true, flags, true,
+                                 false, txdata, nullptr));
+        BOOST_CHECK_EQUAL(state.GetRejectCode(), REJECT_INVALID);
+        BOOST_CHECK_EQUAL(
+            state.GetRejectReason(),
+            strprintf("mandatory-script-verify-flag-failed (%s)",
+                      ScriptErrorString(SCRIPT_ERR_VERIFY)));
+    }
+
+    // A single input failing a standard check only is reported as such
+    {
+        CMutableTransaction invalid(tx);
+        const std::vector<uint8_t> one {1};
+        invalid.vin[17].scriptSig = CScript() << OP_PUSHDATA1 << one;
+        CValidationState state;
+        CTransaction transaction(invalid);
+        PrecomputedTransactionData txdata(transaction);
+        BOOST_CHECK(!CheckInputs(transaction, state, view, true, flags, true,
+                                 false, txdata, nullptr));
+        BOOST_CHECK_EQUAL(state.GetRejectCode(), REJECT_NONSTANDARD);
+        BOOST_CHECK_EQUAL(
+            state.GetRejectReason(),
+            strprintf("non-mandatory-script-verify-flag (%s)",
+                      ScriptErrorString(SCRIPT_ERR_MINIMALDATA)));
+    }
+
+    nParallelScriptCheckInputs = nOldParallelInputs;
+}
+
+BOOST_AUTO_TEST_CASE(checkqueue_failed_check) {
+    CCheckQueue<CScriptCheck> queue(128);
+    CCoinsViewCache view(pcoinsTip);
+    CMutableTransaction tx = CreateManyInputsTx(view, 10);
+    tx.vin[7].scriptSig = CScript() << OP_0;
+    CTransaction transaction(tx);
+    PrecomputedTransactionData txdata(transaction);
+
+    {
+        CCheckQueueControl<CScriptCheck> control(&queue);
+
+        // The queue can't be taken while it is in use
+        CCheckQueueControl<CScriptCheck> other(&queue, boost::try_to_lock);
+        BOOST_CHECK(!other.IsUsingQueue());
+
+        std::vector<CScriptCheck> vChecks;
+        for (size_t i = 0; i < transaction.vin.size(); i++) {
+            vChecks.emplace_back(view.AccessCoin(transaction.vin[i].prevout)
+                                     .GetTxOut()
+                                     .scriptPubKey,
+                                 CENT, transaction, i,
+                                 STANDARD_SCRIPT_VERIFY_FLAGS, false, txdata);
+        }
+        control.Add(vChecks);
+
+        // The failing check is handed back
+        CScriptCheck failedCheck;
+        BOOST_CHECK(!control.Wait(&failedCheck));
+        BOOST_CHECK_EQUAL(failedCheck.GetInputIndex(), 7U);
+        BOOST_CHECK_EQUAL(failedCheck.GetScriptError(), SCRIPT_ERR_VERIFY);
+    }
+
+    // Once released it can be taken again, and is ready for new work
+    CCheckQueueControl<CScriptCheck> control(&queue, boost::try_to_lock);
+    BOOST_CHECK(control.IsUsingQueue());
+    BOOST_CHECK(control.Wait());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
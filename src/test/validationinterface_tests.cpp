@@ -0,0 +1,106 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "validationinterface.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+namespace {
+    // Records the transactions it is notified about
+    class CTestSubscriber : public CValidationInterface {
+      public:
+        explicit CTestSubscriber(bool fSynchronous)
+            : mfSynchronous{fSynchronous} {}
+
+        std::vector<CTransactionRef> mTxns {};
+        std::vector<std::thread::id> mThreads {};
+
+      protected:
+        bool IsSynchronous() const override { return mfSynchronous; }
+
+        void TransactionAddedToMempool(const CTransactionRef &ptx) override {
+            mTxns.push_back(ptx);
+            mThreads.push_back(std::this_thread::get_id());
+        }
+
+      private:
+        const bool mfSynchronous;
+    };
+
+    // Relies on the default delivery
+    class CDefaultSubscriber : public CValidationInterface {
+      public:
+        std::vector<std::thread::id> mThreads {};
+
+      protected:
+        void TransactionAddedToMempool(const CTransactionRef &ptx) override {
+            mThreads.push_back(std::this_thread::get_id());
+        }
+    };
+
+    std::vector<CTransactionRef> MakeTxns(size_t n) {
+        std::vector<CTransactionRef> txns {};
+        for (size_t i = 0; i < n; ++i) {
+            CMutableTransaction tx {};
+            tx.nLockTime = static_cast<uint32_t>(i);
+            txns.push_back(MakeTransactionRef(tx));
+        }
+        return txns;
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(validationinterface_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(synchronous_delivery) {
+    CTestSubscriber subscriber { true };
+    RegisterValidationInterface(&subscriber);
+    const std::vector<CTransactionRef> txns { MakeTxns(10) };
+    for (const CTransactionRef &tx : txns) {
+        GetMainSignals().TransactionAddedToMempool(tx);
+    }
+    // Delivered inline, before the signal returns
+    BOOST_CHECK(subscriber.mTxns == txns);
+    for (const std::thread::id &id : subscriber.mThreads) {
+        BOOST_CHECK(id == std::this_thread::get_id());
+    }
+    BOOST_CHECK_EQUAL(GetValidationInterfaceQueueStats().nAsyncSubscribers, 0);
+    UnregisterValidationInterface(&subscriber);
+}
+
+BOOST_AUTO_TEST_CASE(synchronous_by_default) {
+    CDefaultSubscriber subscriber {};
+    RegisterValidationInterface(&subscriber);
+    BOOST_CHECK_EQUAL(GetValidationInterfaceQueueStats().nAsyncSubscribers, 0);
+    GetMainSignals().TransactionAddedToMempool(MakeTxns(1)[0]);
+    BOOST_REQUIRE_EQUAL(subscriber.mThreads.size(), 1U);
+    BOOST_CHECK(subscriber.mThreads[0] == std::this_thread::get_id());
+    UnregisterValidationInterface(&subscriber);
+}
+
+BOOST_AUTO_TEST_CASE(asynchronous_delivery) {
+    CTestSubscriber subscriber { false };
+    RegisterValidationInterface(&subscriber);
+    BOOST_CHECK_EQUAL(GetValidationInterfaceQueueStats().nAsyncSubscribers, 1);
+    const std::vector<CTransactionRef> txns { MakeTxns(1000) };
+    for (const CTransactionRef &tx : txns) {
+        GetMainSignals().TransactionAddedToMempool(tx);
+    }
+    // Unregistering delivers everything still queued
+    UnregisterValidationInterface(&subscriber);
+    BOOST_CHECK(subscriber.mTxns == txns);
+    for (const std::thread::id &id : subscriber.mThreads) {
+        BOOST_CHECK(id != std::this_thread::get_id());
+    }
+    BOOST_CHECK_EQUAL(GetValidationInterfaceQueueStats().nAsyncSubscribers, 0);
+
+    // Nothing is delivered after unregistering
+    GetMainSignals().TransactionAddedToMempool(txns[0]);
+    BOOST_CHECK_EQUAL(subscriber.mTxns.size(), txns.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
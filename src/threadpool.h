@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <future>
@@ -86,6 +87,14 @@ class CPriorityQueueAdaptor
 *
 * Any callable object can be submitted (function, class method, lambda) with
 * any arguments and any return type. The result is returned in a future.
+*
+* Each worker thread has its own task queue so that submitting and picking up
+* tasks doesn't serialise all threads on a single lock. Tasks submitted from
+* outside the pool are spread over the queues round-robin, tasks submitted by
+* a worker go to its own queue, and a worker whose queue is empty steals from
+* the others. With a prioritised queue type each worker runs the highest
+* priority task it can find, starting with its own queue, so priorities are
+* only strictly observed by single threaded pools.
 */
 template<typename QueueAdapter>
 class CThreadPool final
@@ -119,22 +128,39 @@ class CThreadPool final
 
   private:
 
+    // A worker's task queue, on its own cache line
+    struct alignas(64) WorkerQueue
+    {
+        QueueAdapter mQueue {};
+        std::mutex mMtx {};
+    };
+
     // Worker thread entry point
     void worker(size_t n);
 
-    // The task queue
-    QueueAdapter mQueue {};
+    // Pop a task from worker n's queue, or steal one from another worker
+    bool popTask(size_t n, CTask& task);
+
+    // The per-worker task queues
+    std::vector<std::unique_ptr<WorkerQueue>> mQueues {};
+    // Next queue for tasks submitted from outside the pool
+    std::atomic<size_t> mNextQueue {0};
+    // Number of tasks in all the queues
+    std::atomic<size_t> mNumTasks {0};
+
+    // Sleeping workers wait on this for work, pausing and shutdown
     mutable std::mutex mQueueMtx {};
     std::condition_variable mQueueCondVar {};
+    std::atomic<size_t> mNumSleeping {0};
 
     // The worker threads
     std::vector<std::shared_ptr<std::thread>> mThreads {};
 
     // Flag to indicate we are shutting down
-    bool mRunning {true};
+    std::atomic<bool> mRunning {true};
 
     // Flag to indicate we are paused
-    bool mPaused {false};
+    std::atomic<bool> mPaused {false};
 
     // Owner string for logging
     const std::string mOwnerStr {};
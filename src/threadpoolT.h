@@ -4,11 +4,25 @@
 #include "logging.h"
 #include "util.h"
 
+namespace threadpool_detail
+{
+    // The pool and worker number of the current thread, if it is a worker
+    inline thread_local const void* currentPool { nullptr };
+    inline thread_local size_t currentWorker { 0 };
+}
+
 // Constructor
 template<typename QueueAdaptor>
 CThreadPool<QueueAdaptor>::CThreadPool(const std::string& owner, size_t numThreads)
 : mOwnerStr{owner}
 {
+    // Every worker needs its queue before any of them can steal
+    mQueues.reserve(numThreads);
+    for(size_t i = 0; i < numThreads; ++i)
+    {
+        mQueues.emplace_back(std::make_unique<WorkerQueue>());
+    }
+
     // Launch our workers
     mThreads.reserve(numThreads);
     for(size_t i = 0; i < numThreads; ++i)
@@ -36,6 +50,25 @@ CThreadPool<QueueAdaptor>::~CThreadPool()
     mThreads.clear();
 }
 
+// Pop a task from worker n's queue, or steal one from another worker
+template<typename QueueAdaptor>
+bool CThreadPool<QueueAdaptor>::popTask(size_t n, CTask& task)
+{
+    for(size_t i = 0; i < mQueues.size(); ++i)
+    {
+        WorkerQueue& queue { *mQueues[(n + i) % mQueues.size()] };
+        std::unique_lock<std::mutex> lock { queue.mMtx };
+        if(!queue.mQueue.empty())
+        {
+            task = queue.mQueue.pop();
+            --mNumTasks;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 // The worker threads
 template<typename QueueAdaptor>
 void CThreadPool<QueueAdaptor>::worker(size_t n)
@@ -44,22 +77,25 @@ void CThreadPool<QueueAdaptor>::worker(size_t n)
     RenameThread(s.c_str());
     LogPrintf("%s ThreadPool thread %d starting\n", mOwnerStr.c_str(), n);
 
+    threadpool_detail::currentPool = this;
+    threadpool_detail::currentWorker = n;
+
     while(mRunning)
     {
         CTask task {};
 
+        if(mPaused || !popTask(n, task))
         {
-            // Wait for work (or termination)
+            // Wait for work (or termination). Submitters only take the lock
+            // to wake us if they see we are sleeping, and we only sleep if we
+            // see no tasks after saying so, so one of us sees the other.
             std::unique_lock<std::mutex> lock { mQueueMtx };
+            ++mNumSleeping;
             mQueueCondVar.wait(lock,
-                [this]() { return !mRunning || (!mQueue.empty() && !mPaused); }
+                [this]() { return !mRunning || (mNumTasks > 0 && !mPaused); }
             );
-
-            if(!mRunning)
-                break;
-
-            // Pop next task
-            task = std::move(mQueue.pop());
+            --mNumSleeping;
+            continue;
         }
 
         // Run task
@@ -73,16 +109,35 @@ void CThreadPool<QueueAdaptor>::worker(size_t n)
 template<typename QueueAdaptor>
 void CThreadPool<QueueAdaptor>::submit(CTask&& task)
 {
-    std::unique_lock<std::mutex> lock { mQueueMtx };
-
     if(!mRunning)
     {   
         // Don't allow submitting new tasks when we're stopping
         throw std::runtime_error("Submitting to stopped " + mOwnerStr + " ThreadPool");
     }
 
-    mQueue.push(std::move(task));
-    mQueueCondVar.notify_one();
+    // Keep tasks submitted by our own workers on their queue
+    size_t n {};
+    if(threadpool_detail::currentPool == this)
+    {
+        n = threadpool_detail::currentWorker;
+    }
+    else
+    {
+        n = mNextQueue++ % mQueues.size();
+    }
+
+    {
+        WorkerQueue& queue { *mQueues[n] };
+        std::unique_lock<std::mutex> lock { queue.mMtx };
+        queue.mQueue.push(std::move(task));
+        ++mNumTasks;
+    }
+
+    if(mNumSleeping > 0)
+    {
+        std::unique_lock<std::mutex> lock { mQueueMtx };
+        mQueueCondVar.notify_one();
+    }
 }
 
 // Pause thread pool processing.
@@ -108,7 +163,5 @@ void CThreadPool<QueueAdaptor>::run()
 template<typename QueueAdaptor>
 bool CThreadPool<QueueAdaptor>::paused() const
 {
-    std::unique_lock<std::mutex> lock { mQueueMtx };
     return mPaused;
 }
-
@@ -11,13 +11,16 @@
 #include "init.h"
 #include "pow.h"
 #include "random.h"
+#include "task_helpers.h"
 #include "ui_interface.h"
 #include "uint256.h"
 #include "util.h"
 
 #include <boost/thread.hpp>
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 
 static const char DB_COIN = 'C';
 static const char DB_COINS = 'c';
@@ -30,6 +33,9 @@ static const char DB_HEAD_BLOCKS = 'H';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
+static const char DB_BLOCK_INDEX_SNAPSHOT = 'S';
+
+static const uint32_t BLOCK_INDEX_SNAPSHOT_VERSION = 1;
 
 namespace {
 
@@ -57,7 +63,8 @@ struct CoinEntry {
 } // namespace
 
 CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe)
-    : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true) {}
+    : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true,
+         CDBTuning::Chainstate()) {}
 
 bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return db.Read(CoinEntry(&outpoint), coin);
@@ -154,7 +161,7 @@ size_t CCoinsViewDB::EstimateSize() const {
 
 CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe)
     : CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory,
-                 fWipe) {}
+                 fWipe, false, CDBTuning::BlockIndex()) {}
 
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
     return Read(std::make_pair(DB_BLOCK_FILES, nFile), info);
@@ -246,6 +253,8 @@ bool CBlockTreeDB::WriteBatchSync(
         batch.Write(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()),
                     CDiskBlockIndex(*it));
     }
+    // Any block index snapshot no longer matches what is stored here
+    batch.Erase(DB_BLOCK_INDEX_SNAPSHOT);
     return WriteBatch(batch, true);
 }
 
@@ -274,6 +283,54 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+namespace {
+//! A batch of block index entries read from the database together with their
+//! block hashes.
+struct BlockIndexLoadBatch {
+    std::vector<CDiskBlockIndex> entries {};
+    std::vector<uint256> hashes {};
+    //! Position of the first entry failing its proof of work check, or
+    //! entries.size() if they all passed.
+    size_t firstInvalid {0};
+};
+
+//! Hash the entries in [begin, end) of a batch and check their proof of work.
+//! Returns the position of the first entry that fails, or the size of the
+//! batch if they all pass.
+size_t HashBlockIndexRange(BlockIndexLoadBatch &batch, const Config &config,
+                           size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        batch.hashes[i] = batch.entries[i].GetBlockHash();
+        if (!CheckProofOfWork(batch.hashes[i], batch.entries[i].nBits,
+                              config)) {
+            return i;
+        }
+    }
+    return batch.entries.size();
+}
+
+//! Compute the hashes of a batch of block index entries and check their proof
+//! of work, spreading the work over all cores.
+BlockIndexLoadBatch HashBlockIndexBatch(BlockIndexLoadBatch batch,
+                                        const Config &config) {
+    batch.hashes.resize(batch.entries.size());
+    batch.firstInvalid = batch.entries.size();
+
+    // Chunks are small enough that there are several per core, so a slow
+    // chunk doesn't hold up the whole batch.
+    for (size_t firstInvalid : parallel_for_chunks(
+             GetParallelTaskPool(), batch.entries.size(), 1000,
+             std::numeric_limits<size_t>::max(),
+             [&batch, &config](size_t begin, size_t end) {
+                 return HashBlockIndexRange(batch, config, begin, end);
+             })) {
+        batch.firstInvalid = std::min(batch.firstInvalid, firstInvalid);
+    }
+
+    return batch;
+}
+} // namespace
+
 bool CBlockTreeDB::LoadBlockIndexGuts(
     std::function<CBlockIndex *(const uint256 &)> insertBlockIndex) {
     const Config &config = GlobalConfig::GetConfig();
@@ -282,32 +339,173 @@ bool CBlockTreeDB::LoadBlockIndexGuts(
 
     pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
 
+    // Entries are read from the database in batches. While a batch is being
+    // read the previous one is hashed and has its proof of work checked in the
+    // background, after which it is inserted into mapBlockIndex in database
+    // order.
+    CThreadPool<CQueueAdaptor> loadPool { "BlockIndexLoadPool", 1 };
+    std::future<BlockIndexLoadBatch> pending {};
+    auto insertPending = [&pending, &insertBlockIndex]() -> bool {
+        if (!pending.valid()) {
+            return true;
+        }
+        const BlockIndexLoadBatch batch { pending.get() };
+        for (size_t i = 0; i < batch.entries.size(); ++i) {
+            const CDiskBlockIndex &diskindex { batch.entries[i] };
+
+            // Construct block index object
+            CBlockIndex *pindexNew = insertBlockIndex(batch.hashes[i]);
+            pindexNew->LoadFromPersistentData(
+                diskindex,
+                insertBlockIndex(diskindex.hashPrev));
+
+            if (i == batch.firstInvalid) {
+                return error("LoadBlockIndex(): CheckProofOfWork failed: %s",
+                             pindexNew->ToString());
+            }
+        }
+        return true;
+    };
+
     // Load mapBlockIndex
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        std::pair<char, uint256> key;
-        if (!pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX) {
-            break;
+    bool fMoreEntries = true;
+    while (fMoreEntries) {
+        BlockIndexLoadBatch batch {};
+        batch.entries.reserve(nBlockIndexLoadBatchSize);
+        while (batch.entries.size() < nBlockIndexLoadBatchSize) {
+            boost::this_thread::interruption_point();
+            std::pair<char, uint256> key;
+            if (!pcursor->Valid() || !pcursor->GetKey(key) ||
+                key.first != DB_BLOCK_INDEX) {
+                fMoreEntries = false;
+                break;
+            }
+
+            batch.entries.emplace_back();
+            if (!pcursor->GetValue(batch.entries.back())) {
+                return error("LoadBlockIndex() : failed to read value");
+            }
+
+            pcursor->Next();
         }
 
-        CDiskBlockIndex diskindex;
-        if (!pcursor->GetValue(diskindex)) {
-            return error("LoadBlockIndex() : failed to read value");
+        if (!insertPending()) {
+            return false;
         }
+        pending = make_task(loadPool, HashBlockIndexBatch, std::move(batch),
+                            std::cref(config));
+    }
 
-        // Construct block index object
-        CBlockIndex *pindexNew = insertBlockIndex(diskindex.GetBlockHash());
-        pindexNew->LoadFromPersistentData(
-            diskindex,
-            insertBlockIndex(diskindex.hashPrev));
+    return insertPending();
+}
 
-        if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits,
-                              config)) {
-            return error("LoadBlockIndex(): CheckProofOfWork failed: %s",
-                         pindexNew->ToString());
+bool CBlockTreeDB::WriteBlockIndexSnapshot(
+    const fs::path &path, const std::vector<const CBlockIndex *> &blockinfo) {
+    // Each snapshot gets a new identifier, which is also stored in the
+    // database once the file is safely on disk.
+    const uint256 id { GetRandHash() };
+    const fs::path pathTmp { path.string() + ".new" };
+
+    try {
+        CAutoFile file(fsbridge::fopen(pathTmp, "wb"), SER_DISK,
+                       CLIENT_VERSION);
+        if (file.IsNull()) {
+            return error("%s: failed to open %s", __func__, pathTmp.string());
         }
 
-        pcursor->Next();
+        // Entries are serialised once and both written and checksummed from
+        // the same buffer.
+        CHashWriter hasher(SER_DISK, CLIENT_VERSION);
+        CDataStream record(SER_DISK, CLIENT_VERSION);
+        auto writeRecord = [&file, &hasher, &record]() {
+            hasher.write(record.data(), record.size());
+            file.write(record.data(), record.size());
+            record.clear();
+        };
+
+        record << BLOCK_INDEX_SNAPSHOT_VERSION << id
+               << static_cast<uint64_t>(blockinfo.size());
+        writeRecord();
+        for (const CBlockIndex *pindex : blockinfo) {
+            record << pindex->GetBlockHash() << CDiskBlockIndex(pindex);
+            writeRecord();
+        }
+        file << hasher.GetHash();
+
+        FileCommit(file.Get());
+        file.fclose();
+    } catch (const std::exception &e) {
+        return error("%s: failed to write %s: %s", __func__, pathTmp.string(),
+                     e.what());
+    }
+
+    if (!RenameOver(pathTmp, path)) {
+        return error("%s: failed to rename %s", __func__, pathTmp.string());
+    }
+
+    return Write(DB_BLOCK_INDEX_SNAPSHOT, id, true);
+}
+
+bool CBlockTreeDB::LoadBlockIndexSnapshot(
+    const fs::path &path,
+    std::function<CBlockIndex *(const uint256 &)> insertBlockIndex) {
+    uint256 expectedId;
+    if (!Read(DB_BLOCK_INDEX_SNAPSHOT, expectedId)) {
+        LogPrintf("%s: no up to date block index snapshot\n", __func__);
+        return false;
+    }
+
+    try {
+        CAutoFile file(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+        if (file.IsNull()) {
+            return error("%s: failed to open %s", __func__, path.string());
+        }
+
+        // Read everything in one go and check it before using any of it
+        const uint64_t fileSize { fs::file_size(path) };
+        if (fileSize < sizeof(uint256)) {
+            return error("%s: %s is truncated", __func__, path.string());
+        }
+        CDataStream stream(SER_DISK, CLIENT_VERSION);
+        stream.resize(fileSize - sizeof(uint256));
+        file.read(stream.data(), stream.size());
+        uint256 checksum;
+        file >> checksum;
+
+        CHashWriter hasher(SER_DISK, CLIENT_VERSION);
+        hasher.write(stream.data(), stream.size());
+        if (hasher.GetHash() != checksum) {
+            return error("%s: checksum mismatch in %s", __func__,
+                         path.string());
+        }
+
+        uint32_t version;
+        uint256 id;
+        uint64_t count;
+        stream >> version >> id >> count;
+        if (version != BLOCK_INDEX_SNAPSHOT_VERSION || id != expectedId) {
+            LogPrintf("%s: block index snapshot is out of date\n", __func__);
+            return false;
+        }
+
+        for (uint64_t i = 0; i < count; ++i) {
+            boost::this_thread::interruption_point();
+            uint256 hash;
+            CDiskBlockIndex diskindex;
+            stream >> hash >> diskindex;
+
+            CBlockIndex *pindexNew = insertBlockIndex(hash);
+            pindexNew->LoadFromPersistentData(
+                diskindex,
+                insertBlockIndex(diskindex.hashPrev));
+        }
+        if (!stream.empty()) {
+            return error("%s: unexpected data at end of %s", __func__,
+                         path.string());
+        }
+    } catch (const std::exception &e) {
+        return error("%s: failed to read %s: %s", __func__, path.string(),
+                     e.what());
     }
 
     return true;
@@ -9,6 +9,7 @@
 #include "chain.h"
 #include "coins.h"
 #include "dbwrapper.h"
+#include "fs.h"
 
 #include <map>
 #include <string>
@@ -38,6 +39,9 @@ static const int64_t nMaxBlockDBCache = 2;
 static const int64_t nMaxBlockDBAndTxIndexCache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! Number of block index entries read from the database at a time when
+//! loading the block index
+static const size_t nBlockIndexLoadBatchSize = 20000;
 
 struct CDiskTxPos : public CDiskBlockPos {
     unsigned int nTxOffset; // after header
@@ -126,6 +130,23 @@ public:
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts(
         std::function<CBlockIndex *(const uint256 &)> insertBlockIndex);
+
+    /**
+     * Write the given block index entries to a checksummed snapshot file that
+     * can be loaded in one sequential read instead of scanning the database.
+     * The entries must match what is stored in the database; the snapshot is
+     * treated as stale as soon as any block index entry is written again.
+     */
+    bool WriteBlockIndexSnapshot(
+        const fs::path &path, const std::vector<const CBlockIndex *> &blockinfo);
+    /**
+     * Load block index entries from a snapshot file. Returns false if there
+     * is no snapshot or it is corrupt or stale, in which case the caller must
+     * discard anything inserted and fall back to LoadBlockIndexGuts().
+     */
+    bool LoadBlockIndexSnapshot(
+        const fs::path &path,
+        std::function<CBlockIndex *(const uint256 &)> insertBlockIndex);
 };
 
 #endif // BITCOIN_TXDB_H
@@ -1162,7 +1162,8 @@ static TxMempoolInfo
 GetInfo(CTxMemPool::indexed_transaction_set::const_iterator it) {
     return TxMempoolInfo{it->GetSharedTx(), it->GetTime(),
                          CFeeRate(it->GetFee(), it->GetTxSize()),
-                         it->GetModifiedFee() - it->GetFee()};
+                         it->GetModifiedFee() - it->GetFee(),
+                         it->GetFee(), it->GetTxSize()};
 }
 
 std::vector<TxMempoolInfo> CTxMemPool::InfoAll() const {
@@ -380,6 +380,12 @@ struct TxMempoolInfo {
 
     /** The fee delta. */
     Amount nFeeDelta;
+
+    /** The fee of the transaction. */
+    Amount nFee {0};
+
+    /** The serialized size of the transaction. */
+    size_t nTxSize {0};
 };
 
 /**
@@ -0,0 +1,131 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "txn_announcement_log.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+/** Append a batch of new transactions */
+void CTxnAnnouncementLog::append(Batch&& txns)
+{
+    if(txns.empty())
+        return;
+
+    std::unique_lock<std::mutex> lock { mMtx };
+    BatchPtr batch { std::make_shared<const LoggedBatch>(mEnd, std::move(txns)) };
+    mEnd += batch->mTxns.size();
+    mTxnCount += batch->mTxns.size();
+    mBatches.push_back(std::move(batch));
+}
+
+/** Fetch the retained batches that hold transactions at or after the cursor */
+std::vector<CTxnAnnouncementLog::BatchPtr> CTxnAnnouncementLog::getBatchesFrom(Cursor& cursor) const
+{
+    std::vector<BatchPtr> batches {};
+
+    std::unique_lock<std::mutex> lock { mMtx };
+    if(cursor == UNSET_CURSOR || mBatches.empty())
+    {
+        cursor = mEnd;
+        return batches;
+    }
+
+    // If the reader has fallen behind the start of the log, it has lost
+    // whatever was trimmed.
+    cursor = std::min(std::max(cursor, mBatches.front()->mStart), mEnd);
+    for(const BatchPtr& batch : mBatches)
+    {
+        if(batch->mStart + batch->mTxns.size() > cursor)
+        {
+            batches.push_back(batch);
+        }
+    }
+
+    return batches;
+}
+
+/** Drop all batches that lie entirely before the given cursor position */
+void CTxnAnnouncementLog::trim(Cursor oldest)
+{
+    std::unique_lock<std::mutex> lock { mMtx };
+    while(!mBatches.empty())
+    {
+        const LoggedBatch& batch { *mBatches.front() };
+        if(batch.mStart + batch.mTxns.size() > oldest)
+            break;
+
+        for(const std::atomic<bool>& erased : batch.mErased)
+        {
+            if(!erased.load(std::memory_order_relaxed))
+                --mTxnCount;
+        }
+        mBatches.pop_front();
+    }
+}
+
+/** Erase the given transactions from all retained batches */
+void CTxnAnnouncementLog::erase(const std::vector<CTxnSendingDetails>& txns)
+{
+    if(txns.empty())
+        return;
+
+    std::unordered_set<uint256, SaltedTxidHasher> hashes {};
+    hashes.reserve(txns.size());
+    for(const CTxnSendingDetails& txn : txns)
+    {
+        hashes.insert(txn.getInv().hash);
+    }
+
+    std::unique_lock<std::mutex> lock { mMtx };
+    for(const BatchPtr& batch : mBatches)
+    {
+        for(size_t i = 0; i < batch->mTxns.size(); ++i)
+        {
+            if(hashes.count(batch->mTxns[i].getInv().hash) != 0 &&
+               !batch->mErased[i].exchange(true, std::memory_order_relaxed))
+            {
+                --mTxnCount;
+            }
+        }
+    }
+}
+
+/** Get the cursor position just past the newest transaction */
+CTxnAnnouncementLog::Cursor CTxnAnnouncementLog::getEndCursor() const
+{
+    std::unique_lock<std::mutex> lock { mMtx };
+    return mEnd;
+}
+
+/** Get the number of non-erased transactions a reader has yet to read */
+size_t CTxnAnnouncementLog::getUnreadTxnCount(Cursor cursor) const
+{
+    size_t count {0};
+    if(cursor != UNSET_CURSOR)
+    {
+        for(const BatchPtr& batch : getBatchesFrom(cursor))
+        {
+            for(size_t i = cursor - batch->mStart; i < batch->mTxns.size(); ++i, ++cursor)
+            {
+                if(!batch->mErased[i].load(std::memory_order_relaxed))
+                    ++count;
+            }
+        }
+    }
+    return count;
+}
+
+/** Get the number of batches currently retained */
+size_t CTxnAnnouncementLog::getBatchCount() const
+{
+    std::unique_lock<std::mutex> lock { mMtx };
+    return mBatches.size();
+}
+
+/** Get the number of non-erased transactions currently retained */
+size_t CTxnAnnouncementLog::getTxnCount() const
+{
+    std::unique_lock<std::mutex> lock { mMtx };
+    return mTxnCount;
+}
@@ -0,0 +1,135 @@
+// Copyright (c) 2019 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#pragma once
+
+#include "txn_sending_details.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+* A log of new transactions to be announced to our peers, shared by all
+* of them.
+*
+* The transaction propagator records each batch of new transactions in the
+* log exactly once, already sorted into the order they should be announced.
+* Every logged transaction has an increasing sequence number, and each peer
+* reads through the log at its own pace using a cursor (the sequence number
+* of the next transaction it has yet to see), applying its own filtering to
+* what it finds there as it builds its inventory messages. Nothing is copied
+* out of the log for each peer.
+*
+* Batches are dropped from the log once all peers have read past them.
+* Transactions that leave the mempool are marked as erased in the log once,
+* so that no peer announces them any more.
+*/
+class CTxnAnnouncementLog final
+{
+  public:
+
+    using Batch = std::vector<CTxnSendingDetails>;
+
+    /** A reader's position within the log */
+    using Cursor = uint64_t;
+    /** Cursor value for a reader that hasn't started reading the log yet */
+    static constexpr Cursor UNSET_CURSOR {0};
+
+    CTxnAnnouncementLog() = default;
+
+    // Forbid copying/assignment
+    CTxnAnnouncementLog(const CTxnAnnouncementLog&) = delete;
+    CTxnAnnouncementLog(CTxnAnnouncementLog&&) = delete;
+    CTxnAnnouncementLog& operator=(const CTxnAnnouncementLog&) = delete;
+    CTxnAnnouncementLog& operator=(CTxnAnnouncementLog&&) = delete;
+
+    /** Append a batch of new transactions */
+    void append(Batch&& txns);
+
+    /**
+    * Pass transactions from the given cursor position onwards to the
+    * callable, in the order they were logged and skipping any that have been
+    * erased, until it has accepted (returned true for) maxAccepted of them or
+    * the end of the log is reached. The cursor is advanced past every
+    * transaction passed to the callable.
+    *
+    * An unset cursor is just moved to the end of the log, and a cursor that
+    * points before the oldest retained transaction is moved up to it.
+    * Returns the number of transactions accepted.
+    */
+    template<typename Callable>
+    size_t read(Cursor& cursor, size_t maxAccepted, Callable&& accept) const;
+
+    /** Drop all batches that lie entirely before the given cursor position */
+    void trim(Cursor oldest);
+
+    /** Erase the given transactions from all retained batches */
+    void erase(const std::vector<CTxnSendingDetails>& txns);
+
+    /** Get the cursor position just past the newest transaction */
+    Cursor getEndCursor() const;
+
+    /** Get the number of non-erased transactions a reader has yet to read */
+    size_t getUnreadTxnCount(Cursor cursor) const;
+
+    /** Get the number of batches/(non-erased) transactions currently retained */
+    size_t getBatchCount() const;
+    size_t getTxnCount() const;
+
+  private:
+
+    /** A logged batch along with its position in the log */
+    struct LoggedBatch
+    {
+        LoggedBatch(Cursor start, Batch&& txns)
+            : mStart{start}, mTxns{std::move(txns)}, mErased(mTxns.size())
+        {}
+
+        /** Sequence number of the first transaction in the batch */
+        const Cursor mStart;
+        const Batch mTxns;
+        /** Flags for erased transactions; set under the log mutex, read without it */
+        mutable std::vector<std::atomic<bool>> mErased;
+    };
+    using BatchPtr = std::shared_ptr<const LoggedBatch>;
+
+    /** Fetch the retained batches that hold transactions at or after the cursor */
+    std::vector<BatchPtr> getBatchesFrom(Cursor& cursor) const;
+
+    /** Retained batches, oldest first */
+    std::deque<BatchPtr> mBatches {};
+    /** Sequence number for the next transaction appended */
+    Cursor mEnd {UNSET_CURSOR + 1};
+    /** Number of non-erased transactions in retained batches */
+    size_t mTxnCount {0};
+    mutable std::mutex mMtx {};
+};
+
+template<typename Callable>
+size_t CTxnAnnouncementLog::read(Cursor& cursor, size_t maxAccepted, Callable&& accept) const
+{
+    size_t numAccepted {0};
+
+    // Batches are immutable apart from their erase flags, so they can be read
+    // without holding the log mutex while they are being filtered.
+    for(const BatchPtr& batch : getBatchesFrom(cursor))
+    {
+        for(size_t i = cursor - batch->mStart; i < batch->mTxns.size(); ++i)
+        {
+            if(numAccepted == maxAccepted)
+                return numAccepted;
+
+            ++cursor;
+            if(batch->mErased[i].load(std::memory_order_relaxed))
+                continue;
+            if(accept(batch->mTxns[i]))
+                ++numAccepted;
+        }
+    }
+
+    return numAccepted;
+}
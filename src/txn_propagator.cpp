@@ -63,7 +63,7 @@ void CTxnPropagator::removeTransactions(const std::vector<CTransactionRef>& txns
     LogPrint(BCLog::TXNPROP, "Purging %d transactions\n", txns.size());
 
     // Create sorted list of CTxnSendingDetails as required to remove them from
-    // a nodes list.
+    // the list of new transactions.
     std::vector<CTxnSendingDetails> txnDetails {};
     txnDetails.reserve(txns.size());
     CompareTxnSendingDetails comp { &mempool };
@@ -77,7 +77,7 @@ void CTxnPropagator::removeTransactions(const std::vector<CTransactionRef>& txns
         std::sort(txnDetails.begin(), txnDetails.end(), comp);
     }
 
-    // Filter list of new transactions
+    // Filter list of new transactions and the announcement log
     {
         std::vector<CTxnSendingDetails> filteredNewTxns {};
 
@@ -89,16 +89,9 @@ void CTxnPropagator::removeTransactions(const std::vector<CTransactionRef>& txns
         std::set_difference(mNewTxns.begin(), mNewTxns.end(), txnDetails.begin(), txnDetails.end(),
             std::inserter(filteredNewTxns, filteredNewTxns.begin()), comp);
         mNewTxns = std::move(filteredNewTxns);
-    }
 
-    // Update lists of pending transactions for each node
-    {
-        std::shared_lock lock(mempool.smtx);
-        auto results { g_connman->ParallelForEachNode([&txnDetails](const CNodePtr& node) { node->RemoveTxnsFromInventory(txnDetails); }) };
-
-        // Wait for all nodes to finish processing so we can safely release the mempool lock
-        for(auto& result : results)
-            result.wait();
+        // Done once here for all peers; they skip erased txns as they read the log
+        mAnnouncementLog.erase(txnDetails);
     }
 }
 
@@ -154,17 +147,33 @@ void CTxnPropagator::threadNewTxnHandler() noexcept
 */
 void CTxnPropagator::processNewTransactions()
 {
+    // Forget about anything all our peers have already seen. Newly connected
+    // peers start reading from the end of the log as it was before this
+    // latest batch was added.
+    CTxnAnnouncementLog::Cursor oldest { mAnnouncementLog.getEndCursor() };
+    g_connman->ForEachNode([&oldest](const CNodePtr& node) {
+        CTxnAnnouncementLog::Cursor cursor { node->GetTxnAnnouncementCursor() };
+        if(cursor != CTxnAnnouncementLog::UNSET_CURSOR)
+        {
+            oldest = std::min(oldest, cursor);
+        }
+    });
+    mAnnouncementLog.trim(oldest);
+
     {
-        // Take the mempool lock so we can do all the difficult txn sorting and node updating in parallel.
+        // Sort the new transactions into the order they should be announced
+        // in. Each peer reads them straight from the log in that order as it
+        // sends its inventory, applying its own filtering.
         std::shared_lock lock(mempool.smtx);
-        auto results { g_connman->ParallelForEachNode([this](const CNodePtr& node) { node->AddTxnsToInventory(mNewTxns); }) };
-
-        // Wait for all nodes to finish processing so we can safely release the mempool lock
-        for(auto& result : results)
-            result.wait();
+        CompareTxnSendingDetails comp { &mempool };
+        std::sort(mNewTxns.begin(), mNewTxns.end(),
+            [&comp](const CTxnSendingDetails& a, const CTxnSendingDetails& b) { return comp(b, a); });
     }
 
-    // Clear new transactions list
+    // Record the new transactions once in the shared announcement log
+    mAnnouncementLog.append(std::move(mNewTxns));
     mNewTxns.clear();
-}
 
+    LogPrint(BCLog::TXNPROP, "Announcement log holds %d transactions in %d batches\n",
+        mAnnouncementLog.getTxnCount(), mAnnouncementLog.getBatchCount());
+}
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "txn_announcement_log.h"
 #include "txn_sending_details.h"
 
 #include <atomic>
@@ -46,6 +47,9 @@ class CTxnPropagator final
     /** Get the number of queued new transactions awaiting processing */
     size_t getNewTxnQueueLength() const;
 
+    /** Get the log of transactions to announce that our peers read from */
+    const CTxnAnnouncementLog& getAnnouncementLog() const { return mAnnouncementLog; }
+
   private:
 
     /** Thread entry point for new transaction queue handling */
@@ -59,6 +63,9 @@ class CTxnPropagator final
     std::vector<CTxnSendingDetails> mNewTxns {};
     mutable std::mutex mNewTxnsMtx {};
 
+    /** Processed new transactions waiting to be picked up by our peers */
+    CTxnAnnouncementLog mAnnouncementLog {};
+
     /** Our main thread */
     std::thread mNewTxnsThread {};
     std::condition_variable mNewTxnsCV {} ;
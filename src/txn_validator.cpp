@@ -7,6 +7,8 @@
 #include "config.h"
 #include "net_processing.h"
 
+#include <unordered_map>
+
 /** Constructor */
 CTxnValidator::CTxnValidator(
     const Config& config,
@@ -170,6 +172,73 @@ CValidationState CTxnValidator::processValidation(
     return result.mState;
 }
 
+/** Process a batch of new txns in synchronous mode */
+std::vector<CValidationState> CTxnValidator::processValidation(
+    TxInputDataSPtrVec& vTxInputData,
+    const mining::CJournalChangeSetPtr& changeSet) {
+
+    LogPrint(BCLog::TXNVAL,
+            "Txnval-synch: Got a batch of %d new txns\n",
+             vTxInputData.size());
+    // The same lock order as for a single txn: first cs_main, then mMainMtx.
+    LOCK(cs_main);
+    std::unique_lock lock { mMainMtx };
+    // Get a threshold value for a minimum number of txns that we want to assign per task
+    size_t nTxnsPerTaskThreshold {
+        static_cast<size_t>(gArgs.GetArg("-txnspertaskthreshold", DEFAULT_TXNS_PER_TASK_THRESHOLD))
+    };
+    // Check fee estimation requirements
+    bool fReadyForFeeEstimation = IsCurrentForFeeEstimation();
+    // Map each txn to its position in the batch.
+    std::unordered_map<const CTxInputData*, size_t> mTxnPos {};
+    mTxnPos.reserve(vTxInputData.size());
+    for (size_t i = 0; i < vTxInputData.size(); ++i) {
+        mTxnPos.emplace(vTxInputData[i].get(), i);
+    }
+    // Validate txns and try to submit them to the mempool
+    std::vector<CTxnValResult> vResults {
+        validateTxnsNL(
+                vTxInputData,
+                changeSet,
+                nTxnsPerTaskThreshold,
+                fReadyForFeeEstimation)
+    };
+    // Process detected double spend transactions (sequential execution)
+    std::vector<TxInputDataSPtr> vDetectedDoubleSpends {
+        mpTxnDoubleSpendDetector->getDoubleSpendTxns()
+    };
+    if (!vDetectedDoubleSpends.empty()) {
+        LogPrint(BCLog::TXNVAL, "Txnval-synch: Process detected %d double spend transaction(s)\n",
+                vDetectedDoubleSpends.size());
+        std::vector<CTxnValResult> vDoubleSpendResults {
+            validateTxnsNL(
+                    vDetectedDoubleSpends,
+                    changeSet,
+                    0,
+                    fReadyForFeeEstimation)
+        };
+        // A re-tried txn overrides its earlier result.
+        vResults.insert(vResults.end(),
+            std::make_move_iterator(vDoubleSpendResults.begin()),
+            std::make_move_iterator(vDoubleSpendResults.end()));
+    }
+    std::vector<CValidationState> vStates(vTxInputData.size());
+    for (const auto& result : vResults) {
+        const auto pos { mTxnPos.find(result.mTxInputData.get()) };
+        if (pos != mTxnPos.end()) {
+            vStates[pos->second] = result.mState;
+        }
+    }
+    // Notify subscribers that new txns were added to the mempool.
+    for (size_t i = 0; i < vTxInputData.size(); ++i) {
+        if (vStates[i].IsValid()) {
+            GetMainSignals().TransactionAddedToMempool(vTxInputData[i]->mpTx);
+        }
+    }
+
+    return vStates;
+}
+
 /** Thread entry point for new transaction queue handling */
 void CTxnValidator::threadNewTxnHandler() noexcept {
     try {
@@ -306,6 +375,32 @@ CTxnValidator::processNewTransactionsNL(
     size_t nTxnsPerTaskThreshold,
     bool fReadyForFeeEstimation) {
 
+    // Trigger parallel validation for txns
+    std::vector<CTxnValResult> vResults {
+        validateTxnsNL(
+                txns,
+                journalChangeSet,
+                nTxnsPerTaskThreshold,
+                fReadyForFeeEstimation)
+    };
+    // Process validation results for transactions.
+    std::vector<TxInputDataSPtr> vAcceptedTxns {};
+    for (auto& result : vResults) {
+        postValidationP2PStepsNL(result, vAcceptedTxns);
+    }
+    return vAcceptedTxns;
+}
+
+/**
+* Validate txns in parallel and submit the valid ones to the mempool.
+*/
+std::vector<CTxnValResult>
+CTxnValidator::validateTxnsNL(
+    std::vector<TxInputDataSPtr>& txns,
+    const mining::CJournalChangeSetPtr& journalChangeSet,
+    size_t nTxnsPerTaskThreshold,
+    bool fReadyForFeeEstimation) {
+
     auto tx_validation = [](const TxInputDataSPtrRefVec& vTxInputData,
                             const Config* config,
                             CTxMemPool *pool,
@@ -336,15 +431,16 @@ CTxnValidator::processNewTransactionsNL(
                         handlers,
                         fReadyForFeeEstimation)
     };
-    // Process validation results for transactions.
-    std::vector<TxInputDataSPtr> vAcceptedTxns {};
+    // Collect results in the order of the given txns.
+    std::vector<CTxnValResult> vResults {};
+    vResults.reserve(txns.size());
     for(auto& task_result : results) {
         auto vBatchResults = task_result.get();
-        for (auto& result : vBatchResults) {
-            postValidationP2PStepsNL(result, vAcceptedTxns);
-        }
+        vResults.insert(vResults.end(),
+            std::make_move_iterator(vBatchResults.begin()),
+            std::make_move_iterator(vBatchResults.end()));
     }
-    return vAcceptedTxns;
+    return vResults;
 }
 
 void CTxnValidator::postValidationP2PStepsNL(
@@ -68,6 +68,18 @@ class CTxnValidator final
         const mining::CJournalChangeSetPtr& changeSet,
         bool fLimitMempoolSize=false);
 
+    /**
+     * Process a batch of new txns with wait.
+     * Txns are validated in parallel, so no txn in the batch may spend
+     * an output of another txn from the same batch.
+     * The mempool size is not limited and the coins cache is not flushed,
+     * that is left to the caller once it has submitted all its batches.
+     * Returns validation states in the order of the given txns.
+     */
+    std::vector<CValidationState> processValidation(
+        TxInputDataSPtrVec& vTxInputData,
+        const mining::CJournalChangeSetPtr& changeSet);
+
     /**
      * Orphan & rejected txns handlers.
      */
@@ -95,6 +107,13 @@ class CTxnValidator final
         size_t nTxnsPerTaskThreshold,
         bool fReadyForFeeEstimation);
 
+    /** Validate txns in parallel and submit valid ones to the mempool. Return all results */
+    std::vector<CTxnValResult> validateTxnsNL(
+        std::vector<TxInputDataSPtr>& txns,
+        const mining::CJournalChangeSetPtr& journalChangeSet,
+        size_t nTxnsPerTaskThreshold,
+        bool fReadyForFeeEstimation);
+
     /** Post validation step for p2p txns before limit mempool size is done*/
     void postValidationP2PStepsNL(
         const CTxnValResult& txStatus,
@@ -48,8 +48,12 @@
 #include "warnings.h"
 #include "blockfileinfostore.h"
 
+#include <algorithm>
 #include <atomic>
+#include <list>
+#include <mutex>
 #include <sstream>
+#include <unordered_set>
 
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/replace.hpp>
@@ -75,6 +79,7 @@ CBlockIndex *pindexBestHeader = nullptr;
 CWaitableCriticalSection csBestBlock;
 CConditionVariable cvBlockChange;
 int nScriptCheckThreads = 0;
+unsigned int nParallelScriptCheckInputs = DEFAULT_PARALLEL_SCRIPTCHECK_INPUTS;
 std::atomic_bool fImporting(false);
 bool fReindex = false;
 bool fTxIndex = false;
@@ -468,7 +473,7 @@ static bool CheckTransactionCommon(const CTransaction& tx,
     }
 
     // Size limit
-    if (::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION) > MAX_TX_SIZE) {
+    if (tx.GetTotalSize() > MAX_TX_SIZE) {
         return state.DoS(100, false, REJECT_INVALID, "bad-txns-oversize");
     }
 
@@ -1685,6 +1690,43 @@ static void UpdateMempoolForReorg(const Config &config,
         gArgs.GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60);
 }
 
+namespace {
+    CBlockFileReadCache blockFileReadCache {};
+
+    /**
+     * Read the txn at the given txindex position from an open block file.
+     * On a read error the file is closed and set to nullptr, otherwise it
+     * stays open for further reads.
+     */
+    bool ReadTxFromBlockFile(FILE *&file, const CDiskTxPos &postx,
+                             const TxId &txid, CTransactionRef &txOut,
+                             uint256 &hashBlock) {
+        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+        file = nullptr;
+        if (filein.IsNull()) {
+            return error("%s: OpenBlockFile failed", __func__);
+        }
+        CBlockHeader header;
+        try {
+            if (fseek(filein.Get(), postx.nPos, SEEK_SET)) {
+                return error("%s: fseek failed", __func__);
+            }
+            filein >> header;
+            fseek(filein.Get(), postx.nTxOffset, SEEK_CUR);
+            filein >> txOut;
+        } catch (const std::exception &e) {
+            return error("%s: Deserialize or I/O error - %s", __func__,
+                         e.what());
+        }
+        file = filein.release();
+        hashBlock = header.GetHash();
+        if (txOut->GetId() != txid) {
+            return error("%s: txid mismatch", __func__);
+        }
+        return true;
+    }
+}
+
 /**
  * Return transaction in txOut, and if it was found inside a block, its hash is
  * placed in hashBlock.
@@ -1694,8 +1736,6 @@ bool GetTransaction(const Config &config, const TxId &txid,
                     bool fAllowSlow) {
     CBlockIndex *pindexSlow = nullptr;
 
-    LOCK(cs_main);
-
     CTransactionRef ptx = mempool.Get(txid);
     if (ptx) {
         txOut = ptx;
@@ -1703,36 +1743,31 @@ bool GetTransaction(const Config &config, const TxId &txid,
     }
 
     if (fTxIndex) {
+        // Positions in the txindex never change once written, and a txn is
+        // indexed before it is removed from the mempool, so cs_main isn't
+        // needed here.
         CDiskTxPos postx;
         if (pblocktree->ReadTxIndex(txid, postx)) {
-            CAutoFile file(CDiskFiles::OpenBlockFile(postx, true), SER_DISK,
-                           CLIENT_VERSION);
-            if (file.IsNull()) {
-                return error("%s: OpenBlockFile failed", __func__);
-            }
-            CBlockHeader header;
-            try {
-                file >> header;
-                fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-                file >> txOut;
-            } catch (const std::exception &e) {
-                return error("%s: Deserialize or I/O error - %s", __func__,
-                             e.what());
-            }
-            hashBlock = header.GetHash();
-            if (txOut->GetId() != txid) {
-                return error("%s: txid mismatch", __func__);
+            FILE *file { blockFileReadCache.Take(postx.nFile) };
+            const bool fRead {
+                ReadTxFromBlockFile(file, postx, txid, txOut, hashBlock)
+            };
+            if (file) {
+                blockFileReadCache.Return(postx.nFile, file);
             }
-            return true;
+            return fRead;
         }
     }
 
+    if (!fAllowSlow) {
+        return false;
+    }
+
     // use coin database to locate block that contains transaction, and scan it
-    if (fAllowSlow) {
-        const Coin &coin = AccessByTxid(*pcoinsTip, txid);
-        if (!coin.IsSpent()) {
-            pindexSlow = chainActive[coin.GetHeight()];
-        }
+    LOCK(cs_main);
+    const Coin &coin = AccessByTxid(*pcoinsTip, txid);
+    if (!coin.IsSpent()) {
+        pindexSlow = chainActive[coin.GetHeight()];
     }
 
     if (pindexSlow) {
@@ -1751,6 +1786,54 @@ bool GetTransaction(const Config &config, const TxId &txid,
     return false;
 }
 
+void GetTransactions(const std::vector<TxId> &vTxIds,
+                     std::vector<CTransactionRef> &vTxOut,
+                     std::vector<uint256> &vHashBlock) {
+    vTxOut.assign(vTxIds.size(), nullptr);
+    vHashBlock.assign(vTxIds.size(), uint256());
+
+    // Look in the mempool first and collect txindex positions of the rest
+    std::vector<std::pair<CDiskTxPos, size_t>> vPositions {};
+    for (size_t i = 0; i < vTxIds.size(); ++i) {
+        vTxOut[i] = mempool.Get(vTxIds[i]);
+        CDiskTxPos postx;
+        if (!vTxOut[i] && fTxIndex &&
+            pblocktree->ReadTxIndex(vTxIds[i], postx)) {
+            vPositions.emplace_back(postx, i);
+        }
+    }
+
+    // Read in disk order, so that each block file is read front to back
+    // through a single handle.
+    std::sort(vPositions.begin(), vPositions.end(),
+        [](const std::pair<CDiskTxPos, size_t> &a,
+           const std::pair<CDiskTxPos, size_t> &b) {
+            return std::tie(a.first.nFile, a.first.nPos, a.first.nTxOffset) <
+                   std::tie(b.first.nFile, b.first.nPos, b.first.nTxOffset);
+        });
+    FILE *file { nullptr };
+    int nFile { -1 };
+    for (const auto &position : vPositions) {
+        const CDiskTxPos &postx { position.first };
+        const size_t i { position.second };
+        if (postx.nFile != nFile || !file) {
+            if (file) {
+                blockFileReadCache.Return(nFile, file);
+            }
+            nFile = postx.nFile;
+            file = blockFileReadCache.Take(nFile);
+        }
+        if (!ReadTxFromBlockFile(file, postx, vTxIds[i], vTxOut[i],
+                                 vHashBlock[i])) {
+            vTxOut[i] = nullptr;
+            vHashBlock[i].SetNull();
+        }
+    }
+    if (file) {
+        blockFileReadCache.Return(nFile, file);
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // CBlock and CBlockIndex
@@ -1762,30 +1845,23 @@ static bool WriteBlockToDisk(
     const CMessageHeader::MessageMagic &messageStart,
     CDiskBlockMetaData& metaData)
 {
-    // Open history file to append
-    CAutoFile fileout(CDiskFiles::OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull()) {
-        return error("WriteBlockToDisk: OpenBlockFile failed");
-    }
+    // Serialize the block after room for the index header
+    std::vector<uint8_t> data(BLOCKFILE_BLOCK_HEADER_SIZE);
+    CVectorWriter{SER_DISK, CLIENT_VERSION, data, BLOCKFILE_BLOCK_HEADER_SIZE, block};
+    unsigned int nSize = data.size() - BLOCKFILE_BLOCK_HEADER_SIZE;
+    metaData = { Hash(data.begin() + BLOCKFILE_BLOCK_HEADER_SIZE, data.end()), nSize };
 
     // Write index header
-    unsigned int nSize = GetSerializeSize(fileout, block);
-    fileout << FLATDATA(messageStart) << nSize;
+    CVectorWriter{SER_DISK, CLIENT_VERSION, data, 0, FLATDATA(messageStart), nSize};
 
-    // Write block
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0) {
-        return error("WriteBlockToDisk: ftell failed");
+    // The data is written in the background; reads of the file wait for it
+    CDiskBlockPos writePos { pos };
+    pos.nPos += BLOCKFILE_BLOCK_HEADER_SIZE;
+    if (!pBlockFileInfoStore->WriteBlockFileData(BlockFileType::BLOCK, writePos,
+            std::move(data))) {
+        return error("WriteBlockToDisk: writing block file failed");
     }
 
-    pos.nPos = (unsigned int)fileOutPos;
-
-    std::vector<uint8_t> data;
-    CVectorWriter{SER_DISK, CLIENT_VERSION, data, 0, block};
-    metaData = { Hash(data.begin(), data.end()), data.size() };
-
-    fileout.write(reinterpret_cast<const char*>(data.data()), data.size());
-
     return true;
 }
 
@@ -1931,7 +2007,7 @@ std::unique_ptr<CForwardAsyncReadonlyStream> StreamBlockFromDisk(
 }
 
 
-std::unique_ptr<CForwardReadonlyStream> StreamSyncBlockFromDisk(CBlockIndex& index)
+std::unique_ptr<CForwardReadonlyStream> StreamSyncBlockFromDisk(const CBlockIndex& index)
 {
     AssertLockHeld(cs_main);
 
@@ -2228,6 +2304,61 @@ bool CheckTxInputs(const CTransaction &tx, CValidationState &state,
 }
 } // namespace Consensus
 
+static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+
+void ThreadScriptCheck(int workerNum) {
+    std::string s = strprintf("bitcoin-scriptch%d", workerNum);
+    RenameThread(s.c_str());
+    scriptcheckqueue.Thread();
+}
+
+// Checks of transactions too big to check on a single thread that aren't part
+// of a block (mempool acceptance) go to a queue of their own, so that they can
+// never hold up block connection.
+static CCheckQueue<CScriptCheck> mempoolscriptcheckqueue(128);
+
+void ThreadMempoolScriptCheck(int workerNum) {
+    std::string s = strprintf("bitcoin-mpscriptch%d", workerNum);
+    RenameThread(s.c_str());
+    mempoolscriptcheckqueue.Thread();
+}
+
+// Fill in the state for a failed script check of the given input
+static bool InvalidScriptCheck(const CTransaction &tx, CValidationState &state,
+                               const CCoinsViewCache &inputs,
+                               const CScriptCheck &check, const uint32_t flags,
+                               bool sigCacheStore,
+                               const PrecomputedTransactionData &txdata) {
+    const Coin &coin = inputs.AccessCoin(tx.vin[check.GetInputIndex()].prevout);
+    const bool hasNonMandatoryFlags =
+        (flags & STANDARD_NOT_MANDATORY_VERIFY_FLAGS) != 0;
+    if (hasNonMandatoryFlags) {
+        // Check whether the failure was caused by a non-mandatory script
+        // verification check, such as non-standard DER encodings or non-null
+        // dummy arguments; if so, don't trigger DoS protection to avoid
+        // splitting the network between upgraded and non-upgraded nodes.
+        CScriptCheck check2(coin.GetTxOut().scriptPubKey,
+                            coin.GetTxOut().nValue, tx,
+                            check.GetInputIndex(),
+                            (flags & ~STANDARD_NOT_MANDATORY_VERIFY_FLAGS),
+                            sigCacheStore, txdata);
+        if (check2()) {
+            return state.Invalid(false, REJECT_NONSTANDARD,
+                    strprintf("non-mandatory-script-verify-flag (%s)", ScriptErrorString(check.GetScriptError())));
+        }
+    }
+
+    // Failures of other flags indicate a transaction that is invalid in new
+    // blocks, e.g. a invalid P2SH. We DoS ban such nodes as they are not
+    // following the protocol. That said during an upgrade careful thought
+    // should be taken as to the correct behavior - we may want to continue
+    // peering with non-upgraded nodes even after soft-fork super-majority
+    // signaling has occurred.
+    return state.DoS(100, false, REJECT_INVALID,
+                     strprintf("mandatory-script-verify-flag-failed (%s)",
+                               ScriptErrorString(check.GetScriptError())));
+}
+
 bool CheckInputs(const CTransaction &tx, CValidationState &state,
                  const CCoinsViewCache &inputs, bool fScriptChecks,
                  const uint32_t flags, bool sigCacheStore,
@@ -2266,6 +2397,37 @@ bool CheckInputs(const CTransaction &tx, CValidationState &state,
         return true;
     }
 
+    // A transaction with very many inputs would tie up this thread for a long
+    // time, so spread its checks over the mempool script-checking threads
+    // instead. If another transaction is using them already, check this one
+    // here rather than wait.
+    if (!pvChecks && nScriptCheckThreads &&
+        tx.vin.size() >= nParallelScriptCheckInputs) {
+        CCheckQueueControl<CScriptCheck> control(&mempoolscriptcheckqueue,
+                                                 boost::try_to_lock);
+        if (control.IsUsingQueue()) {
+            std::vector<CScriptCheck> vChecks;
+            vChecks.reserve(tx.vin.size());
+            for (size_t i = 0; i < tx.vin.size(); i++) {
+                const Coin &coin = inputs.AccessCoin(tx.vin[i].prevout);
+                assert(!coin.IsSpent());
+                vChecks.emplace_back(coin.GetTxOut().scriptPubKey,
+                                     coin.GetTxOut().nValue, tx, i, flags,
+                                     sigCacheStore, txdata);
+            }
+            control.Add(vChecks);
+            CScriptCheck failedCheck;
+            if (!control.Wait(&failedCheck)) {
+                return InvalidScriptCheck(tx, state, inputs, failedCheck,
+                                          flags, sigCacheStore, txdata);
+            }
+            if (scriptCacheStore) {
+                AddKeyInScriptCache(hashCacheEntry);
+            }
+            return true;
+        }
+    }
+
     for (size_t i = 0; i < tx.vin.size(); i++) {
         const COutPoint &prevout = tx.vin[i].prevout;
         const Coin &coin = inputs.AccessCoin(prevout);
@@ -2285,34 +2447,8 @@ bool CheckInputs(const CTransaction &tx, CValidationState &state,
         if (pvChecks) {
             pvChecks->push_back(std::move(check));
         } else if (!check()) {
-            const bool hasNonMandatoryFlags =
-                (flags & STANDARD_NOT_MANDATORY_VERIFY_FLAGS) != 0;
-            if (hasNonMandatoryFlags) {
-                // Check whether the failure was caused by a non-mandatory
-                // script verification check, such as non-standard DER encodings
-                // or non-null dummy arguments; if so, don't trigger DoS
-                // protection to avoid splitting the network between upgraded
-                // and non-upgraded nodes.
-                CScriptCheck check2(
-                    scriptPubKey, amount, tx, i,
-                    (flags & ~STANDARD_NOT_MANDATORY_VERIFY_FLAGS),
-                    sigCacheStore, txdata);
-                if (check2()) {
-                    return state.Invalid(false, REJECT_NONSTANDARD,
-                            strprintf("non-mandatory-script-verify-flag (%s)", ScriptErrorString(check.GetScriptError())));
-                }
-            }
-
-            // Failures of other flags indicate a transaction that is invalid in
-            // new blocks, e.g. a invalid P2SH. We DoS ban such nodes as they
-            // are not following the protocol. That said during an upgrade
-            // careful thought should be taken as to the correct behavior - we
-            // may want to continue peering with non-upgraded nodes even after
-            // soft-fork super-majority signaling has occurred.
-            return state.DoS(
-                100, false, REJECT_INVALID,
-                strprintf("mandatory-script-verify-flag-failed (%s)",
-                          ScriptErrorString(check.GetScriptError())));
+            return InvalidScriptCheck(tx, state, inputs, check, flags,
+                                      sigCacheStore, txdata);
         }
     }
 
@@ -2327,32 +2463,30 @@ bool CheckInputs(const CTransaction &tx, CValidationState &state,
 
 namespace {
 
-bool UndoWriteToDisk(const CBlockUndo &blockundo, CDiskBlockPos &pos,
+// Write undo data serialized after room for the index header, so that it isn't
+// serialized again for its size and checksum.
+bool UndoWriteToDisk(std::vector<uint8_t> &&undoData, CDiskBlockPos &pos,
                      const uint256 &hashBlock,
                      const CMessageHeader::MessageMagic &messageStart) {
-    // Open history file to append
-    CAutoFile fileout(CDiskFiles::OpenUndoFile(pos), SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull()) {
-        return error("%s: OpenUndoFile failed", __func__);
-    }
-
-    // Write index header
-    unsigned int nSize = GetSerializeSize(fileout, blockundo);
-    fileout << FLATDATA(messageStart) << nSize;
+    unsigned int nSize = undoData.size() - BLOCKFILE_BLOCK_HEADER_SIZE;
 
-    // Write undo data
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0) {
-        return error("%s: ftell failed", __func__);
-    }
-    pos.nPos = (unsigned int)fileOutPos;
-    fileout << blockundo;
-
-    // calculate & write checksum
+    // calculate checksum
     CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
     hasher << hashBlock;
-    hasher << blockundo;
-    fileout << hasher.GetHash();
+    hasher.write(reinterpret_cast<const char *>(undoData.data()) +
+                     BLOCKFILE_BLOCK_HEADER_SIZE, nSize);
+
+    // Write index header and checksum
+    CVectorWriter{SER_DISK, CLIENT_VERSION, undoData, 0, FLATDATA(messageStart), nSize};
+    CVectorWriter{SER_DISK, CLIENT_VERSION, undoData, undoData.size(), hasher.GetHash()};
+
+    // The data is written in the background; reads of the file wait for it
+    CDiskBlockPos writePos { pos };
+    pos.nPos += BLOCKFILE_BLOCK_HEADER_SIZE;
+    if (!pBlockFileInfoStore->WriteBlockFileData(BlockFileType::UNDO, writePos,
+            std::move(undoData))) {
+        return error("%s: writing undo file failed", __func__);
+    }
 
     return true;
 }
@@ -2527,14 +2661,6 @@ DisconnectResult ApplyBlockUndo(const CBlockUndo &blockUndo,
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
-
-void ThreadScriptCheck(int workerNum) {
-    std::string s = strprintf("bitcoin-scriptch%d", workerNum);
-    RenameThread(s.c_str());
-    scriptcheckqueue.Thread();
-}
-
 // Returns the script flags which should be checked for a given block
 static uint32_t GetBlockScriptFlags(const Config &config,
                                     const CBlockIndex *pChainTip) {
@@ -2825,7 +2951,7 @@ static bool ConnectBlock(const Config &config, const CBlock &block,
                     pindex->nHeight);
 
         vPos.push_back(std::make_pair(tx.GetId(), pos));
-        pos.nTxOffset += ::GetSerializeSize(tx, SER_DISK, CLIENT_VERSION);
+        pos.nTxOffset += tx.GetTotalSize();
     }
 
     int64_t nTime3 = GetTimeMicros();
@@ -2869,13 +2995,15 @@ static bool ConnectBlock(const Config &config, const CBlock &block,
         !pindex->IsValid(BlockValidity::SCRIPTS)) {
         if (pindex->GetUndoPos().IsNull()) {
             CDiskBlockPos _pos;
+            std::vector<uint8_t> undoData(BLOCKFILE_BLOCK_HEADER_SIZE);
+            CVectorWriter{SER_DISK, CLIENT_VERSION, undoData,
+                          BLOCKFILE_BLOCK_HEADER_SIZE, blockundo};
             if (!pBlockFileInfoStore->FindUndoPos(
-                    state, pindex->nFile, _pos,
-                    ::GetSerializeSize(blockundo, SER_DISK, CLIENT_VERSION) +
-                        40, fCheckForPruning)) {
+                    state, pindex->nFile, _pos, undoData.size() + 32,
+                    fCheckForPruning)) {
                 return error("ConnectBlock(): FindUndoPos failed");
             }
-            if (!UndoWriteToDisk(blockundo, _pos, pindex->pprev->GetBlockHash(),
+            if (!UndoWriteToDisk(std::move(undoData), _pos, pindex->pprev->GetBlockHash(),
                                  config.GetChainParams().DiskMagic())) {
                 return AbortNode(state, "Failed to write undo data");
             }
@@ -2995,7 +3123,9 @@ bool FlushStateToDisk(
                     return state.Error("out of disk space");
                 }
                 // First make sure all block and undo data is flushed to disk.
-                pBlockFileInfoStore->FlushBlockFile();
+                if (!pBlockFileInfoStore->FlushBlockFile()) {
+                    return AbortNode(state, "Failed to write block files");
+                }
                 // Then update all block file information (which may refer to
                 // block and undo files).
                 {
@@ -4698,10 +4828,16 @@ FILE *CDiskFiles::OpenDiskFile(const CDiskBlockPos &pos, const char *prefix,
 }
 
 FILE *CDiskFiles::OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly) {
+    if (fReadOnly && !pos.IsNull()) {
+        pBlockFileInfoStore->WaitForPendingWrites(BlockFileType::BLOCK, pos.nFile);
+    }
     return OpenDiskFile(pos, "blk", fReadOnly);
 }
 
 FILE *CDiskFiles::OpenUndoFile(const CDiskBlockPos &pos, bool fReadOnly) {
+    if (fReadOnly && !pos.IsNull()) {
+        pBlockFileInfoStore->WaitForPendingWrites(BlockFileType::UNDO, pos.nFile);
+    }
     return OpenDiskFile(pos, "rev", fReadOnly);
 }
 
@@ -4709,6 +4845,71 @@ fs::path GetBlockPosFilename(const CDiskBlockPos &pos, const char *prefix) {
     return GetDataDir() / "blocks" / strprintf("%s%05u.dat", prefix, pos.nFile);
 }
 
+namespace {
+/**
+ * Storage for the block index entries loaded from disk at startup.
+ *
+ * Entries are allocated in large contiguous chunks rather than one by one,
+ * which makes loading a big block index faster and keeps it compact in memory.
+ * Entries added afterwards by AddToBlockIndex() are still allocated
+ * individually, so code releasing mapBlockIndex must check Owns() before
+ * deleting an entry.
+ */
+class CBlockIndexArena {
+public:
+    CBlockIndex *Allocate() {
+        if (chunks.empty() || usedInLastChunk == CHUNK_SIZE) {
+            chunks.emplace_back(std::make_unique<CBlockIndex[]>(CHUNK_SIZE));
+            usedInLastChunk = 0;
+            const CBlockIndex *begin { chunks.back().get() };
+            chunkBegins.insert(std::upper_bound(chunkBegins.begin(),
+                                                chunkBegins.end(), begin,
+                                                std::less<const CBlockIndex *>{}),
+                               begin);
+        }
+        return &chunks.back()[usedInLastChunk++];
+    }
+
+    bool Owns(const CBlockIndex *pindex) const {
+        // Find the last chunk starting at or before the entry
+        const std::less<const CBlockIndex *> less {};
+        auto it = std::upper_bound(chunkBegins.begin(), chunkBegins.end(),
+                                   pindex, less);
+        if (it == chunkBegins.begin()) {
+            return false;
+        }
+        --it;
+        return less(pindex, *it + CHUNK_SIZE);
+    }
+
+    void Clear() {
+        chunks.clear();
+        chunkBegins.clear();
+        usedInLastChunk = 0;
+    }
+
+private:
+    static constexpr size_t CHUNK_SIZE = 16384;
+    std::vector<std::unique_ptr<CBlockIndex[]>> chunks;
+    //! Start addresses of the chunks, in address order
+    std::vector<const CBlockIndex *> chunkBegins;
+    size_t usedInLastChunk = 0;
+};
+
+CBlockIndexArena blockIndexArena;
+
+void DeleteBlockIndexEntries() {
+    for (const std::pair<const uint256, CBlockIndex *> &entry :
+         mapBlockIndex) {
+        if (!blockIndexArena.Owns(entry.second)) {
+            delete entry.second;
+        }
+    }
+    mapBlockIndex.clear();
+    blockIndexArena.Clear();
+}
+} // namespace
+
 CBlockIndex *InsertBlockIndex(uint256 hash) {
     if (hash.IsNull()) {
         return nullptr;
@@ -4721,11 +4922,7 @@ CBlockIndex *InsertBlockIndex(uint256 hash) {
     }
 
     // Create new
-    CBlockIndex *pindexNew = new CBlockIndex();
-    if (!pindexNew) {
-        throw std::runtime_error(std::string(__func__) +
-                                 ": new CBlockIndex failed");
-    }
+    CBlockIndex *pindexNew = blockIndexArena.Allocate();
 
     mi = mapBlockIndex.insert(std::make_pair(hash, pindexNew)).first;
     pindexNew->phashBlock = &((*mi).first);
@@ -4734,13 +4931,32 @@ CBlockIndex *InsertBlockIndex(uint256 hash) {
 }
 
 
+static fs::path GetBlockIndexSnapshotPath() {
+    return GetDataDir() / "blocks" / "index.snapshot";
+}
+
 static bool LoadBlockIndexDB(const CChainParams &chainparams) {
-    if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndex)) {
+    int64_t nStart = GetTimeMillis();
+    bool fFromSnapshot = false;
+    if (gArgs.GetBoolArg("-blockindexsnapshot", DEFAULT_BLOCK_INDEX_SNAPSHOT)) {
+        fFromSnapshot = pblocktree->LoadBlockIndexSnapshot(
+            GetBlockIndexSnapshotPath(), InsertBlockIndex);
+        if (!fFromSnapshot) {
+            // Discard anything loaded before the snapshot was found unusable
+            DeleteBlockIndexEntries();
+        }
+    }
+    if (!fFromSnapshot && !pblocktree->LoadBlockIndexGuts(InsertBlockIndex)) {
         return false;
     }
+    LogPrintf("%s: loaded %d block index entries from %s in %dms\n", __func__,
+              mapBlockIndex.size(), fFromSnapshot ? "snapshot" : "database",
+              GetTimeMillis() - nStart);
 
     boost::this_thread::interruption_point();
 
+    nStart = GetTimeMillis();
+
     // Calculate nChainWork
     std::vector<std::pair<int, CBlockIndex *>> vSortedByHeight;
     vSortedByHeight.reserve(mapBlockIndex.size());
@@ -4790,7 +5006,11 @@ static bool LoadBlockIndexDB(const CChainParams &chainparams) {
         }
     }
 
+    LogPrintf("%s: computed chain work and skip pointers in %dms\n",
+              __func__, GetTimeMillis() - nStart);
+
     // Load block file info
+    nStart = GetTimeMillis();
     int nLastBlockFileLocal = 0;
     pblocktree->ReadLastBlockFile(nLastBlockFileLocal);
     pBlockFileInfoStore->LoadBlockFileInfo(nLastBlockFileLocal, *pblocktree);
@@ -4812,6 +5032,9 @@ static bool LoadBlockIndexDB(const CChainParams &chainparams) {
         }
     }
 
+    LogPrintf("%s: loaded block file info in %dms\n", __func__,
+              GetTimeMillis() - nStart);
+
     // Check whether we have ever pruned block & undo files
     pblocktree->ReadFlag("prunedblockfiles", fHavePruned);
     if (fHavePruned) {
@@ -5205,10 +5428,7 @@ void UnloadBlockIndex() {
     nBlockSequenceId = 1;
     setDirtyBlockIndex.clear();
 
-    for (BlockMap::value_type &entry : mapBlockIndex) {
-        delete entry.second;
-    }
-    mapBlockIndex.clear();
+    DeleteBlockIndexEntries();
     fHavePruned = false;
 }
 
@@ -5770,7 +5990,51 @@ CBlockFileInfo *GetBlockFileInfo(size_t n) {
     return pBlockFileInfoStore->GetBlockFileInfo(n);
 }
 
-static const uint64_t MEMPOOL_DUMP_VERSION = 1;
+// Version 1 stores (tx, nTime, nFeeDelta) per entry, version 2 additionally
+// stores the fee and the serialized size the entry had in the mempool.
+static const uint64_t MEMPOOL_DUMP_VERSION_NO_FEES = 1;
+static const uint64_t MEMPOOL_DUMP_VERSION = 2;
+
+namespace {
+    /** Mempool load statistics */
+    struct CMempoolLoadStats {
+        int64_t count {0};
+        int64_t failed {0};
+    };
+
+    /**
+     * Split the txns read from mempool.dat into waves of txns which don't
+     * depend on each other, in a single pass.
+     *
+     * The dump is topologically ordered, so a parent always precedes its
+     * children and a txn's wave is one after the latest wave of any of its
+     * parents from the dump. Parents which aren't in the dump are already in
+     * the mempool or the UTXO set and don't hold a txn back.
+     */
+    std::vector<TxInputDataSPtrVec> SplitMempoolDumpIntoWaves(
+        TxInputDataSPtrVec&& vTxInputData) {
+
+        std::unordered_map<TxId, size_t, SaltedTxidHasher> mapWave {};
+        mapWave.reserve(vTxInputData.size());
+        std::vector<TxInputDataSPtrVec> vWaves {};
+        for (auto& txInputData : vTxInputData) {
+            const CTransaction& tx { *txInputData->mpTx };
+            size_t nWave {0};
+            for (const CTxIn& txin : tx.vin) {
+                const auto parent { mapWave.find(txin.prevout.GetTxId()) };
+                if (parent != mapWave.end()) {
+                    nWave = std::max(nWave, parent->second + 1);
+                }
+            }
+            mapWave.emplace(tx.GetId(), nWave);
+            if (nWave == vWaves.size()) {
+                vWaves.emplace_back();
+            }
+            vWaves[nWave].emplace_back(std::move(txInputData));
+        }
+        return vWaves;
+    }
+}
 
 bool LoadMempool(const Config &config) {
     int64_t nExpiryTimeout =
@@ -5783,15 +6047,18 @@ bool LoadMempool(const Config &config) {
         return false;
     }
 
-    int64_t count = 0;
+    // Free txns of at least this size are always rejected (see CheckLimitFreeTx)
+    const uint64_t nLimitFreeRelayBytes =
+        gArgs.GetArg("-limitfreerelay", DEFAULT_LIMITFREERELAY) * 10 * 1000;
+    CMempoolLoadStats stats {};
     int64_t skipped = 0;
-    int64_t failed = 0;
     int64_t nNow = GetTime();
 
     try {
         uint64_t version;
         file >> version;
-        if (version != MEMPOOL_DUMP_VERSION) {
+        if (version != MEMPOOL_DUMP_VERSION &&
+            version != MEMPOOL_DUMP_VERSION_NO_FEES) {
             return false;
         }
         uint64_t num;
@@ -5799,6 +6066,8 @@ bool LoadMempool(const Config &config) {
         double prioritydummy = 0;
         // Take a reference to the validator.
         const auto& txValidator = g_connman->getTxnValidator();
+        // All txns are read first, then validated in parallel in waves.
+        TxInputDataSPtrVec vTxInputData {};
         while (num--) {
             CTransactionRef tx;
             int64_t nTime;
@@ -5806,41 +6075,86 @@ bool LoadMempool(const Config &config) {
             file >> tx;
             file >> nTime;
             file >> nFeeDelta;
+            uint64_t nTxSize { tx->GetTotalSize() };
+            bool fBelowMinFee { false };
+            if (version == MEMPOOL_DUMP_VERSION) {
+                int64_t nFee;
+                file >> nFee;
+                file >> nTxSize;
+                if (nTxSize != tx->GetTotalSize()) {
+                    throw std::runtime_error("txn size mismatch");
+                }
+                // The fee only depends on the txn and the outputs it spends,
+                // so an entry whose fee can't pass the free txn limit would be
+                // rejected anyway and doesn't need to be validated again.
+                fBelowMinFee =
+                    Amount(nFee + nFeeDelta) <
+                        config.GetMinFeePerKB().GetFee(nTxSize) &&
+                    nTxSize >= nLimitFreeRelayBytes;
+            }
             Amount amountdelta(nFeeDelta);
             if (amountdelta != Amount(0)) {
                 mempool.PrioritiseTransaction(tx->GetId(),
                                               tx->GetId().ToString(),
                                               prioritydummy, amountdelta);
             }
-            if (nTime + nExpiryTimeout > nNow) {
-                // Mempool Journal ChangeSet
-                CJournalChangeSetPtr changeSet {
-                    mempool.getJournalBuilder()->getNewChangeSet(JournalUpdateReason::INIT)
-                };
-                const CValidationState& state {
-                    // Execute txn validation synchronously.
-                    txValidator->processValidation(
-                                        std::make_shared<CTxInputData>(
-                                                            TxSource::file, // tx source
-                                                            tx,    // a pointer to the tx
-                                                            nTime, // nAcceptTime
-                                                            true),  // fLimitFree
-                                        changeSet, // an instance of the mempool journal
-                                        true) // fLimitMempoolSize
-                };
-                // Check results
+            if (nTime + nExpiryTimeout <= nNow) {
+                ++skipped;
+            } else if (fBelowMinFee) {
+                ++stats.failed;
+            } else {
+                vTxInputData.emplace_back(
+                    std::make_shared<CTxInputData>(
+                                        TxSource::file, // tx source
+                                        tx,    // a pointer to the tx
+                                        nTime, // nAcceptTime
+                                        true));  // fLimitFree
+            }
+            if (ShutdownRequested()) {
+                return false;
+            }
+        }
+        for (TxInputDataSPtrVec& vWave :
+                SplitMempoolDumpIntoWaves(std::move(vTxInputData))) {
+            // Mempool Journal ChangeSet
+            CJournalChangeSetPtr changeSet {
+                mempool.getJournalBuilder()->getNewChangeSet(JournalUpdateReason::INIT)
+            };
+            const std::vector<CValidationState> vStates {
+                // Execute txn validation synchronously.
+                txValidator->processValidation(vWave, changeSet)
+            };
+            for (const CValidationState& state : vStates) {
                 if (state.IsValid()) {
-                    ++count;
+                    ++stats.count;
                 } else {
-                    ++failed;
+                    ++stats.failed;
                 }
-            } else {
-                ++skipped;
             }
             if (ShutdownRequested()) {
                 return false;
             }
         }
+        // Trim the mempool and bring the coins cache back within its limits
+        // once, now that all txns have been submitted.
+        {
+            LOCK(cs_main);
+            CJournalChangeSetPtr changeSet {
+                mempool.getJournalBuilder()->getNewChangeSet(JournalUpdateReason::INIT)
+            };
+            const std::vector<TxId> vRemovedTxIds {
+                LimitMempoolSize(
+                    mempool,
+                    changeSet,
+                    gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000,
+                    nExpiryTimeout)
+            };
+            stats.count -= vRemovedTxIds.size();
+            stats.failed += vRemovedTxIds.size();
+            CValidationState dummyState;
+            FlushStateToDisk(config.GetChainParams(), dummyState,
+                             FLUSH_STATE_PERIODIC);
+        }
         std::map<uint256, Amount> mapDeltas;
         file >> mapDeltas;
 
@@ -5857,7 +6171,7 @@ bool LoadMempool(const Config &config) {
 
     LogPrintf("Imported mempool transactions from disk: %i successes, %i "
               "failed, %i expired\n",
-              count, failed, skipped);
+              stats.count, stats.failed, skipped);
     return true;
 }
 
@@ -5893,6 +6207,8 @@ void DumpMempool(void) {
             file << *(i.tx);
             file << (int64_t)i.nTime;
             file << (int64_t)i.nFeeDelta.GetSatoshis();
+            file << (int64_t)i.nFee.GetSatoshis();
+            file << (uint64_t)i.nTxSize;
             mapDeltas.erase(i.tx->GetId());
         }
 
@@ -5909,6 +6225,32 @@ void DumpMempool(void) {
     }
 }
 
+bool DumpBlockIndexSnapshot() {
+    int64_t nStart = GetTimeMillis();
+
+    // Hold cs_main throughout so the index can't change while it is written
+    LOCK(cs_main);
+    if (pblocktree == nullptr || fReindex || !setDirtyBlockIndex.empty()) {
+        LogPrintf("%s: block index not flushed, not writing a snapshot\n",
+                  __func__);
+        return false;
+    }
+
+    std::vector<const CBlockIndex *> vEntries;
+    vEntries.reserve(mapBlockIndex.size());
+    for (const std::pair<const uint256, CBlockIndex *> &item : mapBlockIndex) {
+        vEntries.push_back(item.second);
+    }
+    if (!pblocktree->WriteBlockIndexSnapshot(GetBlockIndexSnapshotPath(),
+                                             vEntries)) {
+        return false;
+    }
+
+    LogPrintf("%s: wrote %d block index entries in %dms\n", __func__,
+              vEntries.size(), GetTimeMillis() - nStart);
+    return true;
+}
+
 //! Guess how far we are in the verification process at the given block index
 double GuessVerificationProgress(const ChainTxData &data, CBlockIndex *pindex) {
     if (pindex == nullptr) {
@@ -5933,10 +6275,6 @@ public:
     CMainCleanup() {}
     ~CMainCleanup() {
         // block headers
-        for (const std::pair<const uint256, CBlockIndex *> &it :
-             mapBlockIndex) {
-            delete it.second;
-        }
-        mapBlockIndex.clear();
+        DeleteBlockIndexEntries();
     }
 } instance_of_cmaincleanup;
@@ -104,6 +104,11 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/**
+ * Default for -parallelscriptcheckinputs, the input count from which a mempool
+ * transaction's scripts are checked by all script-checking threads
+ */
+static const unsigned int DEFAULT_PARALLEL_SCRIPTCHECK_INPUTS = 1000;
 /** Number of blocks that can be requested at any given time from a single peer.
  */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
@@ -192,6 +197,8 @@ static const unsigned int DEFAULT_INVALID_HEADER_FREQUENCY = 2000;
 
 /** Default for -persistmempool */
 static const bool DEFAULT_PERSIST_MEMPOOL = true;
+/** Default for -blockindexsnapshot */
+static const bool DEFAULT_BLOCK_INDEX_SNAPSHOT = true;
 /** Default for using fee filter */
 static const bool DEFAULT_FEEFILTER = true;
 
@@ -220,6 +227,7 @@ extern CConditionVariable cvBlockChange;
 extern std::atomic_bool fImporting;
 extern bool fReindex;
 extern int nScriptCheckThreads;
+extern unsigned int nParallelScriptCheckInputs;
 extern bool fTxIndex;
 extern bool fIsBareMultisigStd;
 extern bool fRequireStandard;
@@ -418,6 +426,8 @@ void UnloadBlockIndex();
  * Run an instance of the script checking thread.
  */
 void ThreadScriptCheck(int workerNum);
+/** Run a worker thread for the script checks of standalone transactions */
+void ThreadMempoolScriptCheck(int workerNum);
 
 /**
  * Check whether we are doing an initial block download (synchronizing from disk
@@ -443,6 +453,15 @@ std::string GetWarnings(const std::string &strFor);
 bool GetTransaction(const Config &config, const TxId &txid, CTransactionRef &tx,
                     uint256 &hashBlock, bool fAllowSlow = false);
 
+/**
+ * Retrieve several transactions from the memory pool or the txindex without
+ * holding cs_main. Txns found in the txindex are read in disk order. A txn
+ * that isn't found is returned as nullptr with a null block hash.
+ */
+void GetTransactions(const std::vector<TxId> &vTxIds,
+                     std::vector<CTransactionRef> &vTxOut,
+                     std::vector<uint256> &vHashBlock);
+
 /**
  * Find the best known block, and make it the active tip of the block chain.
  * If it fails, the tip is not updated.
@@ -751,6 +770,7 @@ public:
     }
 
     ScriptError GetScriptError() const { return error; }
+    unsigned int GetInputIndex() const { return nIn; }
 };
 
 /** Functions for disk access for blocks */
@@ -763,7 +783,7 @@ std::unique_ptr<CBlockStreamReader<CFileReader>> GetDiskBlockStreamReader(
 std::unique_ptr<CForwardAsyncReadonlyStream> StreamBlockFromDisk(
     CBlockIndex& index,
     int networkVersion);
-std::unique_ptr<CForwardReadonlyStream> StreamSyncBlockFromDisk(CBlockIndex& index);
+std::unique_ptr<CForwardReadonlyStream> StreamSyncBlockFromDisk(const CBlockIndex& index);
 void SetBlockIndexFileMetaDataIfNotSet(CBlockIndex& index, CDiskBlockMetaData metadata);
 /** Functions for validating blocks and updating the block tree */
 
@@ -899,4 +919,10 @@ void DumpMempool();
 /** Load the mempool from disk. */
 bool LoadMempool(const Config &config);
 
+/**
+ * Write a snapshot of the block index to speed up the next start. Must be
+ * called after the block index has been flushed to disk.
+ */
+bool DumpBlockIndexSnapshot();
+
 #endif // BITCOIN_VALIDATION_H
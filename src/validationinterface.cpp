@@ -4,6 +4,15 @@
 // Distributed under the Open BSV software license, see the accompanying file LICENSE.
 
 #include "validationinterface.h"
+#include "util.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 static CMainSignals g_signals;
 
@@ -11,33 +20,173 @@ CMainSignals &GetMainSignals() {
     return g_signals;
 }
 
+namespace {
+
+/**
+ * A queue of notifications for one asynchronous subscriber.
+ *
+ * Notifications are pushed by the validating threads and delivered in order
+ * by a dedicated thread. If the subscriber falls more than maxSize
+ * notifications behind, the oldest pending notification is dropped rather than
+ * blocking the producer, which may be holding locks the subscriber needs.
+ */
+class CValidationNotificationQueue {
+public:
+    explicit CValidationNotificationQueue(size_t maxSize)
+        : mMaxSize{maxSize} {
+        mThread = std::thread(&CValidationNotificationQueue::Run, this);
+    }
+
+    ~CValidationNotificationQueue() { Stop(); }
+
+    CValidationNotificationQueue(const CValidationNotificationQueue &) = delete;
+    CValidationNotificationQueue &operator=(const CValidationNotificationQueue &) = delete;
+
+    // Deliver all pending notifications and stop the delivery thread
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock { mMtx };
+            mRunning = false;
+        }
+        mCV.notify_one();
+        if (mThread.joinable()) {
+            mThread.join();
+        }
+    }
+
+    void Push(std::function<void()> notification) {
+        {
+            std::lock_guard<std::mutex> lock { mMtx };
+            if (!mRunning) {
+                return;
+            }
+            if (mQueue.size() >= mMaxSize) {
+                mQueue.pop_front();
+                ++mDropped;
+            }
+            mQueue.emplace_back(std::move(notification));
+        }
+        mCV.notify_one();
+    }
+
+    void AddStats(CValidationInterfaceQueueStats &stats) const {
+        std::lock_guard<std::mutex> lock { mMtx };
+        stats.nQueued += mQueue.size();
+        stats.nDropped += mDropped;
+    }
+
+private:
+    void Run() {
+        RenameThread("bitcoin-valnotify");
+        std::unique_lock<std::mutex> lock { mMtx };
+        while (true) {
+            mCV.wait(lock, [this] { return !mQueue.empty() || !mRunning; });
+            if (mQueue.empty()) {
+                return;
+            }
+            std::function<void()> notification { std::move(mQueue.front()) };
+            mQueue.pop_front();
+            lock.unlock();
+            try {
+                notification();
+            } catch (const std::exception &e) {
+                LogPrintf("Validation notification failed: %s\n", e.what());
+            }
+            lock.lock();
+        }
+    }
+
+    const size_t mMaxSize;
+    mutable std::mutex mMtx {};
+    std::condition_variable mCV {};
+    std::deque<std::function<void()>> mQueue {};
+    uint64_t mDropped {0};
+    bool mRunning {true};
+    std::thread mThread {};
+};
+
+/** Signal connections (and the queue, if asynchronous) of one subscriber */
+struct CValidationSubscriber {
+    std::vector<boost::signals2::scoped_connection> connections {};
+    std::shared_ptr<CValidationNotificationQueue> queue {};
+};
+
+std::mutex g_subscribersMtx;
+std::map<CValidationInterface *, CValidationSubscriber> g_subscribers;
+
+} // namespace
+
 void RegisterValidationInterface(CValidationInterface *pwalletIn) {
-    g_signals.UpdatedBlockTip.connect(boost::bind( &CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
-    g_signals.TransactionAddedToMempool.connect(boost::bind( &CValidationInterface::TransactionAddedToMempool, pwalletIn, _1));
-    g_signals.BlockConnected.connect(boost::bind( &CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3));
-    g_signals.BlockDisconnected.connect( boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1));
-    g_signals.SetBestChain.connect( boost::bind(&CValidationInterface::SetBestChain, pwalletIn, _1));
-    g_signals.Inventory.connect( boost::bind(&CValidationInterface::Inventory, pwalletIn, _1));
-    g_signals.Broadcast.connect(boost::bind( &CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
-    g_signals.BlockChecked.connect( boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
-    g_signals.ScriptForMining.connect(boost::bind(&CValidationInterface::GetScriptForMining, pwalletIn, _1));
-    g_signals.NewPoWValidBlock.connect(boost::bind( &CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
+    std::lock_guard<std::mutex> lock { g_subscribersMtx };
+    CValidationSubscriber &subscriber { g_subscribers[pwalletIn] };
+    std::vector<boost::signals2::scoped_connection> &conns { subscriber.connections };
+
+    if (pwalletIn->IsSynchronous()) {
+        conns.emplace_back(g_signals.UpdatedBlockTip.connect(boost::bind( &CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3)));
+        conns.emplace_back(g_signals.TransactionAddedToMempool.connect(boost::bind( &CValidationInterface::TransactionAddedToMempool, pwalletIn, _1)));
+        conns.emplace_back(g_signals.BlockConnected.connect(boost::bind( &CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3)));
+        conns.emplace_back(g_signals.BlockDisconnected.connect( boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1)));
+    } else {
+        // The slots share the queue, so it outlives a notification that is
+        // being pushed while the subscriber is unregistered.
+        subscriber.queue = std::make_shared<CValidationNotificationQueue>(DEFAULT_VALIDATION_QUEUE_MAX_SIZE);
+        std::shared_ptr<CValidationNotificationQueue> queue { subscriber.queue };
+        conns.emplace_back(g_signals.UpdatedBlockTip.connect(
+            [pwalletIn, queue](const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) {
+                queue->Push([=] { pwalletIn->UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload); });
+            }));
+        conns.emplace_back(g_signals.TransactionAddedToMempool.connect(
+            [pwalletIn, queue](const CTransactionRef &ptx) {
+                queue->Push([=] { pwalletIn->TransactionAddedToMempool(ptx); });
+            }));
+        conns.emplace_back(g_signals.BlockConnected.connect(
+            [pwalletIn, queue](const std::shared_ptr<const CBlock> &block, const CBlockIndex *pindex, const std::vector<CTransactionRef> &txnConflicted) {
+                queue->Push([=] { pwalletIn->BlockConnected(block, pindex, txnConflicted); });
+            }));
+        conns.emplace_back(g_signals.BlockDisconnected.connect(
+            [pwalletIn, queue](const std::shared_ptr<const CBlock> &block) {
+                queue->Push([=] { pwalletIn->BlockDisconnected(block); });
+            }));
+    }
+    conns.emplace_back(g_signals.SetBestChain.connect( boost::bind(&CValidationInterface::SetBestChain, pwalletIn, _1)));
+    conns.emplace_back(g_signals.Inventory.connect( boost::bind(&CValidationInterface::Inventory, pwalletIn, _1)));
+    conns.emplace_back(g_signals.Broadcast.connect(boost::bind( &CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2)));
+    conns.emplace_back(g_signals.BlockChecked.connect( boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2)));
+    conns.emplace_back(g_signals.ScriptForMining.connect(boost::bind(&CValidationInterface::GetScriptForMining, pwalletIn, _1)));
+    conns.emplace_back(g_signals.NewPoWValidBlock.connect(boost::bind( &CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2)));
 }
 
 void UnregisterValidationInterface(CValidationInterface *pwalletIn) {
-    g_signals.ScriptForMining.disconnect(boost::bind(&CValidationInterface::GetScriptForMining, pwalletIn, _1));
-    g_signals.BlockChecked.disconnect( boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
-    g_signals.Broadcast.disconnect(boost::bind( &CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
-    g_signals.Inventory.disconnect( boost::bind(&CValidationInterface::Inventory, pwalletIn, _1));
-    g_signals.SetBestChain.disconnect( boost::bind(&CValidationInterface::SetBestChain, pwalletIn, _1));
-    g_signals.TransactionAddedToMempool.disconnect(boost::bind( &CValidationInterface::TransactionAddedToMempool, pwalletIn, _1));
-    g_signals.BlockConnected.disconnect(boost::bind( &CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3));
-    g_signals.BlockDisconnected.disconnect( boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1));
-    g_signals.UpdatedBlockTip.disconnect(boost::bind( &CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
-    g_signals.NewPoWValidBlock.disconnect(boost::bind( &CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
+    CValidationSubscriber subscriber {};
+    {
+        std::lock_guard<std::mutex> lock { g_subscribersMtx };
+        auto it = g_subscribers.find(pwalletIn);
+        if (it == g_subscribers.end()) {
+            return;
+        }
+        subscriber = std::move(it->second);
+        g_subscribers.erase(it);
+    }
+    // Disconnect first, then deliver whatever is still queued so the
+    // subscriber can be destroyed once we return.
+    subscriber.connections.clear();
+    if (subscriber.queue) {
+        subscriber.queue->Stop();
+    }
 }
 
 void UnregisterAllValidationInterfaces() {
+    std::map<CValidationInterface *, CValidationSubscriber> subscribers {};
+    {
+        std::lock_guard<std::mutex> lock { g_subscribersMtx };
+        subscribers.swap(g_subscribers);
+    }
+    for (auto &subscriber : subscribers) {
+        subscriber.second.connections.clear();
+        if (subscriber.second.queue) {
+            subscriber.second.queue->Stop();
+        }
+    }
     g_signals.BlockChecked.disconnect_all_slots();
     g_signals.Broadcast.disconnect_all_slots();
     g_signals.Inventory.disconnect_all_slots();
@@ -49,3 +198,15 @@ void UnregisterAllValidationInterfaces() {
     g_signals.UpdatedBlockTip.disconnect_all_slots();
     g_signals.NewPoWValidBlock.disconnect_all_slots();
 }
+
+CValidationInterfaceQueueStats GetValidationInterfaceQueueStats() {
+    CValidationInterfaceQueueStats stats {};
+    std::lock_guard<std::mutex> lock { g_subscribersMtx };
+    for (const auto &subscriber : g_subscribers) {
+        if (subscriber.second.queue) {
+            ++stats.nAsyncSubscribers;
+            subscriber.second.queue->AddStats(stats);
+        }
+    }
+    return stats;
+}
@@ -10,6 +10,7 @@
 
 #include <boost/signals2/signal.hpp>
 
+#include <cstdint>
 #include <memory>
 
 class CBlock;
@@ -22,6 +23,22 @@ class CValidationInterface;
 class CValidationState;
 class uint256;
 
+/**
+ * Maximum number of notifications queued for an asynchronous subscriber. Once
+ * it is reached the oldest pending notification is dropped.
+ */
+static const size_t DEFAULT_VALIDATION_QUEUE_MAX_SIZE = 100000;
+
+/** Statistics of the queues of asynchronous subscribers */
+struct CValidationInterfaceQueueStats {
+    /** Number of asynchronous subscribers */
+    size_t nAsyncSubscribers {0};
+    /** Notifications waiting to be delivered */
+    size_t nQueued {0};
+    /** Notifications dropped because a queue was full */
+    uint64_t nDropped {0};
+};
+
 // These functions dispatch to one or all registered wallets
 
 /** Register a wallet to receive updates from core */
@@ -30,9 +47,21 @@ void RegisterValidationInterface(CValidationInterface *pwalletIn);
 void UnregisterValidationInterface(CValidationInterface *pwalletIn);
 /** Unregister all wallets from core */
 void UnregisterAllValidationInterfaces();
+/** Get statistics of the notification queues */
+CValidationInterfaceQueueStats GetValidationInterfaceQueueStats();
 
 class CValidationInterface {
 protected:
+    /**
+     * Whether UpdatedBlockTip, TransactionAddedToMempool, BlockConnected and
+     * BlockDisconnected are called on the validating thread. Otherwise they
+     * are queued and called in order from a thread of the subscriber's own,
+     * and the oldest queued ones are dropped if the subscriber falls too far
+     * behind; only subscribers that can tolerate that should opt out.
+     * All other notifications are always synchronous.
+     */
+    virtual bool IsSynchronous() const { return true; }
+
     virtual void UpdatedBlockTip(const CBlockIndex *pindexNew,
                                  const CBlockIndex *pindexFork,
                                  bool fInitialDownload) {}
@@ -7,6 +7,8 @@
 #include "chainparams.h"
 #include "config.h"
 #include "rpc/server.h"
+#include "script/interpreter.h"
+#include "script/sighashtype.h"
 #include "test/test_bitcoin.h"
 #include "validation.h"
 #include "wallet/rpcdump.h"
@@ -532,6 +534,89 @@ BOOST_FIXTURE_TEST_CASE(rescan, TestChain100Setup) {
     }
 }
 
+// Spend the first output of a P2PK transaction paying to key
+static CMutableTransaction SignedSpend(const CTransaction &from,
+                                       const CKey &key,
+                                       const CScript &scriptPubKey) {
+    CMutableTransaction spend;
+    spend.vin.emplace_back(COutPoint(from.GetId(), 0));
+    spend.vout.emplace_back(from.vout[0].nValue, scriptPubKey);
+    std::vector<uint8_t> vchSig;
+    uint256 hash = SignatureHash(from.vout[0].scriptPubKey,
+                                 CTransaction(spend), 0,
+                                 SigHashType().withForkId(),
+                                 from.vout[0].nValue);
+    BOOST_CHECK(key.Sign(hash, vchSig));
+    vchSig.push_back(uint8_t(SIGHASH_ALL | SIGHASH_FORKID));
+    spend.vin[0].scriptSig = CScript() << vchSig;
+    return spend;
+}
+
+// Verify a rescan finds transactions that only spend from transactions it
+// found in earlier blocks of the same batch.
+BOOST_FIXTURE_TEST_CASE(rescan_finds_spends_of_new_txns, TestChain100Setup) {
+    LOCK(cs_main);
+    CKey walletKey;
+    walletKey.MakeNewKey(true);
+    const CScript minerScript = GetScriptForRawPubKey(coinbaseKey.GetPubKey());
+
+    // A block pays us, and a later one spends that payment elsewhere
+    CBlockIndex *pindexStart = chainActive.Tip();
+    const CMutableTransaction pay =
+        SignedSpend(coinbaseTxns[0], coinbaseKey,
+                    GetScriptForRawPubKey(walletKey.GetPubKey()));
+    CreateAndProcessBlock({pay}, minerScript);
+    CreateAndProcessBlock({}, minerScript);
+    const CMutableTransaction spend =
+        SignedSpend(CTransaction(pay), walletKey, CScript() << OP_TRUE);
+    CreateAndProcessBlock({spend}, minerScript);
+
+    CWallet wallet(Params());
+    LOCK(wallet.cs_wallet);
+    wallet.AddKeyPubKey(walletKey, walletKey.GetPubKey());
+    BOOST_CHECK_EQUAL(pindexStart,
+                      wallet.ScanForWalletTransactions(pindexStart));
+    BOOST_CHECK_EQUAL(wallet.mapWallet.size(), 2U);
+    BOOST_CHECK(wallet.GetWalletTx(pay.GetId()));
+    BOOST_CHECK(wallet.GetWalletTx(spend.GetId()));
+    BOOST_CHECK_EQUAL(wallet.GetBalance(), Amount(0));
+}
+
+// Verify a rescan marks a wallet transaction as conflicted by a block
+// transaction spending the same foreign output, although nothing in the block
+// is ours.
+BOOST_FIXTURE_TEST_CASE(rescan_conflicting_spend, TestChain100Setup) {
+    LOCK(cs_main);
+    CKey walletKey;
+    walletKey.MakeNewKey(true);
+    const CScript minerScript = GetScriptForRawPubKey(coinbaseKey.GetPubKey());
+
+    // A wallet transaction paying us out of a coin that isn't ours
+    CWallet wallet(Params());
+    const CMutableTransaction pay =
+        SignedSpend(coinbaseTxns[0], coinbaseKey,
+                    GetScriptForRawPubKey(walletKey.GetPubKey()));
+    {
+        LOCK(wallet.cs_wallet);
+        wallet.AddKeyPubKey(walletKey, walletKey.GetPubKey());
+        BOOST_CHECK(
+            wallet.AddToWallet(CWalletTx(&wallet, MakeTransactionRef(pay))));
+        BOOST_CHECK_EQUAL(wallet.mapWallet.at(pay.GetId()).GetDepthInMainChain(),
+                          0);
+    }
+
+    // A block spends the coin elsewhere instead
+    const CMutableTransaction conflict =
+        SignedSpend(coinbaseTxns[0], coinbaseKey, CScript() << OP_TRUE);
+    CreateAndProcessBlock({conflict}, minerScript);
+    CBlockIndex *tip = chainActive.Tip();
+
+    LOCK(wallet.cs_wallet);
+    BOOST_CHECK_EQUAL(tip, wallet.ScanForWalletTransactions(tip));
+    BOOST_CHECK_EQUAL(wallet.mapWallet.size(), 1U);
+    BOOST_CHECK(wallet.mapWallet.at(pay.GetId()).GetDepthInMainChain() < 0);
+}
+
 // Verify importwallet RPC starts rescan at earliest block with timestamp
 // greater or equal than key birthday. Previously there was a bug where
 // importwallet RPC would start the scan at the latest block with timestamp less
@@ -624,6 +709,53 @@ BOOST_FIXTURE_TEST_CASE(coin_mark_dirty_immature_credit, TestChain100Setup) {
     BOOST_CHECK_EQUAL(wtx.GetImmatureCredit(), 50 * COIN);
 }
 
+// Check that balances and available coins keep up with wallet transactions
+// spending each other's outputs and being abandoned, as they only look at
+// transactions that may still have unspent outputs.
+BOOST_FIXTURE_TEST_CASE(unspent_index_follows_spends, TestChain100Setup) {
+    CWallet wallet(Params());
+    LOCK2(cs_main, wallet.cs_wallet);
+    wallet.AddKeyPubKey(coinbaseKey, coinbaseKey.GetPubKey());
+    const CScript ours = GetScriptForRawPubKey(coinbaseKey.GetPubKey());
+
+    CMutableTransaction pay;
+    pay.vin.emplace_back(COutPoint(GetRandHash(), 0));
+    pay.vout.emplace_back(10 * COIN, ours);
+    pay.vout.emplace_back(20 * COIN, ours);
+    CWalletTx payWtx(&wallet, MakeTransactionRef(pay));
+    payWtx.SetMerkleBranch(chainActive.Tip(), 1);
+    BOOST_CHECK(wallet.AddToWallet(payWtx));
+
+    std::vector<COutput> coins;
+    wallet.AvailableCoins(coins);
+    BOOST_CHECK_EQUAL(coins.size(), 2U);
+    BOOST_CHECK_EQUAL(wallet.GetBalance(), 30 * COIN);
+
+    // Spending one of the outputs elsewhere leaves the other one.
+    CMutableTransaction spend;
+    spend.vin.emplace_back(COutPoint(payWtx.GetId(), 0));
+    spend.vout.emplace_back(10 * COIN, CScript() << OP_TRUE);
+    const CTransactionRef spendTx = MakeTransactionRef(spend);
+    wallet.TransactionAddedToMempool(spendTx);
+    wallet.AvailableCoins(coins);
+    BOOST_CHECK_EQUAL(coins.size(), 1U);
+    BOOST_CHECK_EQUAL(wallet.GetBalance(), 20 * COIN);
+
+    // Spending the other one too leaves nothing.
+    spend.vin[0].prevout = COutPoint(payWtx.GetId(), 1);
+    wallet.TransactionAddedToMempool(MakeTransactionRef(spend));
+    wallet.AvailableCoins(coins);
+    BOOST_CHECK(coins.empty());
+    BOOST_CHECK_EQUAL(wallet.GetBalance(), Amount(0));
+
+    // Abandoning the first spend makes its output available again.
+    BOOST_CHECK(wallet.AbandonTransaction(spendTx->GetId()));
+    wallet.AvailableCoins(coins);
+    BOOST_REQUIRE_EQUAL(coins.size(), 1U);
+    BOOST_CHECK_EQUAL(coins[0].i, 0);
+    BOOST_CHECK_EQUAL(wallet.GetBalance(), 10 * COIN);
+}
+
 static int64_t AddTx(CWallet &wallet, uint32_t lockTime, int64_t mockTime,
                      int64_t blockTime) {
     CMutableTransaction tx;
@@ -24,6 +24,7 @@
 #include "script/script.h"
 #include "script/sighashtype.h"
 #include "script/sign.h"
+#include "script/standard.h"
 #include "timedata.h"
 #include "txmempool.h"
 #include "txn_validator.h"
@@ -31,6 +32,7 @@
 #include "util.h"
 #include "utilmoneystr.h"
 #include "validation.h"
+#include "task_helpers.h"
 #include "wallet/coincontrol.h"
 #include "wallet/finaltx.h"
 
@@ -734,6 +736,54 @@ void CWallet::AddToSpends(const uint256 &wtxid) {
     }
 }
 
+void CWallet::UpdateUnspentIndex(const uint256 &hash) {
+    AssertLockHeld(cs_wallet);
+
+    std::map<uint256, CWalletTx>::const_iterator it = mapWallet.find(hash);
+    if (it == mapWallet.end()) {
+        mapUnspentTx.erase(hash);
+        return;
+    }
+
+    // Unlike IsSpent() this doesn't depend on the chain: an output spent by a
+    // wallet transaction that is neither abandoned nor conflicted stays spent
+    // until that transaction is abandoned or conflicted, and both of those
+    // update the index again.
+    const CWalletTx &wtx = it->second;
+    for (unsigned int i = 0; i < wtx.tx->vout.size(); i++) {
+        if (IsMine(wtx.tx->vout[i]) == ISMINE_NO) {
+            continue;
+        }
+
+        bool fSpent = false;
+        std::pair<TxSpends::const_iterator, TxSpends::const_iterator> range =
+            mapTxSpends.equal_range(COutPoint(hash, i));
+        for (TxSpends::const_iterator sit = range.first;
+             sit != range.second && !fSpent; ++sit) {
+            std::map<uint256, CWalletTx>::const_iterator mit =
+                mapWallet.find(sit->second);
+            fSpent = mit != mapWallet.end() && !mit->second.isAbandoned() &&
+                     !(mit->second.nIndex == -1 && !mit->second.hashUnset());
+        }
+
+        if (!fSpent) {
+            mapUnspentTx[hash] = &wtx;
+            return;
+        }
+    }
+
+    mapUnspentTx.erase(hash);
+}
+
+void CWallet::RebuildUnspentIndex() {
+    AssertLockHeld(cs_wallet);
+
+    mapUnspentTx.clear();
+    for (const std::pair<const uint256, CWalletTx> &item : mapWallet) {
+        UpdateUnspentIndex(item.first);
+    }
+}
+
 bool CWallet::EncryptWallet(const SecureString &strWalletPassphrase) {
     if (IsCrypted()) {
         return false;
@@ -1013,6 +1063,9 @@ void CWallet::MarkDirty() {
     for (std::pair<const uint256, CWalletTx> &item : mapWallet) {
         item.second.MarkDirty();
     }
+
+    // Outputs may have become ours since the index was last updated.
+    RebuildUnspentIndex();
 }
 
 bool CWallet::AddToWallet(const CWalletTx &wtxIn, bool fFlushOnClose) {
@@ -1073,6 +1126,13 @@ bool CWallet::AddToWallet(const CWalletTx &wtxIn, bool fFlushOnClose) {
     // Break debit/credit balance caches:
     wtx.MarkDirty();
 
+    // The transaction may have new outputs of ours and may spend or stop
+    // spending outputs of its wallet parents.
+    UpdateUnspentIndex(hash);
+    for (const CTxIn &txin : wtx.tx->vin) {
+        UpdateUnspentIndex(txin.prevout.GetTxId());
+    }
+
     // Notify UI of new or updated transaction.
     NotifyTransactionChanged(this, hash, fInsertedNew ? CT_NEW : CT_UPDATED);
 
@@ -1252,6 +1312,7 @@ bool CWallet::AbandonTransaction(const uint256 &hashTx) {
             for (const CTxIn &txin : wtx.tx->vin) {
                 if (mapWallet.count(txin.prevout.GetTxId())) {
                     mapWallet[txin.prevout.GetTxId()].MarkDirty();
+                    UpdateUnspentIndex(txin.prevout.GetTxId());
                 }
             }
         }
@@ -1317,6 +1378,7 @@ void CWallet::MarkConflicted(const uint256 &hashBlock, const uint256 &hashTx) {
             for (const CTxIn &txin : wtx.tx->vin) {
                 if (mapWallet.count(txin.prevout.GetTxId())) {
                     mapWallet[txin.prevout.GetTxId()].MarkDirty();
+                    UpdateUnspentIndex(txin.prevout.GetTxId());
                 }
             }
         }
@@ -1699,11 +1761,141 @@ void CWalletTx::GetAmounts(std::list<COutputEntry> &listReceived,
     }
 }
 
+/**
+ * What a rescan needs to know about the wallet to pick out, without holding any
+ * lock, every transaction that might involve it. It matches a superset of what
+ * AddToWalletIfInvolvingMe() accepts, which makes the final decision.
+ */
+struct CWalletScanFilter {
+    std::set<CKeyID> keys;
+    std::set<CScriptID> scripts;
+    std::set<CScript> watchOnly;
+    // Wallet transactions, to find transactions spending from the wallet
+    std::set<uint256> txids;
+    // Outputs spent by wallet transactions, to find transactions conflicting
+    // with them
+    std::set<COutPoint> spends;
+
+    bool IsKnownTx(const uint256 &txid,
+                   const std::set<uint256> &extraTxids) const {
+        return txids.count(txid) || extraTxids.count(txid);
+    }
+
+    bool MightBeMine(const CScript &scriptPubKey) const {
+        if (!watchOnly.empty() && watchOnly.count(scriptPubKey)) {
+            return true;
+        }
+        std::vector<std::vector<uint8_t>> vSolutions;
+        txnouttype whichType;
+        if (!Solver(scriptPubKey, whichType, vSolutions)) {
+            return false;
+        }
+        switch (whichType) {
+            case TX_PUBKEY:
+                return keys.count(CPubKey(vSolutions[0]).GetID()) != 0;
+            case TX_PUBKEYHASH:
+                return keys.count(CKeyID(uint160(vSolutions[0]))) != 0;
+            case TX_SCRIPTHASH:
+                return scripts.count(CScriptID(uint160(vSolutions[0]))) != 0;
+            case TX_MULTISIG:
+                // IsMine() wants all the keys; any one will do here
+                for (size_t i = 1; i + 1 < vSolutions.size(); ++i) {
+                    if (keys.count(CPubKey(vSolutions[i]).GetID())) {
+                        return true;
+                    }
+                }
+                return false;
+            default:
+                return false;
+        }
+    }
+
+    // extraTxids are the transactions matched earlier in the same block
+    bool Matches(const CTransaction &tx,
+                 const std::set<uint256> &extraTxids) const {
+        if (IsKnownTx(tx.GetId(), extraTxids)) {
+            return true;
+        }
+        for (const CTxIn &txin : tx.vin) {
+            if (IsKnownTx(txin.prevout.GetTxId(), extraTxids) ||
+                spends.count(txin.prevout)) {
+                return true;
+            }
+        }
+        for (const CTxOut &txout : tx.vout) {
+            if (MightBeMine(txout.scriptPubKey)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+void CWallet::InitScanFilter(CWalletScanFilter &filter) const {
+    AssertLockHeld(cs_wallet);
+    GetKeys(filter.keys);
+    {
+        LOCK(cs_KeyStore);
+        for (const auto &script : mapScripts) {
+            filter.scripts.insert(script.first);
+        }
+        filter.watchOnly = setWatchOnly;
+    }
+    for (const auto &wtx : mapWallet) {
+        filter.txids.insert(wtx.first);
+    }
+    for (const auto &spend : mapTxSpends) {
+        filter.spends.insert(spend.first);
+    }
+}
+
+namespace {
+
+/** Transactions of one block that a rescan picked out for the wallet */
+struct CScannedBlock {
+    bool fRead {false};
+    size_t nTx {0};
+    std::vector<std::pair<int, CTransactionRef>> vMatches {};
+};
+
+CScannedBlock ScanBlockForWallet(const CWalletScanFilter &filter,
+                                 const CDiskBlockPos &pos) {
+    CScannedBlock scanned;
+    auto stream = GetDiskBlockStreamReader(pos);
+    if (!stream) {
+        return scanned;
+    }
+    scanned.fRead = true;
+    std::set<uint256> matchedTxids;
+    int posInBlock = 0;
+    do {
+        const CTransaction &transaction = stream->ReadTransaction();
+        if (filter.Matches(transaction, matchedTxids)) {
+            matchedTxids.insert(transaction.GetId());
+            scanned.vMatches.emplace_back(posInBlock,
+                                          MakeTransactionRef(transaction));
+        }
+        ++posInBlock;
+    } while (!stream->EndOfStream());
+    scanned.nTx = posInBlock;
+    return scanned;
+}
+
+} // namespace
+
 /**
  * Scan the block chain (starting in pindexStart) for transactions from or to
  * us. If fUpdate is true, found transactions that already exist in the wallet
  * will be updated.
  *
+ * Blocks are read and matched against a snapshot of the wallet's keys, scripts,
+ * transactions and spent outputs in parallel, in batches, on a thread pool of
+ * the rescan's own and without holding any lock. Only the matches are then
+ * added to the wallet, in chain order, under cs_main and cs_wallet, and only
+ * for blocks still in the active chain. If a block adds a new transaction to
+ * the wallet, the rest of its batch is matched again so that transactions
+ * spending it or conflicting with it are not missed.
+ *
  * Returns pointer to the first block in the last contiguous range that was
  * successfully scanned or elided (elided if pIndexStart points at a block
  * before CWallet::nTimeFirstKey). Returns null if there is no such range, or
@@ -1711,52 +1903,123 @@ void CWalletTx::GetAmounts(std::list<COutputEntry> &listReceived,
  */
 CBlockIndex *CWallet::ScanForWalletTransactions(CBlockIndex *pindexStart,
                                                 bool fUpdate) {
-    LOCK2(cs_main, cs_wallet);
+    CBlockIndex *ret = pindexStart;
 
+    std::vector<std::pair<CBlockIndex *, CDiskBlockPos>> vBlocks;
+    CWalletScanFilter filter;
+    {
+        LOCK2(cs_main, cs_wallet);
+
+        // No need to read and scan block, if block was created before our
+        // wallet birthday (as adjusted for block time variability)
+        CBlockIndex *pindex = pindexStart;
+        while (pindex && nTimeFirstKey &&
+               (pindex->GetBlockTime() < (nTimeFirstKey - 7200))) {
+            pindex = chainActive.Next(pindex);
+        }
+        for (; pindex; pindex = chainActive.Next(pindex)) {
+            vBlocks.emplace_back(pindex, pindex->GetBlockPos());
+        }
+
+        InitScanFilter(filter);
+    }
+
+    // Reading blocks can take hours; keep it off the shared parallel task pool
+    CThreadPool<CQueueAdaptor> pool {"WalletRescanPool",
+                                     std::max<size_t>(1, GetNumCores())};
+    const size_t nBatchSize = 4 * pool.getPoolSize();
+    const int64_t nStart = GetTimeMillis();
     int64_t nNow = GetTime();
+    size_t nTxScanned = 0;
+
+    for (size_t nBatchStart = 0; nBatchStart < vBlocks.size();
+         nBatchStart += nBatchSize) {
+        const size_t nBatchEnd =
+            std::min(vBlocks.size(), nBatchStart + nBatchSize);
+        const std::vector<std::vector<CScannedBlock>> vChunks =
+            parallel_for_chunks(
+                pool, nBatchEnd - nBatchStart, 1, pool.getPoolSize(),
+                [&](size_t begin, size_t end) {
+                    std::vector<CScannedBlock> chunk;
+                    for (size_t i = nBatchStart + begin;
+                         i < nBatchStart + end; ++i) {
+                        chunk.emplace_back(
+                            ScanBlockForWallet(filter, vBlocks[i].second));
+                    }
+                    return chunk;
+                });
+
+        size_t nBlock = nBatchStart;
+        bool fFilterChanged = false;
+        for (const std::vector<CScannedBlock> &chunk : vChunks) {
+            for (const CScannedBlock &batchScanned : chunk) {
+                CBlockIndex *pindex = vBlocks[nBlock].first;
+                // Blocks after one that added to the wallet were matched
+                // without knowing about its transactions
+                const CScannedBlock scanned {
+                    fFilterChanged
+                        ? ScanBlockForWallet(filter, vBlocks[nBlock].second)
+                        : batchScanned};
+                ++nBlock;
+
+                if (!scanned.fRead) {
+                    ret = nullptr;
+                    continue;
+                }
+                nTxScanned += scanned.nTx;
+
+                if (!scanned.vMatches.empty()) {
+                    LOCK2(cs_main, cs_wallet);
+                    // The block may have been disconnected since vBlocks was
+                    // taken; its replacement reaches the wallet as a
+                    // connected block.
+                    if (!chainActive.Contains(pindex)) {
+                        ret = nullptr;
+                        continue;
+                    }
+                    for (const auto &match : scanned.vMatches) {
+                        if (!AddToWalletIfInvolvingMe(match.second, pindex,
+                                                      match.first, fUpdate)) {
+                            continue;
+                        }
+                        if (filter.txids.insert(match.second->GetId())
+                                .second) {
+                            fFilterChanged = true;
+                        }
+                        for (const CTxIn &txin : match.second->vin) {
+                            if (filter.spends.insert(txin.prevout).second) {
+                                fFilterChanged = true;
+                            }
+                        }
+                    }
+                }
 
-    CBlockIndex *pindex = pindexStart;
-    CBlockIndex *ret = pindexStart;
+                if (!ret) {
+                    ret = pindex;
+                }
 
-    // No need to read and scan block, if block was created before our wallet
-    // birthday (as adjusted for block time variability)
-    while (pindex && nTimeFirstKey &&
-           (pindex->GetBlockTime() < (nTimeFirstKey - 7200))) {
-        pindex = chainActive.Next(pindex);
-    }
-
-    while (pindex) {
-        
-        auto stream = GetDiskBlockStreamReader(pindex->GetBlockPos());
-
-        if (stream)
-        {
-            int posInBlock = 0;
-            do
-            {
-                const CTransaction& transaction = stream->ReadTransaction();
-                AddToWalletIfInvolvingMe(
-                    MakeTransactionRef(transaction),
-                    pindex,
-                    posInBlock,
-                    fUpdate);
-                ++posInBlock;
-            } while(!stream->EndOfStream());
-
-            if (!ret) {
-                ret = pindex;
+                if (GetTime() >= nNow + 60) {
+                    nNow = GetTime();
+                    const double nSeconds =
+                        std::max<int64_t>(1, GetTimeMillis() - nStart) /
+                        1000.0;
+                    LOCK(cs_main);
+                    LogPrintf("Still rescanning. At block %d. Progress=%f "
+                              "(%.1f blocks/s, %.1f tx/s)\n",
+                              pindex->nHeight,
+                              GuessVerificationProgress(chainParams.TxData(),
+                                                        pindex),
+                              nBlock / nSeconds,
+                              nTxScanned / nSeconds);
+                }
             }
-        } else {
-            ret = nullptr;
         }
+    }
 
-        pindex = chainActive.Next(pindex);
-        if (GetTime() >= nNow + 60) {
-            nNow = GetTime();
-            LogPrintf("Still rescanning. At block %d. Progress=%f\n",
-                      pindex->nHeight,
-                      GuessVerificationProgress(chainParams.TxData(), pindex));
-        }
+    if (!vBlocks.empty()) {
+        LogPrintf("Rescanned %u blocks (%u transactions) in %.1fs\n",
+                  vBlocks.size(), nTxScanned,
+                  (GetTimeMillis() - nStart) / 1000.0);
     }
 
     return ret;
@@ -2119,9 +2382,9 @@ Amount CWallet::GetBalance() const {
     LOCK2(cs_main, cs_wallet);
 
     Amount nTotal(0);
-    for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin();
-         it != mapWallet.end(); ++it) {
-        const CWalletTx *pcoin = &(*it).second;
+    for (const std::pair<const uint256, const CWalletTx *> &item :
+         mapUnspentTx) {
+        const CWalletTx *pcoin = item.second;
         if (pcoin->IsTrusted()) {
             nTotal += pcoin->GetAvailableCredit();
         }
@@ -2134,9 +2397,9 @@ Amount CWallet::GetUnconfirmedBalance() const {
     LOCK2(cs_main, cs_wallet);
 
     Amount nTotal(0);
-    for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin();
-         it != mapWallet.end(); ++it) {
-        const CWalletTx *pcoin = &(*it).second;
+    for (const std::pair<const uint256, const CWalletTx *> &item :
+         mapUnspentTx) {
+        const CWalletTx *pcoin = item.second;
         if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 &&
             pcoin->InMempool()) {
             nTotal += pcoin->GetAvailableCredit();
@@ -2150,9 +2413,9 @@ Amount CWallet::GetImmatureBalance() const {
     LOCK2(cs_main, cs_wallet);
 
     Amount nTotal(0);
-    for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin();
-         it != mapWallet.end(); ++it) {
-        const CWalletTx *pcoin = &(*it).second;
+    for (const std::pair<const uint256, const CWalletTx *> &item :
+         mapUnspentTx) {
+        const CWalletTx *pcoin = item.second;
         nTotal += pcoin->GetImmatureCredit();
     }
 
@@ -2163,9 +2426,9 @@ Amount CWallet::GetWatchOnlyBalance() const {
     LOCK2(cs_main, cs_wallet);
 
     Amount nTotal(0);
-    for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin();
-         it != mapWallet.end(); ++it) {
-        const CWalletTx *pcoin = &(*it).second;
+    for (const std::pair<const uint256, const CWalletTx *> &item :
+         mapUnspentTx) {
+        const CWalletTx *pcoin = item.second;
         if (pcoin->IsTrusted()) {
             nTotal += pcoin->GetAvailableWatchOnlyCredit();
         }
@@ -2178,9 +2441,9 @@ Amount CWallet::GetUnconfirmedWatchOnlyBalance() const {
     LOCK2(cs_main, cs_wallet);
 
     Amount nTotal(0);
-    for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin();
-         it != mapWallet.end(); ++it) {
-        const CWalletTx *pcoin = &(*it).second;
+    for (const std::pair<const uint256, const CWalletTx *> &item :
+         mapUnspentTx) {
+        const CWalletTx *pcoin = item.second;
         if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 &&
             pcoin->InMempool()) {
             nTotal += pcoin->GetAvailableWatchOnlyCredit();
@@ -2194,9 +2457,9 @@ Amount CWallet::GetImmatureWatchOnlyBalance() const {
     LOCK2(cs_main, cs_wallet);
 
     Amount nTotal(0);
-    for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin();
-         it != mapWallet.end(); ++it) {
-        const CWalletTx *pcoin = &(*it).second;
+    for (const std::pair<const uint256, const CWalletTx *> &item :
+         mapUnspentTx) {
+        const CWalletTx *pcoin = item.second;
         nTotal += pcoin->GetImmatureWatchOnlyCredit();
     }
 
@@ -2259,10 +2522,10 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe,
     vCoins.clear();
 
     LOCK2(cs_main, cs_wallet);
-    for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin();
-         it != mapWallet.end(); ++it) {
-        const uint256 &wtxid = it->first;
-        const CWalletTx *pcoin = &(*it).second;
+    for (const std::pair<const uint256, const CWalletTx *> &item :
+         mapUnspentTx) {
+        const uint256 &wtxid = item.first;
+        const CWalletTx *pcoin = item.second;
 
         if (!CheckFinalTx(
                *pcoin,
@@ -2316,11 +2579,11 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe,
         for (unsigned int i = 0; i < pcoin->tx->vout.size(); i++) {
             isminetype mine = IsMine(pcoin->tx->vout[i]);
             if (!(IsSpent(wtxid, i)) && mine != ISMINE_NO &&
-                !IsLockedCoin((*it).first, i) &&
+                !IsLockedCoin(wtxid, i) &&
                 (pcoin->tx->vout[i].nValue > Amount(0) || fIncludeZeroValue) &&
                 (!coinControl || !coinControl->HasSelected() ||
                  coinControl->fAllowOtherInputs ||
-                 coinControl->IsSelected(COutPoint((*it).first, i)))) {
+                 coinControl->IsSelected(COutPoint(wtxid, i)))) {
                 vCoins.push_back(COutput(
                     pcoin, i, nDepth,
                     ((mine & ISMINE_SPENDABLE) != ISMINE_NO) ||
@@ -3180,6 +3443,13 @@ DBErrors CWallet::LoadWallet(bool &fFirstRunRet) {
         return nLoadWalletRet;
     }
 
+    {
+        // Watch-only scripts may be loaded after the transactions paying to
+        // them, so the index can only be built once everything is loaded.
+        LOCK(cs_wallet);
+        RebuildUnspentIndex();
+    }
+
     uiInterface.LoadWallet(this);
 
     return DB_LOAD_OK;
@@ -3192,6 +3462,7 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256> &vHashIn,
         CWalletDB(*dbw, "cr+").ZapSelectTx(vHashIn, vHashOut);
     for (uint256 hash : vHashOut) {
         mapWallet.erase(hash);
+        mapUnspentTx.erase(hash);
     }
 
     if (nZapSelectTxRet == DB_NEED_REWRITE) {
@@ -586,6 +586,8 @@ private:
     std::vector<char> _ssExtra;
 };
 
+struct CWalletScanFilter;
+
 /**
  * A CWallet is an extension of a keystore, which also maintains a set of
  * transactions and balances, and provides the ability to create new
@@ -635,6 +637,16 @@ private:
 
     void SyncMetaData(std::pair<TxSpends::iterator, TxSpends::iterator>);
 
+    /**
+     * Wallet transactions that may still have unspent outputs of ours, so
+     * balances and coin selection don't have to visit every transaction in
+     * mapWallet. Kept up to date as transactions are added, spent, abandoned
+     * or conflicted, and rebuilt when the set of keys or scripts changes.
+     */
+    std::map<uint256, const CWalletTx *> mapUnspentTx;
+    void UpdateUnspentIndex(const uint256 &hash);
+    void RebuildUnspentIndex();
+
     /**
      * Used by TransactionAddedToMemorypool/BlockConnected/Disconnected.
      * Should be called with pindexBlock and posInBlock if this is for a
@@ -675,6 +687,9 @@ private:
     // the next block comes in
     uint256 hashPrevBestCoinbase;
 
+    /* Snapshot what a rescan needs to find this wallet's transactions */
+    void InitScanFilter(CWalletScanFilter &filter) const;
+
 public:
     const CChainParams &chainParams;
     /*
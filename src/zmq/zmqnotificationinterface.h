@@ -24,6 +24,10 @@ protected:
     void Shutdown();
 
     // CValidationInterface
+    // Notifications are published from a queue of their own, so a slow
+    // publisher doesn't hold up validation; subscribers can detect dropped
+    // ones from the sequence numbers.
+    bool IsSynchronous() const override { return false; }
     void TransactionAddedToMempool(const CTransactionRef &tx) override;
     void
     BlockConnected(const std::shared_ptr<const CBlock> &pblock,
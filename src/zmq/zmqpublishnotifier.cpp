@@ -3,13 +3,13 @@
 // Distributed under the Open BSV software license, see the accompanying file LICENSE.
 
 #include "zmqpublishnotifier.h"
-#include "config.h"
 #include "rpc/server.h"
 #include "streams.h"
 #include "util.h"
 #include "validation.h"
 
 #include <cstdarg>
+#include <vector>
 
 static std::multimap<std::string, CZMQAbstractPublishNotifier *>
     mapPublishNotifiers;
@@ -54,6 +54,30 @@ static int zmq_send_multipart(void *sock, const void *data, size_t size, ...) {
     return 0;
 }
 
+// Internal function to send a single part of a multipart message
+static int zmq_send_part(void *sock, const void *data, size_t size,
+                         bool fMore) {
+    zmq_msg_t msg;
+
+    int rc = zmq_msg_init_size(&msg, size);
+    if (rc != 0) {
+        zmqError("Unable to initialize ZMQ msg");
+        return -1;
+    }
+
+    memcpy(zmq_msg_data(&msg), data, size);
+
+    rc = zmq_msg_send(&msg, sock, fMore ? ZMQ_SNDMORE : 0);
+    if (rc == -1) {
+        zmqError("Unable to send ZMQ msg");
+        zmq_msg_close(&msg);
+        return -1;
+    }
+
+    zmq_msg_close(&msg);
+    return 0;
+}
+
 bool CZMQAbstractPublishNotifier::Initialize(void *pcontext) {
     assert(!psocket);
 
@@ -134,6 +158,53 @@ bool CZMQAbstractPublishNotifier::SendMessage(const char *command,
     return true;
 }
 
+bool CZMQAbstractPublishNotifier::SendStreamMessage(
+    const char *command, CForwardReadonlyStream &stream) {
+    assert(psocket);
+
+    if (zmq_send_part(psocket, command, strlen(command), true) == -1) {
+        return false;
+    }
+
+    /* send the data in parts of STREAM_CHUNK_SIZE bytes (the last one may be
+       shorter) */
+    bool fReadOk = true;
+    std::vector<uint8_t> chunk;
+    chunk.reserve(STREAM_CHUNK_SIZE);
+    try {
+        do {
+            CSpan span = stream.Read(STREAM_CHUNK_SIZE - chunk.size());
+            chunk.insert(chunk.end(), span.Begin(), span.Begin() + span.Size());
+            if (chunk.size() == STREAM_CHUNK_SIZE ||
+                (stream.EndOfStream() && !chunk.empty())) {
+                if (zmq_send_part(psocket, chunk.data(), chunk.size(), true) ==
+                    -1) {
+                    return false;
+                }
+                chunk.clear();
+            }
+        } while (!stream.EndOfStream());
+    } catch (const std::exception &e) {
+        // Parts that were already sent can't be taken back, so the message
+        // still has to be completed below.
+        zmqError(strprintf("Unable to read %s data: %s", command, e.what())
+                     .c_str());
+        fReadOk = false;
+    }
+
+    /* the sequence number is always the last part */
+    uint8_t msgseq[sizeof(uint32_t)];
+    WriteLE32(&msgseq[0], nSequence);
+    if (zmq_send_part(psocket, msgseq, sizeof(uint32_t), false) == -1) {
+        return false;
+    }
+
+    /* increment memory only sequence number after sending */
+    nSequence++;
+
+    return fReadOk;
+}
+
 bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex) {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashblock %s\n", hash.GetHex());
@@ -157,20 +228,19 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex) {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s\n",
              pindex->GetBlockHash().GetHex());
 
-    const Config &config = GlobalConfig::GetConfig();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
+    // Only opening the stream needs cs_main, the block data on disk doesn't
+    // change once it is written.
+    std::unique_ptr<CForwardReadonlyStream> stream;
     {
         LOCK(cs_main);
-        CBlock block;
-        if (!ReadBlockFromDisk(block, pindex, config)) {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
+        stream = StreamSyncBlockFromDisk(*pindex);
+    }
+    if (!stream) {
+        zmqError("Can't read block from disk");
+        return false;
     }
 
-    return SendMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    return SendStreamMessage(MSG_RAWBLOCK, *stream);
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(
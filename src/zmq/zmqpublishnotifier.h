@@ -7,7 +7,10 @@
 
 #include "zmqabstractnotifier.h"
 
+#include <cstddef>
+
 class CBlockIndex;
+class CForwardReadonlyStream;
 
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier {
 private:
@@ -23,6 +26,16 @@ public:
     */
     bool SendMessage(const char *command, const void *data, size_t size);
 
+    /* send zmq multipart message with the data read from a stream
+       parts:
+          * command
+          * data in one or more parts of up to STREAM_CHUNK_SIZE bytes
+          * message sequence number
+    */
+    bool SendStreamMessage(const char *command, CForwardReadonlyStream &stream);
+
+    static constexpr size_t STREAM_CHUNK_SIZE = 1024 * 1024;
+
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
 };
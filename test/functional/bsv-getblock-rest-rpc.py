@@ -124,5 +124,18 @@ class BSVGetBlock(ComparisonTestFramework):
         assert_equal(batch[3]["result"], None)
         assert_equal(batch[3]["error"]["message"], "Method not found")
 
+        #side effect free commands in a batch run concurrently, but replies
+        #keep the request order
+        height = self.nodes[0].getblockcount()
+        requests = [self.nodes[0].getblockhash.get_request(h) for h in range(height + 1)]
+        requests.append(self.nodes[0].getblockhash.get_request(height + 1))
+        requests.append(self.nodes[0].getblockcount.get_request())
+        batch = self.nodes[0].batch(requests)
+        for h in range(height + 1):
+            assert_equal(batch[h]["error"], None)
+            assert_equal(batch[h]["result"], self.nodes[0].getblockhash(h))
+        assert_equal(batch[height + 1]["error"]["message"], "Block height out of range")
+        assert_equal(batch[height + 2]["result"], height)
+
 if __name__ == '__main__':
     BSVGetBlock().main()
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+# Copyright (c) 2019 Bitcoin Association
+# Distributed under the Open BSV software license, see the accompanying file LICENSE.
+"""
+Test the getrawtransactions RPC.
+
+Node 0 runs without a transaction index and node 1 with -txindex. Both find
+mempool transactions; only node 1 finds transactions that are in blocks.
+Missing transactions are returned as null, in the order they were asked for.
+"""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error, connect_nodes
+
+
+class GetRawTransactionsTest(BitcoinTestFramework):
+
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.setup_clean_chain = True
+        self.extra_args = [[], ["-txindex"]]
+
+    def setup_network(self):
+        self.setup_nodes()
+        connect_nodes(self.nodes[0], 1)
+        self.sync_all()
+
+    def run_test(self):
+        self.nodes[0].generate(101)
+        self.sync_all()
+
+        missing = "00" * 32
+        txid = self.nodes[0].sendtoaddress(self.nodes[1].getnewaddress(), 1)
+        self.sync_all()
+
+        # Mempool transactions are found with and without the txindex
+        for node in self.nodes:
+            result = node.getrawtransactions([missing, txid])
+            assert_equal(result, [None, node.getrawtransaction(txid)])
+            verbose = node.getrawtransactions([txid, missing], True)
+            assert_equal(verbose[0]["txid"], txid)
+            assert("blockhash" not in verbose[0])
+            assert_equal(verbose[1], None)
+
+        blockhash = self.nodes[0].generate(1)[0]
+        self.sync_all()
+        coinbase = self.nodes[0].getblock(blockhash)["tx"][0]
+
+        # Only the node with the txindex finds transactions in blocks
+        assert_equal(self.nodes[0].getrawtransactions([txid, coinbase, missing]),
+                     [None, None, None])
+
+        result = self.nodes[1].getrawtransactions([coinbase, missing, txid, txid])
+        assert_equal(result, [self.nodes[1].getrawtransaction(coinbase), None,
+                              self.nodes[1].getrawtransaction(txid),
+                              self.nodes[1].getrawtransaction(txid)])
+        verbose = self.nodes[1].getrawtransactions([txid, missing, coinbase], True)
+        assert_equal([entry["txid"] if entry else None for entry in verbose],
+                     [txid, None, coinbase])
+        assert_equal(verbose[0]["blockhash"], blockhash)
+        assert_equal(verbose[2]["blockhash"], blockhash)
+        assert_equal(verbose[0]["hex"], result[2])
+
+        assert_equal(self.nodes[1].getrawtransactions([]), [])
+        assert_raises_rpc_error(-8, "txid must be hexadecimal string",
+                                self.nodes[1].getrawtransactions, ["foo"])
+
+
+if __name__ == '__main__':
+    GetRawTransactionsTest().main()
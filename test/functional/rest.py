@@ -56,6 +56,7 @@ class RESTTest (BitcoinTestFramework):
     def set_test_params(self):
         self.setup_clean_chain = True
         self.num_nodes = 3
+        self.extra_args = [["-maxgetutxosoutpoints=15"], [], []]
 
     def setup_network(self, split=False):
         super().setup_network()
@@ -228,6 +229,19 @@ class RESTTest (BitcoinTestFramework):
         assert_equal(response.status, 200)
         # must be a 200 because we are within the limits
 
+        # the same limit applies to the gettxouts RPC, which resolves the
+        # outpoints in one batch and keeps their order
+        outpoints = [{"txid": txid, "n": n}] * 15
+        txouts = self.nodes[0].gettxouts(outpoints)
+        assert_equal(txouts["bestblock"], self.nodes[0].getbestblockhash())
+        assert_equal(len(txouts["txouts"]), 15)
+        assert_equal(txouts["txouts"][0], txouts["txouts"][14])
+        assert_equal(txouts["txouts"][0]["value"],
+                     self.nodes[0].gettxout(txid, n)["value"])
+        assert_equal(self.nodes[0].gettxouts(outpoints, False)["txouts"][0], None)
+        assert_raises_rpc_error(-8, "Too many outpoints",
+                                self.nodes[0].gettxouts, outpoints + [{"txid": txid, "n": n}])
+
         self.nodes[0].generate(
             1)  # generate block to not affect upcoming tests
         self.sync_all()
@@ -360,6 +374,26 @@ class RESTTest (BitcoinTestFramework):
         for tx in txs:
             assert_equal(tx in json_obj, True)
 
+        # the binary format has one fixed size record per TX:
+        # txid, fee, size, time, ancestor count, ancestor size, ancestor fees
+        response = http_get_call(
+            url.hostname, url.port, '/rest/mempool/contents' + self.FORMAT_SEPARATOR + 'bin', True)
+        assert_equal(response.status, 200)
+        bin_contents = response.read()
+        record_size = 32 + 6 * 8
+        assert_equal(len(bin_contents), len(json_obj) * record_size)
+        for pos in range(0, len(bin_contents), record_size):
+            txid = encode(bin_contents[pos:pos + 32][::-1], "hex_codec").decode("ascii")
+            fee, size, time, ancestorcount, ancestorsize, ancestorfees = unpack(
+                "<qQqQQq", bin_contents[pos + 32:pos + record_size])
+            entry = json_obj[txid]
+            assert_equal(fee, int(round(entry['fee'] * 100000000)))
+            assert_equal(size, entry['size'])
+            assert_equal(time, entry['time'])
+            assert_equal(ancestorcount, entry['ancestorcount'])
+            assert_equal(ancestorsize, entry['ancestorsize'])
+            assert_equal(ancestorfees, entry['ancestorfees'])
+
         # now mine the transactions
         newblockhash = self.nodes[1].generate(1)
         self.sync_all()